@@ -1,35 +1,187 @@
 #include "cli_utilities.h"
 #include <cstring>
-
-PsiData * allocateDataFromFile ( std::string fname, int nafc ) {
-	std::fstream infile ( fname.c_str() );
-	std::list<std::string> inputlines;
-	char line[100];
-	unsigned int i;
-	std::list<std::string>::iterator inputlines_i;
-	
-	while ( !infile.eof() ) {
-		infile.getline ( line, 100 );
-		if (strlen(line)>0)
-			inputlines.push_back ( std::string ( line ) );
+#include <cctype>
+#include <map>
+
+/* Data of a single session while the file is read */
+struct SessionData {
+	std::vector<double> x;
+	std::vector<int> k;
+	std::vector<int> n;
+	std::map<double,unsigned int> blocks;    // block of each stimulus intensity in trial-by-trial files
+};
+
+/* Find the end of the field that starts at p, *next is the start of the following field (NULL at the end of the line) */
+static const char * splitfield ( const char * p, char delimiter, const char ** next ) {
+	const char * end ( p );
+	if ( delimiter==' ' ) {
+		// Fields are separated by any amount of white space
+		while ( *end!='\0' && *end!='\n' && *end!='\r' && *end!=' ' && *end!='\t' ) end++;
+		*next = end;
+		while ( **next==' ' || **next=='\t' || **next=='\r' ) (*next)++;
+		if ( **next=='\n' || **next=='\0' ) *next = NULL;
+	} else {
+		// Fields are separated by exactly one delimiter, white space around the fields is ignored
+		while ( *end!='\0' && *end!='\n' && *end!=delimiter ) end++;
+		*next = NULL;
+		if ( *end==delimiter ) {
+			*next = end+1;
+			while ( **next==' ' || (**next=='\t' && delimiter!='\t') ) (*next)++;
+		}
+		while ( end>p && ( end[-1]==' ' || end[-1]=='\t' || end[-1]=='\r' ) ) end--;
 	}
+	return end;
+}
+
+static std::string number ( unsigned int i ) {
+	char s[20];
+	sprintf ( s, "%u", i );
+	return std::string ( s );
+}
+
+static std::string fileposition ( const std::string& fname, unsigned int lineno ) {
+	return fname + ":" + number ( lineno ) + ": ";
+}
+
+static const char * nextline ( const char * p ) {
+	while ( *p!='\n' && *p!='\0' ) p++;
+	return *p=='\n' ? p+1 : p;
+}
+
+std::vector<PsiData*> allocateDatasetsFromFile ( std::string fname, int nafc, std::vector<std::string> * sessions ) {
+	// Read the whole file at once, lines are parsed in place
+	FILE * infile ( fopen ( fname.c_str(), "rb" ) );
+	if ( infile==NULL )
+		throw PsiInputError ( "Could not open data file '" + fname + "'" );
+	std::vector<char> buffer;
+	char chunk[65536];
+	size_t nread;
+	while ( (nread=fread ( chunk, 1, sizeof(chunk), infile )) > 0 )
+		buffer.insert ( buffer.end(), chunk, chunk+nread );
+	fclose ( infile );
+	buffer.push_back ( '\0' );
+
+	// Columns of stimulus intensity, correct responses, trials and session (-1 if not present)
+	int xcol(0), kcol(1), ncol(2), sessioncol(-1), col;
+	bool first(true);
+	char delimiter(' ');
+	std::vector<SessionData> data;
+	std::map<std::string,unsigned int> sessionindex;
+	std::map<std::string,unsigned int>::iterator sessionpos;
+	std::map<double,unsigned int>::iterator blockpos;
+	std::string session, name;
+	double values[3];
+	unsigned int lineno(0), block, s;
+	const char *p ( &(buffer[0]) ), *field, *end, *next;
+	char *numberend;
+
+	sessions->clear();
+	for ( ; *p!='\0'; p=nextline ( p ) ) {
+		lineno++;
+		while ( *p==' ' || *p=='\t' || *p=='\r' ) p++;
+		if ( *p=='\n' || *p=='#' || *p=='\0' )
+			continue;
+
+		if ( first ) {
+			// The first line determines delimiter and columns
+			first = false;
+			for ( field=p; *field!='\n' && *field!='\0' && delimiter!=','; field++ )
+				if ( *field==',' || *field=='\t' ) delimiter = *field;
+			strtod ( p, &numberend );
+			if ( numberend==p ) {
+				// Header line: columns are identified by name
+				xcol = kcol = ncol = -1;
+				for ( field=p, col=0; field!=NULL; col++ ) {
+					end = splitfield ( field, delimiter, &next );
+					name = std::string ( field, end );
+					for ( s=0; s<name.size(); s++ ) name[s] = tolower ( name[s] );
+					if ( name=="x" || name=="intensity" || name=="stimulus" ) xcol = col;
+					else if ( name=="k" || name=="correct" || name=="response" ) kcol = col;
+					else if ( name=="n" || name=="trials" || name=="ntrials" ) ncol = col;
+					else if ( name=="session" ) sessioncol = col;
+					field = next;
+				}
+				if ( xcol<0 || kcol<0 )
+					throw PsiInputError ( fileposition ( fname, lineno ) + "header needs columns 'x' and 'k'" );
+				continue;
+			}
+			for ( field=p, col=0; field!=NULL; col++ )
+				splitfield ( field, delimiter, &field );
+			if ( col==2 ) ncol = -1;    // Two columns: one trial per line
+		}
 
-	std::vector<double> x ( inputlines.size() );
-	std::vector<int>    k ( inputlines.size() );
-	std::vector<int>    n ( inputlines.size() );
-	double xx,kk,nn;
-
-	for ( i=0, inputlines_i=inputlines.begin(); inputlines_i != inputlines.end(); inputlines_i++, i++ ) {
-		sscanf ( (*inputlines_i).c_str(), "%lf %lf %lf\n", &xx,&kk,&nn );
-		if ( kk<1 ) kk *= nn;
-		if ( kk != round(kk) ) std::cerr << "Warning: number of correct trials is " << kk << " and not an integer\n";
-		x[i] = xx;
-		k[i] = kk;
-		n[i] = nn;
-		if ( nn < kk ) std::cerr << "Warning: number of correct trials is larger than the total number of trials!\n";
+		// Parse the fields of the line, numbers are read directly from the buffer
+		values[0] = values[1] = values[2] = 0;
+		session = "";
+		for ( field=p, col=0; field!=NULL; col++ ) {
+			end = splitfield ( field, delimiter, &next );
+			if ( col==sessioncol ) {
+				session = std::string ( field, end );
+			} else if ( col==xcol || col==kcol || col==ncol ) {
+				values[ col==xcol ? 0 : ( col==kcol ? 1 : 2 ) ] = strtod ( field, &numberend );
+				// The whole field has to be a number, "1.5abc" is an error and not 1.5
+				if ( numberend==field || numberend!=end )
+					throw PsiInputError ( fileposition ( fname, lineno ) + "could not read number in column " + number ( col+1 ) );
+			}
+			field = next;
+		}
+		if ( col<=std::max ( std::max ( xcol, kcol ), std::max ( ncol, sessioncol ) ) )
+			throw PsiInputError ( fileposition ( fname, lineno ) + "missing columns" );
+
+		// Store in the data set of the session
+		sessionpos = sessionindex.find ( session );
+		if ( sessionpos==sessionindex.end() ) {
+			sessionpos = sessionindex.insert ( std::make_pair ( session, (unsigned int)data.size() ) ).first;
+			data.push_back ( SessionData () );
+			sessions->push_back ( session );
+		}
+		SessionData& sessiondata ( data[sessionpos->second] );
+		if ( ncol<0 ) {
+			// One trial per line: trials with the same stimulus intensity form a block
+			blockpos = sessiondata.blocks.find ( values[0] );
+			if ( blockpos==sessiondata.blocks.end() ) {
+				blockpos = sessiondata.blocks.insert ( std::make_pair ( values[0], (unsigned int)sessiondata.x.size() ) ).first;
+				sessiondata.x.push_back ( values[0] );
+				sessiondata.k.push_back ( 0 );
+				sessiondata.n.push_back ( 0 );
+			}
+			block = blockpos->second;
+			sessiondata.k[block] += values[1]>0;
+			sessiondata.n[block] ++;
+		} else {
+			if ( values[1]<1 ) values[1] *= values[2];
+			if ( values[1] != round(values[1]) ) std::cerr << "Warning: number of correct trials is " << values[1] << " and not an integer\n";
+			if ( values[2] < values[1] ) std::cerr << "Warning: number of correct trials is larger than the total number of trials!\n";
+			sessiondata.x.push_back ( values[0] );
+			sessiondata.k.push_back ( values[1] );
+			sessiondata.n.push_back ( values[2] );
+		}
 	}
 
-	return new PsiData ( x, n, k, nafc );
+	std::vector<PsiData*> out ( data.size() );
+	for ( s=0; s<data.size(); s++ )
+		out[s] = new PsiData ( data[s].x, data[s].n, data[s].k, nafc );
+	return out;
+}
+
+PsiData * allocateDataFromFile ( std::string fname, int nafc, std::string session ) {
+	std::vector<std::string> sessions;
+	std::vector<PsiData*> data ( allocateDatasetsFromFile ( fname, nafc, &sessions ) );
+	PsiData * out ( NULL );
+	unsigned int i;
+
+	if ( session=="" && sessions.size()>1 ) {
+		for ( i=0; i<data.size(); i++ )
+			delete data[i];
+		throw PsiInputError ( "Data file '" + fname + "' contains " + number ( sessions.size() ) + " sessions, please select one" );
+	}
+	for ( i=0; i<data.size(); i++ ) {
+		if ( session=="" || sessions[i]==session ) out = data[i];
+		else delete data[i];
+	}
+	if ( out==NULL )
+		throw PsiInputError ( "No data for session '" + session + "' in '" + fname + "'" );
+	return out;
 }
 
 PsiPsychometric * allocatePsychometric ( std::string core, std::string sigmoid, int nafc, PsiData* data, bool verbose=false ) {
@@ -59,8 +211,7 @@ PsiPsychometric * allocatePsychometric ( std::string core, std::string sigmoid,
 		if (verbose) std::cerr <<  PsiLogistic::getDescriptor();
 		psisigmoid = new PsiLogistic();
 	} else {
-		std::cerr << "Unknown sigmoid " << sigmoid << "\n";
-		exit ( -1 );
+		throw PsiInputError ( "Unknown sigmoid " + sigmoid );
 	}
 
 	if ( verbose ) std::cerr << ",";
@@ -85,8 +236,8 @@ PsiPsychometric * allocatePsychometric ( std::string core, std::string sigmoid,
 		if (verbose) std::cerr << weibullCore::getDescriptor();
 		psicore = new weibullCore ( data );
 	} else {
-		std::cerr << "Unknown core " << sigmoid << "\n";
-		exit ( -1 );
+		delete psisigmoid;
+		throw PsiInputError ( "Unknown core " + core );
 	}
 
 	if ( verbose ) std::cerr << ") ";
@@ -121,8 +272,7 @@ PsiPrior * allocatePrior ( std::string prior ) {
 	} else if ( !prior.compare ( "None" ) ) {
 		psiprior = NULL;
 	} else {
-		std::cerr << "Unknown prior: " << prior << "\n";
-		exit ( -1 );
+		throw PsiInputError ( "Unknown prior: " + prior );
 	}
 
 	return psiprior;
@@ -174,6 +324,28 @@ std::vector<double> getCuts ( std::string cuts ) {
 	return out;
 }
 
+PsiMCFileHeader describeAnalysis ( std::string core, std::string sigmoid, int nafc, const PsiPsychometric * pmf,
+		std::string prior1, std::string prior2, std::string prior3, std::string prior4, unsigned long seed ) {
+	PsiMCFileHeader header;
+	char snafc[20];
+	sprintf ( snafc, " nafc=%d", nafc );
+	header.model = core + " " + sigmoid + snafc;
+	header.priors.push_back ( prior1 );
+	header.priors.push_back ( prior2 );
+	header.priors.push_back ( prior3 );
+	if ( pmf->getNparams()>3 ) header.priors.push_back ( prior4 );
+	header.seed = seed;
+	return header;
+}
+
+std::string binaryFileName ( std::string fname, unsigned int index ) {
+	// The first input file is written to fname, further input files to fname.1, fname.2, ...
+	if ( index==0 ) return fname;
+	char suffix[20];
+	sprintf ( suffix, ".%u", index );
+	return fname + suffix;
+}
+
 void savestr ( double x, char *out ) {
 	// If x is a number this just gives a string representation of x otherwise, it returns a the string "NaN" which is compatible with matlab
 	if ( x == x )
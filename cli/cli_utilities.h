@@ -7,8 +7,22 @@
 #include <cstdio>
 #include <list>
 
-PsiData * allocateDataFromFile ( std::string fname, int nafc );
-
+/* Error in the input of a command line program, unlike PsiError it owns its message */
+class PsiInputError : public PsiError {
+	private:
+		std::string text;
+	public:
+		PsiInputError ( const std::string& msg ) : text ( msg ) { message = text.c_str(); }
+		PsiInputError ( const PsiInputError& e ) : PsiError(), text ( e.text ) { message = text.c_str(); }
+		PsiInputError& operator= ( const PsiInputError& e ) { text = e.text; message = text.c_str(); return *this; }
+};
+
+/* Read all data sets from a file (one per value of the session column) */
+std::vector<PsiData*> allocateDatasetsFromFile ( std::string fname, int nafc, std::vector<std::string> * sessions );
+/* Read a single data set from a file, session must be given if the file contains several sessions. Errors in the file throw PsiInputError */
+PsiData * allocateDataFromFile ( std::string fname, int nafc, std::string session="" );
+
+/* Set up a model from its command line specification, unknown cores, sigmoids or priors throw PsiInputError */
 PsiPsychometric * allocatePsychometric ( std::string core, std::string sigmoid, int nafc, PsiData* data, bool verbose );
 
 PsiPrior * allocatePrior ( std::string prior );
@@ -16,6 +30,10 @@ void setPriors ( PsiPsychometric * pmf, std::string prior1, std::string prior2,
 
 std::vector<double> getCuts ( std::string cuts );
 
+PsiMCFileHeader describeAnalysis ( std::string core, std::string sigmoid, int nafc, const PsiPsychometric * pmf,
+		std::string prior1, std::string prior2, std::string prior3, std::string prior4, unsigned long seed );
+std::string binaryFileName ( std::string fname, unsigned int index );
+
 void print ( std::vector<double> theta, bool matlabformat, std::string varname, FILE *ofile );
 void print ( double theta, bool matlabformat, std::string varname, FILE *ofile );
 void print ( std::vector< std::vector<double> >& theta, bool matlabformat, std::string varname, FILE *ofile );
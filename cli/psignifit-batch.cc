@@ -0,0 +1,384 @@
+/**
+ * psignifit-batch: analyze many data sets in a single process
+ *
+ * This file is part of the command line interface to psignifit.
+ *
+ * The data sets are listed in a manifest file. Every line of the manifest names a data file, optionally followed by
+ * options that override the command line for this data set, e.g.
+ *
+ *   session01.txt
+ *   session02.txt -c ab -s gauss -prior3 Uniform(0,.05)
+ *   session03.txt -analysis mcmc -nsamples 5000
+ *   lab.csv -session s04
+ *
+ * Empty lines and lines starting with '#' are ignored. The data sets are distributed over a pool of threads. Models
+ * with the same specification are set up only once and shared between data sets (unless the core depends on the
+ * data). Every data set draws random numbers from its own stream, so the results do not depend on the number of
+ * threads.
+ *
+ * See COPYING file distributed along with the psignifit package for the copyright and
+ * license terms
+ */
+#include "../src/psipp.h"
+#include "cli.h"
+
+#include "cli_utilities.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <pthread.h>
+#include "../src/parallel.h"
+
+/* options that can be given per data set in the manifest */
+const char * batchoptions[] = { "-c", "-s", "-prior1", "-prior2", "-prior3", "-prior4", "-nafc", "-cuts",
+	"-analysis", "-nsamples", "-proposal", "-session", NULL };
+
+struct BatchEntry {
+	std::string fname;
+	std::map<std::string,std::string> options;    // all batch options, manifest entries override the command line
+	bool gammaislambda;
+};
+
+class BatchJob : public PsiParallelJob {
+	public:
+		const std::vector<BatchEntry> * entries;
+		std::map<std::string,PsiPsychometric*> models;  // shared models by specification
+		FILE * ofile;
+		std::string odir;
+		std::string binary;
+		bool matlabformat;
+		bool verbose;
+		unsigned long seed;
+		unsigned int nfailed;
+		pthread_mutex_t lock;              // protects models, nfailed, the combined output and std::cerr
+		void process ( unsigned int i, unsigned int thread );
+};
+
+std::string getOption ( const BatchEntry& entry, const std::string& option ) {
+	// The options are resolved before the threads start, cli_parser is not safe for concurrent reads
+	std::map<std::string,std::string>::const_iterator opt ( entry.options.find ( option ) );
+	if ( opt!=entry.options.end() ) return opt->second;
+	throw BadArgumentError ( "unresolved batch option" );
+}
+
+std::vector<BatchEntry> readManifest ( std::string fname, bool gammaislambda ) {
+	std::ifstream manifest ( fname.c_str() );
+	std::vector<BatchEntry> entries;
+	std::string line, token;
+	unsigned int lineno ( 0 ), i;
+
+	if ( manifest.fail() ) {
+		std::cerr << "Could not open manifest '" << fname << "' --- aborting!\n";
+		exit ( -1 );
+	}
+
+	while ( std::getline ( manifest, line ) ) {
+		lineno++;
+		std::istringstream tokens ( line );
+		if ( !(tokens >> token) || token[0]=='#' )
+			continue;
+		BatchEntry entry;
+		entry.fname = token;
+		entry.gammaislambda = gammaislambda;
+		while ( tokens >> token ) {
+			if ( token=="-e" ) {
+				entry.gammaislambda = true;
+				continue;
+			}
+			for ( i=0; batchoptions[i]!=NULL; i++ )
+				if ( token==batchoptions[i] ) break;
+			if ( batchoptions[i]==NULL || !(tokens >> entry.options[token]) ) {
+				std::cerr << fname << ":" << lineno << ": invalid option '" << token << "' --- aborting!\n";
+				exit ( -1 );
+			}
+		}
+		entries.push_back ( entry );
+	}
+
+	return entries;
+}
+
+/* Get a model for the data set, models that do not depend on the data are shared */
+PsiPsychometric * getModel ( BatchJob * job, const BatchEntry& entry, PsiData * data, bool * shared ) {
+	std::string core ( getOption ( entry, "-c" ) );
+	std::string spec;
+	PsiPsychometric * pmf;
+
+	*shared = core=="ab" || core=="linear" || !core.compare ( 0, 2, "mw" );
+	if ( *shared ) {
+		spec = core + " " + getOption ( entry, "-s" ) + " " + getOption ( entry, "-nafc" )
+			+ " " + getOption ( entry, "-prior1" ) + " " + getOption ( entry, "-prior2" )
+			+ " " + getOption ( entry, "-prior3" ) + " " + getOption ( entry, "-prior4" )
+			+ ( entry.gammaislambda ? " e" : "" );
+		pthread_mutex_lock ( &(job->lock) );
+		std::map<std::string,PsiPsychometric*>::iterator model ( job->models.find ( spec ) );
+		pmf = model!=job->models.end() ? model->second : NULL;
+		pthread_mutex_unlock ( &(job->lock) );
+		if ( pmf!=NULL )
+			return pmf;
+	}
+
+	// The model is set up without holding the lock, other threads can go on meanwhile
+	pmf = allocatePsychometric ( core, getOption ( entry, "-s" ), atoi ( getOption ( entry, "-nafc" ).c_str() ), data, false );
+	if ( entry.gammaislambda ) pmf->setgammatolambda();
+	try {
+		setPriors ( pmf,
+				getOption ( entry, "-prior1" ),
+				getOption ( entry, "-prior2" ),
+				getOption ( entry, "-prior3" ),
+				getOption ( entry, "-prior4" ) );
+	} catch ( ... ) {
+		delete pmf;
+		throw;
+	}
+
+	if ( *shared ) {
+		// Another thread may have set up the same model in the meantime, in that case its model is used
+		pthread_mutex_lock ( &(job->lock) );
+		std::map<std::string,PsiPsychometric*>::iterator model ( job->models.find ( spec ) );
+		if ( model!=job->models.end() ) {
+			delete pmf;
+			pmf = model->second;
+		} else {
+			job->models[spec] = pmf;
+		}
+		pthread_mutex_unlock ( &(job->lock) );
+	}
+	return pmf;
+}
+
+void analyze ( BatchJob * job, unsigned int index, FILE * ofile ) {
+	const BatchEntry& entry ( (*(job->entries))[index] );
+	std::string analysis ( getOption ( entry, "-analysis" ) );
+	std::vector<double> cuts ( getCuts ( getOption ( entry, "-cuts" ) ) );
+	unsigned int nsamples ( atoi ( getOption ( entry, "-nsamples" ).c_str() ) );
+	unsigned int i, j;
+	bool shared ( false );
+	PsiData * data ( NULL );
+	PsiPsychometric * pmf ( NULL );
+	PsiRandomEngine engine ( job->seed, index );
+	const char * error ( NULL );
+	std::string what;
+
+	// Errors in the data file or the model only affect this data set
+	try {
+		data = allocateDataFromFile ( entry.fname, atoi ( getOption ( entry, "-nafc" ).c_str() ), getOption ( entry, "-session" ) );
+		pmf = getModel ( job, entry, data, &shared );
+		PsiMCFileHeader header ( describeAnalysis ( getOption ( entry, "-c" ), getOption ( entry, "-s" ),
+					atoi ( getOption ( entry, "-nafc" ).c_str() ), pmf,
+					getOption ( entry, "-prior1" ), getOption ( entry, "-prior2" ),
+					getOption ( entry, "-prior3" ), getOption ( entry, "-prior4" ), job->seed ) );
+
+		PsiOptimizer opt ( pmf, data );
+		std::vector<double> theta ( opt.optimize ( pmf, data ) );
+		std::vector<double> thresholds ( cuts.size() ), slopes ( cuts.size() );
+		for ( i=0; i<cuts.size(); i++ ) {
+			thresholds[i] = pmf->getThres ( theta, cuts[i] );
+			slopes[i]     = pmf->getSlope ( theta, thresholds[i] );
+		}
+
+		print ( theta,                         job->matlabformat, "params_estimate", ofile );
+		print ( pmf->deviance ( theta, data ), job->matlabformat, "deviance",        ofile );
+		print ( thresholds,                    job->matlabformat, "thresholds",      ofile );
+		print ( slopes,                        job->matlabformat, "slopes",          ofile );
+
+		if ( analysis=="bootstrap" ) {
+			BootstrapList bs_list ( bootstrap ( nsamples, data, pmf, cuts, &theta, true, true, 1, OPTIMIZER_SIMPLEX, &engine ) );
+			std::vector< std::vector<double> > mcestimates ( nsamples ), mcthres ( nsamples, cuts ), mcslopes ( nsamples, cuts );
+			std::vector<double> mcdeviance ( nsamples ), mcRpd ( nsamples ), mcRkd ( nsamples );
+			for ( i=0; i<nsamples; i++ ) {
+				mcestimates[i] = bs_list.getEst ( i );
+				for ( j=0; j<cuts.size(); j++ ) {
+					mcthres[i][j]  = bs_list.getThres_byPos ( i, j );
+					mcslopes[i][j] = bs_list.getSlope_byPos ( i, j );
+				}
+				mcdeviance[i] = bs_list.getdeviance ( i );
+				mcRpd[i]      = bs_list.getRpd ( i );
+				mcRkd[i]      = bs_list.getRkd ( i );
+			}
+			print ( mcestimates, job->matlabformat, "mcestimates", ofile );
+			print ( mcdeviance,  job->matlabformat, "mcdeviance",  ofile );
+			print ( mcthres,     job->matlabformat, "mcthres",     ofile );
+			print ( mcslopes,    job->matlabformat, "mcslopes",    ofile );
+			print ( mcRpd,       job->matlabformat, "mcRpd",       ofile );
+			print ( mcRkd,       job->matlabformat, "mcRkd",       ofile );
+			if ( job->binary != "" )
+				writeMCFile ( binaryFileName ( job->binary, index ), bs_list, header );
+		} else if ( analysis=="mcmc" ) {
+			MetropolisHastings sampler ( pmf, data, new GaussRandom () );
+			sampler.setEngine ( &engine );
+			sampler.setStepSize ( getCuts ( getOption ( entry, "-proposal" ) ) );
+			sampler.setTheta ( theta );
+			MCMCList mcmc_list ( sampler.sample ( nsamples ) );
+			std::vector< std::vector<double> > mcestimates ( nsamples );
+			std::vector<double> mcdeviance ( nsamples ), ppdeviance ( nsamples );
+			for ( i=0; i<nsamples; i++ ) {
+				mcestimates[i] = mcmc_list.getEst ( i );
+				mcdeviance[i]  = mcmc_list.getdeviance ( i );
+				ppdeviance[i]  = mcmc_list.getppDeviance ( i );
+			}
+			print ( mcestimates, job->matlabformat, "mcestimates", ofile );
+			print ( mcdeviance,  job->matlabformat, "mcdeviance",  ofile );
+			print ( ppdeviance,  job->matlabformat, "ppdeviance",  ofile );
+			if ( job->binary != "" )
+				writeMCFile ( binaryFileName ( job->binary, index ), mcmc_list, header, pmf, cuts );
+		} else if ( analysis!="mapestimate" ) {
+			throw BadArgumentError ( "unknown analysis (use mapestimate, bootstrap or mcmc)" );
+		}
+	} catch ( PsiError& e ) {
+		what = e.message;      // the message of a PsiInputError does not survive the catch block
+		error = what.c_str();
+	} catch ( std::exception& e ) {
+		what = e.what();
+		error = what.c_str();
+	}
+
+	if ( error!=NULL ) {
+		pthread_mutex_lock ( &(job->lock) );
+		std::cerr << "Analysis of '" << entry.fname << "' failed: " << error << "\n";
+		job->nfailed++;
+		pthread_mutex_unlock ( &(job->lock) );
+	}
+
+	if ( !shared ) delete pmf;
+	delete data;
+}
+
+void BatchJob::process ( unsigned int i, unsigned int thread ) {
+	FILE * datafile;
+	char buffer[4096];
+	size_t n;
+	std::string fname, session;
+
+	fname = (*entries)[i].fname;
+	session = getOption ( (*entries)[i], "-session" );
+	if ( verbose ) {
+		pthread_mutex_lock ( &lock );
+		std::cerr << "Analyzing input file '" << fname << "'\n";
+		pthread_mutex_unlock ( &lock );
+	}
+
+	if ( odir != "" ) {
+		// One results file per data set, numbered because a data file can appear several times in the manifest
+		sprintf ( buffer, "%s/%u_", odir.c_str(), i );
+		fname = buffer + fname.substr ( fname.find_last_of ( '/' )+1 ) + ".psi";
+		datafile = fopen ( fname.c_str(), "w" );
+		if ( datafile==NULL ) {
+			pthread_mutex_lock ( &lock );
+			std::cerr << "Could not write '" << fname << "'\n";
+			nfailed++;
+			pthread_mutex_unlock ( &lock );
+			return;
+		}
+		analyze ( this, i, datafile );
+		fclose ( datafile );
+	} else {
+		// Results are collected and appended to the combined output as a whole
+		datafile = tmpfile ();
+		if ( datafile==NULL ) {
+			pthread_mutex_lock ( &lock );
+			std::cerr << "Could not create a temporary file for '" << fname << "'\n";
+			nfailed++;
+			pthread_mutex_unlock ( &lock );
+			return;
+		}
+		analyze ( this, i, datafile );
+		rewind ( datafile );
+		pthread_mutex_lock ( &lock );
+		if ( matlabformat )
+			fprintf ( ofile, "%% dataset: %s %s\n", fname.c_str(), session.c_str() );
+		else
+			fprintf ( ofile, "\n# dataset: %s %s\n", fname.c_str(), session.c_str() );
+		while ( (n=fread ( buffer, 1, sizeof(buffer), datafile )) > 0 )
+			fwrite ( buffer, 1, n, ofile );
+		fflush ( ofile );
+		pthread_mutex_unlock ( &lock );
+		fclose ( datafile );
+	}
+}
+
+int main ( int argc, char ** argv ) {
+	// Parse command line
+	cli_parser parser ( "psignifit-batch [options] <manifest> [ <manifest> ... ]" );
+	parser.add_option ( "-c",           "psignifit core object to be used", "mw0.1" );
+	parser.add_option ( "-s",           "psignifit sigmoid object to be used", "logistic" );
+	parser.add_option ( "-prior1",      "prior for the first parameter (alpha,a,m,...)", "None" );
+	parser.add_option ( "-prior2",      "prior for the second parameter (beta,b,w,...)", "None" );
+	parser.add_option ( "-prior3",      "prior for the third parameter (lambda)", "Uniform(0,.1)" );
+	parser.add_option ( "-prior4",      "prior for the fourth parameter (gamma)", "Uniform(0,.1)" );
+	parser.add_option ( "-nafc",        "number of response alternatives in forced choice designs (set this to 1 for yes-no tasks)", "2" );
+	parser.add_option ( "-cuts",        "cuts to be determined", "0.25,0.50,0.75" );
+	parser.add_option ( "-analysis",    "analysis to be performed for each data set (mapestimate, bootstrap or mcmc)", "mapestimate" );
+	parser.add_option ( "-nsamples",    "number of bootstrap or markov chain monte carlo samples to be generated", "2000" );
+	parser.add_option ( "-proposal",    "standard deviations of the proposal distribution for mcmc", "0.1,0.1,0.01" );
+	parser.add_option ( "-session",     "session to be analyzed in data files with a session column", "" );
+	parser.add_option ( "-nthreads",    "number of threads that analyze data sets", "1" );
+	parser.add_option ( "-seed",        "seed of the random number streams (data set i draws from stream i)", "0" );
+	parser.add_option ( "-o",           "write combined output to this file", "stdout" );
+	parser.add_option ( "-odir",        "write one results file <i>_<datafile>.psi per data set to this directory instead of the combined output", "" );
+	parser.add_option ( "-binary",      "write samples of data set i to the binary sample file <file>.i (<file> for the first data set)", "" );
+	parser.add_switch ( "-v",           "display status messages", false );
+	parser.add_switch ( "-e",           "In yes-no tasks: set gamma==lambda", false );
+	parser.add_switch ( "--matlab",     "format output to be parsable by matlab", false );
+
+	parser.parse_args ( argc, argv );
+
+	std::vector<BatchEntry> entries, manifest;
+	std::string fname ( parser.popArg () );
+	if ( fname == "" ) {
+		std::cerr << "No manifest given --- aborting!\n";
+		exit ( -1 );
+	}
+	while ( fname != "" ) {
+		manifest = readManifest ( fname, parser.getOptSet ( "-e" ) );
+		entries.insert ( entries.end(), manifest.begin(), manifest.end() );
+		fname = parser.popArg ();
+	}
+
+	// Fill in the command line for options that the manifest does not set
+	unsigned int i, k;
+	for ( i=0; i<entries.size(); i++ )
+		for ( k=0; batchoptions[k]!=NULL; k++ )
+			if ( entries[i].options.count ( batchoptions[k] )==0 )
+				entries[i].options[batchoptions[k]] = parser.getOptArg ( batchoptions[k] );
+	int nthreads ( atoi ( parser.getOptArg ( "-nthreads" ).c_str() ) );
+
+	BatchJob job;
+	job.entries = &entries;
+	job.odir = parser.getOptArg ( "-odir" );
+	job.binary = parser.getOptArg ( "-binary" );
+	job.matlabformat = parser.getOptSet ( "--matlab" );
+	job.verbose = parser.getOptSet ( "-v" );
+	job.seed = strtoul ( parser.getOptArg ( "-seed" ).c_str(), NULL, 10 );
+	job.nfailed = 0;
+	pthread_mutex_init ( &(job.lock), NULL );
+
+	if ( !(parser.getOptArg ( "-o" ).compare( "stdout" )) )
+		job.ofile = stdout;
+	else
+		job.ofile = fopen ( parser.getOptArg ( "-o" ).c_str(), "w" );
+	if ( job.ofile==NULL ) {
+		std::cerr << "Could not open output file '" << parser.getOptArg ( "-o" ) << "' --- aborting!\n";
+		exit ( -1 );
+	}
+
+	if ( job.verbose ) std::cerr << "Analyzing " << entries.size() << " data sets\n";
+
+	// Failed data sets are counted in process(), errors do not stop the other data sets
+	run_parallel ( &job, entries.size(), nthreads );
+	pthread_mutex_destroy ( &(job.lock) );
+
+	// Clean up
+	std::map<std::string,PsiPsychometric*>::iterator model;
+	for ( model=job.models.begin(); model!=job.models.end(); model++ )
+		delete model->second;
+	if ( job.ofile!=stdout ) fclose ( job.ofile );
+
+	if ( job.nfailed>0 ) {
+		std::cerr << job.nfailed << " of " << entries.size() << " data sets failed\n";
+		return 1;
+	}
+	return 0;
+}
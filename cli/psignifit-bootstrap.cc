@@ -23,9 +23,12 @@ int main ( int argc, char ** argv ) {
 	parser.add_option ( "-prior3", "prior for the third parameter (lambda)", "Uniform(0,.1)" );
 	parser.add_option ( "-prior4", "prior for the fourth parameter (gamma)", "Uniform(0,.1)" );
 	parser.add_option ( "-nafc",   "number of response alternatives in forced choice designs (set this to 1 for yes-no tasks)", "2" );
+	parser.add_option ( "-session", "session to be analyzed in data files with a session column", "" );
 	parser.add_option ( "-nsamples","number of bootstrap samples to be generated","2000" );
 	parser.add_option ( "-o",      "write output to this file", "stdout" );
 	parser.add_option ( "-cuts",   "cuts to be determined", "0.25,0.50,0.75" );
+	parser.add_option ( "-nthreads","number of threads used to fit the bootstrap samples", "1" );
+	parser.add_option ( "-binary",  "also write the bootstrap samples to this binary sample file (further input files go to <file>.1, <file>.2, ...)", "" );
 	parser.add_switch ( "-v", "display status messages", false );
 	parser.add_switch ( "--summary", "write a short summary to stdout" );
 	parser.add_switch ( "-e", "In yes-no tasks: set gamma==lambda", false );
@@ -45,6 +48,8 @@ int main ( int argc, char ** argv ) {
 	BootstrapList *bs_list;
 	JackKnifeList *jk_list;
 	unsigned int nsamples ( atoi ( parser.getOptArg("-nsamples").c_str() ) );
+	unsigned int nthreads ( atoi ( parser.getOptArg("-nthreads").c_str() ) );
+	unsigned int nfiles ( 0 );
 	double th;
 	double sl;
 	double th_m;
@@ -112,7 +117,12 @@ int main ( int argc, char ** argv ) {
 		if ( verbose ) std::cerr << "Analyzing input file '" << fname << "'\n   ";
 
 		// Get the data
-		data = allocateDataFromFile ( fname, atoi ( parser.getOptArg ( "-nafc" ).c_str() ) );
+		try {
+			data = allocateDataFromFile ( fname, atoi ( parser.getOptArg ( "-nafc" ).c_str() ), parser.getOptArg ( "-session" ) );
+		} catch ( PsiError& e ) {
+			std::cerr << e.message << " --- aborting!\n";
+			exit ( -1 );
+		}
 		nblocks = data->getNblocks();
 
 		if ( verbose ) std::cerr << "Read " << nblocks << " blocks ";
@@ -124,18 +134,23 @@ int main ( int argc, char ** argv ) {
 		}
 
 		// Get the psychometric function model
-		pmf  = allocatePsychometric ( parser.getOptArg ( "-c" ),
-			parser.getOptArg ( "-s" ),
-			atoi ( parser.getOptArg ( "-nafc" ).c_str() ),
-			data,
-			verbose && !pmfshown);
-		pmfshown = true;
-		if ( parser.getOptSet ( "-e" ) ) pmf->setgammatolambda();
-		setPriors ( pmf,
-				parser.getOptArg ( "-prior1" ),
-				parser.getOptArg ( "-prior2" ),
-				parser.getOptArg ( "-prior3" ),
-				parser.getOptArg ( "-prior4" ) );
+		try {
+			pmf  = allocatePsychometric ( parser.getOptArg ( "-c" ),
+				parser.getOptArg ( "-s" ),
+				atoi ( parser.getOptArg ( "-nafc" ).c_str() ),
+				data,
+				verbose && !pmfshown);
+			pmfshown = true;
+			if ( parser.getOptSet ( "-e" ) ) pmf->setgammatolambda();
+			setPriors ( pmf,
+					parser.getOptArg ( "-prior1" ),
+					parser.getOptArg ( "-prior2" ),
+					parser.getOptArg ( "-prior3" ),
+					parser.getOptArg ( "-prior4" ) );
+		} catch ( PsiError& e ) {
+			std::cerr << e.message << " --- aborting!\n";
+			exit ( -1 );
+		}
 		nparams = pmf->getNparams();
 
 		// Determine starting value
@@ -149,7 +164,7 @@ int main ( int argc, char ** argv ) {
 			std::cerr.flush();
 		}
 		bs_list = new BootstrapList ( bootstrap ( atoi(parser.getOptArg("-nsamples").c_str()),
-				data, pmf, cuts, &theta,true,!(parser.getOptSet("-nonparametric")) ) );
+				data, pmf, cuts, &theta,true,!(parser.getOptSet("-nonparametric")), nthreads ) );
 		if ( verbose ) { std::cerr << "jk..."; std::cerr.flush(); }
 		jk_list = new JackKnifeList ( jackknifedata ( data, pmf ) );
 		if ( verbose ) { std::cerr << " Done"; std::cerr.flush(); }
@@ -222,13 +237,20 @@ int main ( int argc, char ** argv ) {
 		}
 		
 		
+		// The binary file keeps the samples used for inference
+		if ( parser.getOptArg ( "-binary" ) != "" )
+			writeMCFile ( binaryFileName ( parser.getOptArg ( "-binary" ), nfiles ),
+					*bs_list,
+					describeAnalysis ( parser.getOptArg ( "-c" ), parser.getOptArg ( "-s" ), atoi ( parser.getOptArg ( "-nafc" ).c_str() ), pmf,
+						parser.getOptArg ( "-prior1" ), parser.getOptArg ( "-prior2" ), parser.getOptArg ( "-prior3" ), parser.getOptArg ( "-prior4" ), 0 ) );
+
 		// If we performed nonparametric bootstrap, we can't use the bootstrap samples for goodness of fit
 		// Here we perform a second, parametric bootstrap that gives the data for the goodness of fit assessment
 		if ( parser.getOptSet("-nonparametric") ) {
 			// redo bootstrap to obtain goodness of fit form parametric simulations
 			delete bs_list;
 			bs_list = new BootstrapList ( bootstrap ( atoi(parser.getOptArg("-nsamples").c_str()),
-					data, pmf, cuts, &theta, true, true ) );
+					data, pmf, cuts, &theta, true, true, nthreads ) );
 		}
 
 		// Now store everything related to goodness of fit
@@ -272,6 +294,7 @@ int main ( int argc, char ** argv ) {
 
 		// Get the next input file (if there is one)
 		fname = parser.popArg();
+		nfiles++;
 
 		// Clean up
 		delete mcestimates;
@@ -21,6 +21,7 @@ int main ( int argc, char ** argv ) {
 	parser.add_option ( "-c", "psignifit core object to be used", "mw0.1" );
 	parser.add_option ( "-s", "psignifit sigmoid object to be used", "logistic" );
 	parser.add_option ( "-nafc",   "number of response alternatives in forced choice designs (set this to 1 for yes-no tasks)", "2" );
+	parser.add_option ( "-session", "session to be analyzed in data files with a session column", "" );
 	parser.add_option ( "-o",      "write output to this file", "stdout" );
 	parser.add_option ( "-cuts",   "cuts to be determined", "0.25,0.50,0.75" );
 	parser.add_option ( "-params", "parameters to be evaluated", "4.0,2.0,0.02" );
@@ -75,18 +76,28 @@ int main ( int argc, char ** argv ) {
 	while ( fname != "" ) {
 		if ( verbose ) std::cerr << "Analyzing input file '" << fname << "'\n   ";
 
-		data = allocateDataFromFile ( fname, atoi ( parser.getOptArg ( "-nafc" ).c_str() ) );
+		try {
+			data = allocateDataFromFile ( fname, atoi ( parser.getOptArg ( "-nafc" ).c_str() ), parser.getOptArg ( "-session" ) );
+		} catch ( PsiError& e ) {
+			std::cerr << e.message << " --- aborting!\n";
+			exit ( -1 );
+		}
 
 		if ( verbose ) std::cerr << "Read " << data->getNblocks() << " blocks ";
 
 		// Here, we set up the psychometric function model
-		pmf  = allocatePsychometric ( parser.getOptArg ( "-c" ),
-			parser.getOptArg ( "-s" ),
-			atoi ( parser.getOptArg ( "-nafc" ).c_str() ),
-			data,
-			verbose && !pmfshown);
-		pmfshown = true;
-		if ( parser.getOptSet ( "-e" ) ) pmf->setgammatolambda();
+		try {
+			pmf  = allocatePsychometric ( parser.getOptArg ( "-c" ),
+				parser.getOptArg ( "-s" ),
+				atoi ( parser.getOptArg ( "-nafc" ).c_str() ),
+				data,
+				verbose && !pmfshown);
+			pmfshown = true;
+			if ( parser.getOptSet ( "-e" ) ) pmf->setgammatolambda();
+		} catch ( PsiError& e ) {
+			std::cerr << e.message << " --- aborting!\n";
+			exit ( -1 );
+		}
 
 		// Replace cuts with the derived thresholds at the cuts
 		for ( i=0; i<cuts.size(); i++ ) {
@@ -23,6 +23,7 @@ int main ( int argc, char ** argv ) {
 	parser.add_option ( "-prior3", "prior for the third parameter (lambda)", "Uniform(0,.1)" );
 	parser.add_option ( "-prior4", "prior for the fourth parameter (gamma)", "Uniform(0,.1)" );
 	parser.add_option ( "-nafc",   "number of response alternatives in forced choice designs (set this to 1 for yes-no tasks)", "2" );
+	parser.add_option ( "-session", "session to be analyzed in data files with a session column", "" );
 	parser.add_option ( "-o",      "write output to this file", "stdout" );
 	parser.add_option ( "-cuts",   "cuts to be determined", "0.25,0.50,0.75" );
 	parser.add_switch ( "-v", "display status messages", false );
@@ -71,23 +72,33 @@ int main ( int argc, char ** argv ) {
 	while ( fname != "" ) {
 		if ( verbose ) std::cerr << "Analyzing input file '" << fname << "'\n   ";
 
-		data = allocateDataFromFile ( fname, atoi ( parser.getOptArg ( "-nafc" ).c_str() ) );
+		try {
+			data = allocateDataFromFile ( fname, atoi ( parser.getOptArg ( "-nafc" ).c_str() ), parser.getOptArg ( "-session" ) );
+		} catch ( PsiError& e ) {
+			std::cerr << e.message << " --- aborting!\n";
+			exit ( -1 );
+		}
 
 		if ( verbose ) std::cerr << "Read " << data->getNblocks() << " blocks ";
 
 		// Here, we set up the psychometric function model
-		pmf  = allocatePsychometric ( parser.getOptArg ( "-c" ),
-			parser.getOptArg ( "-s" ),
-			atoi ( parser.getOptArg ( "-nafc" ).c_str() ),
-			data,
-			verbose && !pmfshown);
-		pmfshown = true;
-		if ( parser.getOptSet ( "-e" ) ) pmf->setgammatolambda();
-		setPriors ( pmf,
-				parser.getOptArg ( "-prior1" ),
-				parser.getOptArg ( "-prior2" ),
-				parser.getOptArg ( "-prior3" ),
-				parser.getOptArg ( "-prior4" ) );
+		try {
+			pmf  = allocatePsychometric ( parser.getOptArg ( "-c" ),
+				parser.getOptArg ( "-s" ),
+				atoi ( parser.getOptArg ( "-nafc" ).c_str() ),
+				data,
+				verbose && !pmfshown);
+			pmfshown = true;
+			if ( parser.getOptSet ( "-e" ) ) pmf->setgammatolambda();
+			setPriors ( pmf,
+					parser.getOptArg ( "-prior1" ),
+					parser.getOptArg ( "-prior2" ),
+					parser.getOptArg ( "-prior3" ),
+					parser.getOptArg ( "-prior4" ) );
+		} catch ( PsiError& e ) {
+			std::cerr << e.message << " --- aborting!\n";
+			exit ( -1 );
+		}
 
 		// Perform the optimization
 		opt = new PsiOptimizer ( pmf, data );
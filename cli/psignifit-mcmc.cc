@@ -30,15 +30,24 @@ int main ( int argc, char ** argv ) {
 	parser.add_option ( "-prior3",      "prior for the third parameter (lambda)", "Uniform(0,.1)" );
 	parser.add_option ( "-prior4",      "prior for the fourth parameter (gamma)", "Uniform(0,.1)" );
 	parser.add_option ( "-nafc",        "number of response alternatives in forced choice designs (set this to 1 for yes-no tasks)", "2" );
+	parser.add_option ( "-session",     "session to be analyzed in data files with a session column", "" );
 	parser.add_option ( "-nsamples",    "number of markov chain monte carlo samples to be generated","2000" );
 	parser.add_option ( "-o",           "write output to this file", "stdout" );
 	parser.add_option ( "-cuts",        "cuts to be determined", "0.25,0.50,0.75" );
 	parser.add_option ( "-proposal",    "standard deviations of the proposal distribution (or name of file with pilot samples)", "0.1,0.1,0.01" );
 	parser.add_option ( "-start",       "starting values for the sampling process", "mapestimate" );
+	parser.add_option ( "-nthreads",    "number of threads that compute posterior predictive data and diagnostics", "1" );
+	parser.add_option ( "-binary",      "also write the samples to this binary sample file (further input files go to <file>.1, <file>.2, ...)", "" );
 	parser.add_switch ( "-v",           "display status messages", false );
 	parser.add_switch ( "--summary",    "write a short summary to stdout" );
 	parser.add_switch ( "-e",           "In yes-no tasks: set gamma==lambda", false );
 	parser.add_switch ( "-generic",     "Use generic metropolis instead of the default standard metropolis hastings", false );
+	parser.add_option ( "-adapt",       "use adaptive metropolis with this many adaptation steps before sampling (learns the proposal covariance, 0 to switch off)", "0" );
+	parser.add_option ( "-nuts",        "use the No-U-Turn sampler with this many adaptation steps before sampling (adapts stepsize and mass matrix, ignores -proposal, 0 to switch off)", "0" );
+	parser.add_option ( "-tempering",   "use parallel tempering with this many replicas on -nthreads threads for multimodal posteriors (-proposal gives the stepwidths of the cold replica, 0 to switch off)", "0" );
+	parser.add_option ( "-maxtemp",     "temperature of the hottest replica for -tempering", "10" );
+	parser.add_option ( "-target-ess",  "sample in chunks until every parameter has this effective sample size (-nsamples is the largest number of samples, 0 to switch off)", "0" );
+	parser.add_option ( "-target-mcse", "sample in chunks until every threshold has at most this monte carlo standard error (-nsamples is the largest number of samples, 0 to switch off)", "0" );
 	parser.add_switch ( "--matlab",     "format output to be parsable by matlab", false );
 
 	parser.parse_args ( argc, argv );
@@ -58,6 +67,8 @@ int main ( int argc, char ** argv ) {
 	char                        sline[80];
 	MCMCList                   *mcmc_list;
 	unsigned int                nsamples ( atoi ( parser.getOptArg("-nsamples").c_str() ) );
+	unsigned int                maxsamples ( nsamples );
+	unsigned int                nfiles ( 0 );
 	double                      th;
 	double 						sl;
 	double 						th_m;
@@ -183,24 +194,34 @@ int main ( int argc, char ** argv ) {
 		if ( verbose ) std::cerr << "Analyzing input file '" << fname << "'\n   ";
 
 		// Get the data
-		data = allocateDataFromFile ( fname, atoi ( parser.getOptArg ( "-nafc" ).c_str() ) );
+		try {
+			data = allocateDataFromFile ( fname, atoi ( parser.getOptArg ( "-nafc" ).c_str() ), parser.getOptArg ( "-session" ) );
+		} catch ( PsiError& e ) {
+			std::cerr << e.message << " --- aborting!\n";
+			exit ( -1 );
+		}
 		nblocks = data->getNblocks();
 
 		if ( verbose ) std::cerr << "Read " << nblocks << " blocks ";
 
 		// Get the psychometric function model
-		pmf  = allocatePsychometric ( parser.getOptArg ( "-c" ),
-			parser.getOptArg ( "-s" ),
-			atoi ( parser.getOptArg ( "-nafc" ).c_str() ),
-			data,
-			verbose && !pmfshown);
-		pmfshown = true;
-		if ( parser.getOptSet ( "-e" ) ) pmf->setgammatolambda();
-		setPriors ( pmf,
-				parser.getOptArg ( "-prior1" ),
-				parser.getOptArg ( "-prior2" ),
-				parser.getOptArg ( "-prior3" ),
-				parser.getOptArg ( "-prior4" ) );
+		try {
+			pmf  = allocatePsychometric ( parser.getOptArg ( "-c" ),
+				parser.getOptArg ( "-s" ),
+				atoi ( parser.getOptArg ( "-nafc" ).c_str() ),
+				data,
+				verbose && !pmfshown);
+			pmfshown = true;
+			if ( parser.getOptSet ( "-e" ) ) pmf->setgammatolambda();
+			setPriors ( pmf,
+					parser.getOptArg ( "-prior1" ),
+					parser.getOptArg ( "-prior2" ),
+					parser.getOptArg ( "-prior3" ),
+					parser.getOptArg ( "-prior4" ) );
+		} catch ( PsiError& e ) {
+			std::cerr << e.message << " --- aborting!\n";
+			exit ( -1 );
+		}
 		nparams = pmf->getNparams();
 
 		// Determine starting value
@@ -208,7 +229,16 @@ int main ( int argc, char ** argv ) {
 		theta = opt->optimize ( pmf, data );
 		
 		// Set up the sampler
-		if ( generic ) {
+		if ( atoi ( parser.getOptArg ( "-tempering" ).c_str() ) > 0 ) {
+			sampler = new ParallelTempering ( pmf, data, atoi ( parser.getOptArg ( "-tempering" ).c_str() ),
+					atof ( parser.getOptArg ( "-maxtemp" ).c_str() ), 10, 2000, atoi ( parser.getOptArg ( "-nthreads" ).c_str() ) );
+			sampler->setStepSize ( stepwidths );
+		} else if ( atoi ( parser.getOptArg ( "-nuts" ).c_str() ) > 0 ) {
+			sampler = new NoUTurnSampler ( pmf, data, atoi ( parser.getOptArg ( "-nuts" ).c_str() ) );
+		} else if ( atoi ( parser.getOptArg ( "-adapt" ).c_str() ) > 0 ) {
+			sampler = new AdaptiveMetropolis ( pmf, data, &proposal, atoi ( parser.getOptArg ( "-adapt" ).c_str() ) );
+			sampler->setStepSize ( stepwidths );
+		} else if ( generic ) {
 			sampler = new GenericMetropolis ( pmf, data, &proposal );
 			if ( pilotsample != NULL ) {
 				((GenericMetropolis*)sampler)->findOptimalStepwidth ( *pilotsample );
@@ -220,9 +250,9 @@ int main ( int argc, char ** argv ) {
 			sampler->setStepSize ( stepwidths );
 		}
 		if ( parser.getOptArg ( "-start" ) == "mapestimate" ) {
-			((MetropolisHastings*)sampler)->setTheta ( theta );
+			sampler->setTheta ( theta );
 		} else {
-			((MetropolisHastings*)sampler)->setTheta ( getCuts ( parser.getOptArg ( "-start" ) ) );
+			sampler->setTheta ( getCuts ( parser.getOptArg ( "-start" ) ) );
 		}
 
 		// Sample
@@ -230,9 +260,28 @@ int main ( int argc, char ** argv ) {
 			std::cerr << "Starting sampling ...";
 			std::cerr.flush();
 		}
-		mcmc_list = new MCMCList ( sampler->sample ( nsamples ) );
+		sampler->setDiagnostics ( false );
+		if ( atof ( parser.getOptArg ( "-target-ess" ).c_str() ) > 0 || atof ( parser.getOptArg ( "-target-mcse" ).c_str() ) > 0 ) {
+			mcmc_list = new MCMCList ( sampler->sampleToPrecision (
+						atof ( parser.getOptArg ( "-target-ess" ).c_str() ),
+						atof ( parser.getOptArg ( "-target-mcse" ).c_str() ),
+						cuts, ( maxsamples<1000 ? maxsamples : 1000 ), maxsamples ) );
+			nsamples = mcmc_list->getNsamples();
+			mcthres.resize ( nsamples, cuts );
+			mcslopes.resize ( nsamples, cuts );
+			mcdeviance.resize ( nsamples );
+			mcRpd.resize ( nsamples );
+			mcRkd.resize ( nsamples );
+			ppdeviance.resize ( nsamples );
+			ppRpd.resize ( nsamples );
+			ppRkd.resize ( nsamples );
+			dummydata.resize ( nsamples/2 );
+		} else {
+			mcmc_list = new MCMCList ( sampler->sample ( nsamples ) );
+		}
+		sample_diagnostics ( pmf, data, mcmc_list, atoi ( parser.getOptArg ( "-nthreads" ).c_str() ) );
 
-		if ( verbose ) std::cerr << " Done \n";
+		if ( verbose ) std::cerr << " Done (" << nsamples << " samples)\n";
 
 		// These might change during analysis and have to be allocated for each file
 		mcestimates = new std::vector< std::vector<double> > (nsamples);
@@ -330,6 +379,12 @@ int main ( int argc, char ** argv ) {
 		}
 
 		// Now store everything in the output file.
+		if ( parser.getOptArg ( "-binary" ) != "" )
+			writeMCFile ( binaryFileName ( parser.getOptArg ( "-binary" ), nfiles ),
+					*mcmc_list,
+					describeAnalysis ( parser.getOptArg ( "-c" ), parser.getOptArg ( "-s" ), atoi ( parser.getOptArg ( "-nafc" ).c_str() ), pmf,
+						parser.getOptArg ( "-prior1" ), parser.getOptArg ( "-prior2" ), parser.getOptArg ( "-prior3" ), parser.getOptArg ( "-prior4" ), 0 ),
+					pmf, cuts );
 		print ( *mcdata,      matlabformat, "mcdata",      ofile );
 		print ( *mcestimates, matlabformat, "mcestimates", ofile );
 		print ( mcdeviance,   matlabformat, "mcdeviance",  ofile );
@@ -346,6 +401,7 @@ int main ( int argc, char ** argv ) {
 
 		// Get the next input file (if there is one)
 		fname = parser.popArg();
+		nfiles++;
 
 		// Clean up
 		delete mcestimates;
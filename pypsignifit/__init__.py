@@ -75,8 +75,8 @@ except ImportError:
 
 interface.set_seed( 0 )
 
-def set_seed(value):
-    interface.set_seed(value)
+def set_seed(value, hashed=False):
+    interface.set_seed(value, hashed)
 
 def dump_info():
     """
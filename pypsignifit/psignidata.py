@@ -1870,6 +1870,12 @@ class ASIRInference ( PsiInference ):
                 number
             *propose* :
                 how much more samples should be proposed than will eventually be taken?
+            *gridsize* :
+                number of grid points per parameter on which the marginal posteriors are evaluated before refinement
+            *tolerance* :
+                grid intervals that hold more than this fraction of the posterior mass are refined (0, the default, for a fixed grid)
+            *nthreads* :
+                number of threads that evaluate the grid points
         """
         if check_kwargs ( kwargs, ASIRInference.__init__.__doc__ ):
             msg = "Unknown parameter '%s'. See docstring for valid arguments" % (check_kwargs(kwargs, ASIRInference.__init__.__doc__ ),)
@@ -1916,7 +1922,9 @@ class ASIRInference ( PsiInference ):
 
         self.__inference = interface.asir ( self.data, nsamples=self.Nsamples,
                 nafc=self.model['nafc'], sigmoid=self.model['sigmoid'], core=self.model['core'],
-                priors=self.model['priors'], gammaislambda=self.model['gammaislambda'], propose=kwargs.setdefault ( "propose", 25 ) )
+                priors=self.model['priors'], gammaislambda=self.model['gammaislambda'], propose=kwargs.setdefault ( "propose", 25 ),
+                gridsize=kwargs.setdefault ( "gridsize", 100 ), tolerance=kwargs.setdefault ( "tolerance", 0 ),
+                nthreads=kwargs.setdefault ( "nthreads", 1 ) )
         self._data,self._pmf,self.nparams = sfu.make_dataset_and_pmf (
                 self.data, self.model["nafc"], self.model["sigmoid"], self.model["core"], self.model["priors"], gammaislambda=self.model["gammaislambda"] )
 
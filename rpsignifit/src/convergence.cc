@@ -0,0 +1 @@
+../../src/convergence.cc
\ No newline at end of file
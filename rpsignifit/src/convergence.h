@@ -0,0 +1 @@
+../../src/convergence.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/parallel.cc
\ No newline at end of file
@@ -398,6 +398,40 @@ void pmfevaluate (
 	return;
 }
 
+void mcmcconvergence (
+		double *samples,      // samples, one row per sample (chain after chain), one column per variable
+		int *nsamples,        // number of samples
+		int *nvariables,      // number of variables
+		int *nchains,         // number of chains that are stored one after another
+		int *maxlag,          // largest lag of the autocorrelation function
+		double *ess,          // output: effective sample size of the mean
+		double *bulkess,      // output: effective sample size of the rank normalized samples
+		double *tailess,      // output: effective sample size of the 5% and 95% quantiles
+		double *mcse,         // output: monte carlo standard error of the mean
+		double *geweke,       // output: Geweke z-scores, nvariables x nchains
+		double *acf           // output: autocorrelations, nvariables x (maxlag+1)
+		) {
+	int i,j;
+	std::vector<double> draws ( *nsamples );
+	PsiChainDiagnostics diag ( *nchains, *maxlag );
+
+	for ( j=0; j<*nvariables; j++ ) {
+		for ( i=0; i<*nsamples; i++ )
+			draws[i] = samples[i*(*nvariables)+j];
+		diag.addVariable ( draws );
+
+		ess[j]     = diag.getESS ( j );
+		bulkess[j] = diag.getBulkESS ( j );
+		tailess[j] = diag.getTailESS ( j );
+		mcse[j]    = diag.getMCSE ( j );
+		for ( i=0; i<*nchains; i++ )
+			geweke[j*(*nchains)+i] = diag.getGeweke ( j, i );
+		for ( i=0; i<=*maxlag; i++ )
+			acf[j*(*maxlag+1)+i] = ( i<*nsamples/(*nchains) ? diag.getAutocorrelation ( j, i ) : 0 );
+	}
+
+	return;
+}
 
 // Some more?
 }
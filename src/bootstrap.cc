@@ -5,6 +5,7 @@
 #include "bootstrap.h"
 #include "getstart.h"
 #include "rng.h"
+#include "parallel.h"
 
 #ifdef DEBUG_BOOTSTRAP
 #include <iostream>
@@ -45,22 +46,98 @@ void determineBCa ( const std::vector<double>& l_LF, const std::vector<double>&
 	*acc  = E_l3 / (6*var_l*var_l*var_l);
 }
 
-BootstrapList bootstrap ( unsigned int B, const PsiData * data, const PsiPsychometric* model, std::vector<double> cuts, std::vector<double>* param, bool BCa, bool parametric )
+/** \brief fits of the bootstrap samples
+ *
+ * All resamples are drawn in the calling thread before the fits start. The job only fits and
+ * characterizes the samples with indices in todo. Every result is written to the slot of its
+ * sample index, which makes the outcome independent of the number of threads.
+ */
+class BootstrapJob : public PsiParallelJob
+{
+	private:
+		const PsiData * data;
+		const PsiPsychometric * model;
+		const std::vector<double>& cuts;
+		const std::vector<double>& initialfit;
+		const std::vector< std::vector<int> >& samples;
+		const std::vector<unsigned int>& todo;
+		BootstrapList * bootstrapsamples;
+		std::vector< std::vector<double> > * l_LF;
+		std::vector< std::vector<double> > * u_t;
+		std::vector< std::vector<double> > * u_s;
+		std::vector<int> * valid;
+		PsiOptimizerMethod method;
+		std::vector<PsiRefitContext*> refitters;     // every thread has its own simplex
+		BootstrapJob ( const BootstrapJob& );
+		BootstrapJob& operator= ( const BootstrapJob& );
+	public:
+		BootstrapJob (
+			const PsiData * d, const PsiPsychometric * pmf, const std::vector<double>& c, const std::vector<double>& fit,
+			const std::vector< std::vector<int> >& s, const std::vector<unsigned int>& t, BootstrapList * out,
+			std::vector< std::vector<double> > * lf, std::vector< std::vector<double> > * ut, std::vector< std::vector<double> > * us,
+			std::vector<int> * v, PsiOptimizerMethod m, unsigned int nthreads )
+			: data ( d ), model ( pmf ), cuts ( c ), initialfit ( fit ), samples ( s ), todo ( t ), bootstrapsamples ( out ),
+			l_LF ( lf ), u_t ( ut ), u_s ( us ), valid ( v ), method ( m ), refitters ( nthreads, (PsiRefitContext*)NULL ) {}
+		~BootstrapJob ( void );
+		void process ( unsigned int i, unsigned int thread );
+};
+
+BootstrapJob::~BootstrapJob ( void )
+{
+	unsigned int i;
+	for ( i=0; i<refitters.size(); i++ )
+		delete refitters[i];
+}
+
+void BootstrapJob::process ( unsigned int i, unsigned int thread )
+{
+	unsigned int b ( todo[i] ), cut;
+	const PsiData * localdataset;
+	std::vector<double> localfit;
+	std::vector<double> devianceresiduals;
+	double deviance;
+
+	if ( refitters[thread]==NULL )
+		refitters[thread] = new PsiRefitContext ( model, data, &initialfit, method );
+
+	// Fit
+	localfit = refitters[thread]->refit ( samples[b] );
+	localdataset = refitters[thread]->getData ();
+
+	// Get some characteristics of the localfit
+	deviance = model->deviance ( localfit, localdataset );
+	devianceresiduals = model->getDevianceResiduals ( localfit, localdataset );
+	bootstrapsamples->setEst ( b, localfit, deviance );
+	bootstrapsamples->setRpd ( b, model->getRpd( devianceresiduals, localfit, localdataset ) );
+	bootstrapsamples->setRkd ( b, model->getRkd( devianceresiduals, localdataset ) );
+
+	// Store what we need for the BCa stuff
+	(*valid)[b] = 1;
+	for (cut=0; cut<cuts.size(); cut++) {
+		(*l_LF)[cut][b] = model->leastfavourable ( localfit, localdataset, cuts[cut] );
+		(*u_t)[cut][b]  = model->getThres(localfit,cuts[cut]);
+		(*u_s)[cut][b]  = model->getSlope(localfit,(*u_t)[cut][b]);
+		bootstrapsamples->setThres((*u_t)[cut][b], b, cut);
+		bootstrapsamples->setSlope((*u_s)[cut][b], b, cut);
+
+		// TODO: if l_LF is nan we don't take this sample
+		// TODO: This is not the best solution but it works (kindof)
+		if ( (*l_LF)[cut][b] != (*l_LF)[cut][b] )
+			(*valid)[b] = 0;
+	}
+}
+
+BootstrapList bootstrap ( unsigned int B, const PsiData * data, const PsiPsychometric* model, std::vector<double> cuts, std::vector<double>* param, bool BCa, bool parametric, unsigned int nthreads, PsiOptimizerMethod method, PsiRandomEngine * engine )
 {
 #ifdef DEBUG_BOOTSTRAP
-	int l;
 	std::cerr << "Starting bootstrap\n Cuts size=" << cuts.size() << " "; std::cerr.flush();
 #endif
 	BootstrapList bootstrapsamples ( B, model->getNparams(), data->getNblocks(), cuts );
-	unsigned int b,k,cut;                               // iteration variables for bootstrap sample, block, l-general purpose third level iteration, cut
+	unsigned int b,k,cut;                               // iteration variables for bootstrap sample, block, cut
 	std::vector< std::vector<double> > l_LF (cuts.size(), std::vector<double>(B));   // vector of double-vectors
 	std::vector< std::vector<double> > u_t  (cuts.size(), std::vector<double>(B));
 	std::vector< std::vector<double> > u_s  (cuts.size(), std::vector<double>(B));
-	PsiOptimizer opt ( model, data );                          // for ML-Fitting
-	PsiData * localdataset = new PsiData ( data->getIntensities(),  // local because it changes in every iteration
-			data->getNtrials(),
-			data->getNcorrect(),
-			data->getNalternatives() );
+	PsiOptimizer opt ( model, data, method );                  // for ML-Fitting
 
 	std::vector<double> initialfit ( model->getNparams() );       // generating parameters for the bootstrap samples
 	std::vector<double> incr       ( model->getNparams() );
@@ -75,73 +152,44 @@ BootstrapList bootstrap ( unsigned int B, const PsiData * data, const PsiPsychom
 		initialfit = *param;
 	std::vector<double> p          ( data->getNblocks() );       // predicted p-correct for parametric bootstrap
 	if (parametric) {
-		for ( k=0; k<data->getNblocks(); k++ ) { p[k] = model->evaluate ( data->getIntensity(k), initialfit ); }
+		model->evaluate_batch ( initialfit, data, &p );
 	} else {
 		for ( k=0; k<data->getNblocks(); k++ ) { p[k] = data->getPcorrect( k ); }
 	}
 
-	std::vector<double> localfit   ( model->getNparams() );
-	std::vector<int>    sample     ( data->getNblocks() );
+	std::vector< std::vector<int> > samples ( B, std::vector<int> ( data->getNblocks() ) );
+	std::vector<int>    valid      ( B, 0 );
+	std::vector<unsigned int> todo ( B );
 	std::vector<double> initialthresholds ( cuts.size() );
 	std::vector<double> initialslopes     ( cuts.size() );
-	std::vector<double> devianceresiduals ( data->getNblocks() );
-	double deviance;
 
 	for (cut=0; cut<cuts.size(); cut++) {
 		initialthresholds[cut] = model->getThres(initialfit,cuts[cut]);
 		initialslopes[cut]     = model->getSlope(initialfit,initialthresholds[cut]);
 	}
 
-	for ( b=0; b<B; b++ ) {
-		// Resampling
-		newsample ( data, p, &sample );         // draw a new sample
-		localdataset->setNcorrect ( sample );   // put the new sample to the localdataset
-		bootstrapsamples.setData ( b, sample ); // store the new sample in the mc object
+	if ( nthreads<1 )
+		nthreads = 1;
+	BootstrapJob job ( data, model, cuts, initialfit, samples, todo, &bootstrapsamples, &l_LF, &u_t, &u_s, &valid, method, nthreads );
 
-		// Fit
-		localfit = opt.optimize (model, localdataset, &initialfit );
-#ifdef DEBUG_BOOTSTRAP
-		for (l=0; l<sample.size(); l++)
-			std::cerr << " " << sample[l] << "\n";
-		std::cerr << localfit[0] << " " << localfit[1] << " " << localfit[2] << "\n";
-#endif
+	for ( b=0; b<B; b++ ) todo[b] = b;
+	while ( todo.size()>0 ) {
+		// Resampling is done serially to keep the random sequence independent of the number of threads
+		for ( b=0; b<todo.size(); b++ ) {
+			newsample ( data, p, &(samples[todo[b]]), engine );
+			bootstrapsamples.setData ( todo[b], samples[todo[b]] );
+		}
 
-		// Get some characteristics of the localfit
-		deviance = model->deviance ( localfit, localdataset );
-		devianceresiduals = model->getDevianceResiduals ( localfit, localdataset );
-		bootstrapsamples.setEst ( b, localfit, deviance );
-		bootstrapsamples.setRpd ( b, model->getRpd( devianceresiduals, localfit, localdataset ) );
-		bootstrapsamples.setRkd ( b, model->getRkd( devianceresiduals, localdataset ) );
+		// Fitting
+		run_parallel ( &job, todo.size(), nthreads );
 
-		// Store what we need for the BCa stuff
-		for (cut=0; cut<cuts.size(); cut++) {
-			l_LF[cut][b] = model->leastfavourable ( localfit, localdataset, cuts[cut] );
-#ifdef DEBUG_BOOTSTRAP
-			if (l_LF[cut][b] != l_LF[cut][b]) {
-				std::cerr << "deviance = " << deviance << "\n";
-				std::cerr << "l_LF["<<cut<<"]["<<b<<"] = " << l_LF[cut][b] << "\n";
-			}
-#endif
-			u_t[cut][b]  = model->getThres(localfit,cuts[cut]);
-			u_s[cut][b]  = model->getSlope(localfit,u_t[cut][b]);
-#ifdef DEBUG_BOOTSTRAP
-			if (l_LF[cut][b]!= l_LF[cut][b]) {
-				std::cerr << "u_t["<<cut<<"]["<<b<<"] = " << u_t[cut][b] << "\n";
-			}
-#endif
-			bootstrapsamples.setThres(u_t[cut][b], b, cut);
-			bootstrapsamples.setSlope(u_s[cut][b], b, cut);
-
-			if (l_LF[cut][b] != l_LF[cut][b]) {
-				// TODO: if l_LF is nan we don't take this sample
-				// TODO: This is not the best solution but it works (kindof)
-				b--;
-				continue;
-			}
-		}
+		// Samples with undefined least favourable direction are drawn again
+		for ( k=0,b=0; b<todo.size(); b++ )
+			if ( !valid[todo[b]] )
+				todo[k++] = todo[b];
+		todo.resize ( k );
 	}
 
-
 	// Calculate BCa constants
 	double bias, acc;
 	for (cut=0; cut<cuts.size(); cut++) {
@@ -151,45 +199,20 @@ BootstrapList bootstrap ( unsigned int B, const PsiData * data, const PsiPsychom
 		bootstrapsamples.setBCa_s(cut, bias, acc );
 	}
 
-	delete localdataset;
-
 	return bootstrapsamples;
 }
 
-JackKnifeList jackknifedata ( const PsiData * data, const PsiPsychometric* model )
+JackKnifeList jackknifedata ( const PsiData * data, const PsiPsychometric* model, PsiOptimizerMethod method )
 {
-	PsiOptimizer *opt = new PsiOptimizer( model, data );
-	std::vector<double> mlestimate ( opt->optimize( model, data ) );
+	PsiRefitContext refitter ( model, data, NULL, method );
+	std::vector<double> mlestimate ( refitter.getReference() );
 	std::vector<double> estimate ( mlestimate );
-	delete opt;
 	JackKnifeList jackknife ( data->getNblocks(), model->getNparams(), model->deviance(mlestimate, data), mlestimate );
-	PsiData * localdata;
-
-	std::vector<double> x ( data->getNblocks()-1 );
-	std::vector<int> k ( data->getNblocks()-1 );
-	std::vector<int> n ( data->getNblocks()-1 );
-	unsigned int i,j,l,exclude(0);
+	unsigned int i;
 
 	for ( i=0; i<data->getNblocks(); i++ ) {
-		exclude=i;
-		j=0;
-		for (l=0; l<data->getNblocks(); l++) {
-			if (l!=exclude) {
-				x[j] = data->getIntensity(l);
-				k[j] = data->getNcorrect(l);
-				n[j] = data->getNtrials(l);
-				j++;
-			}
-		}
-
-		localdata = new PsiData ( x,n,k,data->getNalternatives() );
-		opt       = new PsiOptimizer ( model, localdata );
-
-		estimate = opt->optimize( model, localdata, &mlestimate );
-		jackknife.setEst ( i, estimate, model->deviance(estimate,localdata) );
-
-		delete localdata;
-		delete opt;
+		estimate = refitter.refit ( i );
+		jackknife.setEst ( i, estimate, model->deviance(estimate,refitter.getData()) );
 	}
 
 	return jackknife;
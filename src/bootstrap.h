@@ -15,6 +15,10 @@
  *
  * A parametric bootstrap is performed by sampling from a binomial distribution with success probability given by the psychometric
  * function. if BCa is true, bias correction and acceleration constant are calculated for the cuts given in cuts.
+ *
+ * The bootstrap samples are drawn serially, fitting them can be distributed over nthreads threads. For a given seed, the
+ * resulting BootstrapList is the same for any number of threads. Several bootstraps can run concurrently if each of them
+ * draws from its own engine.
  */
 BootstrapList bootstrap (
 		unsigned int B,                        ///< number of bootstrap samples
@@ -23,7 +27,10 @@ BootstrapList bootstrap (
 		std::vector<double> cuts,     ///< performance levels at which the threshold should be calculated
 		std::vector<double>* param=NULL,   ///< parameter vector on which parametric bootstrap should be based
 		bool BCa=true,                ///< calculate bias correction and acceleration?
-		bool parametric=true          ///< Perform parametric bootstrap?
+		bool parametric=true,         ///< Perform parametric bootstrap?
+		unsigned int nthreads=1,      ///< number of threads that fit the bootstrap samples (the result does not depend on this)
+		PsiOptimizerMethod method=OPTIMIZER_SIMPLEX,  ///< optimization method used to fit the data and the bootstrap samples
+		PsiRandomEngine * engine=NULL          ///< engine to draw the bootstrap samples from (NULL means the global generator)
 		);
 
 /** \brief perform jackkifing to detect influential observations and outliers
@@ -33,9 +40,13 @@ BootstrapList bootstrap (
  *
  * Wichmann & Hill (2001) The psychometric function: I. Fitting, sampling, and goodness of fit. Perception & Psychophysics, 63(8), 1293--1313.
  */
-JackKnifeList jackknifedata ( const PsiData * data, const PsiPsychometric* model );
+JackKnifeList jackknifedata (
+		const PsiData * data,         ///< data that are to be jackknifed
+		const PsiPsychometric* model, ///< model to be fitted
+		PsiOptimizerMethod method=OPTIMIZER_SIMPLEX   ///< optimization method used to fit the full and the reduced data sets
+		);
 
 
-void newsample ( const PsiData * data, const std::vector<double>& p, std::vector<int> * sample );
+void newsample ( const PsiData * data, const std::vector<double>& p, std::vector<int> * sample, PsiRandomEngine * engine );
 
 #endif
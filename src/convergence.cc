@@ -0,0 +1,323 @@
+/*
+ *   See COPYING file distributed along with the psignifit package for
+ *   the copyright and license terms
+ */
+#include "convergence.h"
+#include "special.h"
+
+#include <complex>
+#include <algorithm>
+
+/**********************************************************************
+ *
+ * Autocovariance
+ *
+ */
+
+/* in place radix 2 fourier transform, the length of a has to be a power of two */
+static void fft ( std::vector< std::complex<double> >& a, bool inverse )
+{
+	unsigned int i, j, k, len, n ( a.size() );
+	double angle;
+	std::complex<double> w, wlen, u, v;
+
+	// bit reversal permutation
+	for ( i=1, j=0; i<n; i++ ) {
+		k = n>>1;
+		for ( ; j&k; k>>=1 )
+			j ^= k;
+		j ^= k;
+		if ( i<j )
+			std::swap ( a[i], a[j] );
+	}
+
+	for ( len=2; len<=n; len<<=1 ) {
+		angle = 2*M_PI/len * ( inverse ? 1 : -1 );
+		wlen = std::complex<double> ( cos ( angle ), sin ( angle ) );
+		for ( i=0; i<n; i+=len ) {
+			w = 1;
+			for ( j=0; j<len/2; j++ ) {
+				u = a[i+j];
+				v = a[i+j+len/2]*w;
+				a[i+j] = u+v;
+				a[i+j+len/2] = u-v;
+				w *= wlen;
+			}
+		}
+	}
+
+	if ( inverse )
+		for ( i=0; i<n; i++ )
+			a[i] /= n;
+}
+
+void autocovariance ( const double * x, unsigned int n, std::vector<double> * acov )
+{
+	unsigned int i, N ( 1 );
+	double m ( 0 );
+
+	acov->assign ( n, 0 );
+	if ( n==0 )
+		return;
+
+	for ( i=0; i<n; i++ )
+		m += x[i];
+	m /= n;
+
+	// zero padding to at least 2n avoids the circular wrap around
+	while ( N<2*n )
+		N <<= 1;
+	std::vector< std::complex<double> > a ( N, 0. );
+	for ( i=0; i<n; i++ )
+		a[i] = x[i]-m;
+
+	fft ( a, false );
+	for ( i=0; i<N; i++ )
+		a[i] = std::norm ( a[i] );
+	fft ( a, true );
+
+	for ( i=0; i<n; i++ )
+		(*acov)[i] = a[i].real()/n;
+}
+
+/**********************************************************************
+ *
+ * Split-Rhat and effective sample size
+ *
+ */
+
+static std::vector< std::vector<double> > splitchains ( const std::vector< std::vector<double> >& draws )
+{
+	unsigned int k, n ( draws[0].size()/2 );
+	std::vector< std::vector<double> > halves;
+
+	for ( k=0; k<draws.size(); k++ ) {
+		if ( draws[k].size()/2!=n )
+			throw BadArgumentError ( "All chains should have the same length" );
+		// for odd lengths, the central sample is dropped
+		halves.push_back ( std::vector<double> ( draws[k].begin(), draws[k].begin()+n ) );
+		halves.push_back ( std::vector<double> ( draws[k].end()-n, draws[k].end() ) );
+	}
+	if ( n<2 )
+		throw BadArgumentError ( "Chains should have at least 4 samples" );
+
+	return halves;
+}
+
+/* means, within variance and pooled variance estimate of the chains */
+static void chainvariances ( const std::vector< std::vector<double> >& halves, std::vector<double> *means, double *W, double *varplus )
+{
+	unsigned int i,m, M ( halves.size() ), n ( halves[0].size() );
+	double grandmean ( 0 ), B ( 0 ), s2;
+
+	*W = 0;
+	for ( m=0; m<M; m++ ) {
+		(*means)[m] = 0;
+		for ( i=0; i<n; i++ )
+			(*means)[m] += halves[m][i];
+		(*means)[m] /= n;
+		grandmean += (*means)[m];
+
+		s2 = 0;
+		for ( i=0; i<n; i++ )
+			s2 += (halves[m][i]-(*means)[m])*(halves[m][i]-(*means)[m]);
+		*W += s2/(n-1);
+	}
+	grandmean /= M;
+	*W /= M;
+
+	if ( M>1 ) {
+		for ( m=0; m<M; m++ )
+			B += ((*means)[m]-grandmean)*((*means)[m]-grandmean);
+		B *= double(n)/(M-1);
+	}
+
+	*varplus = (n-1)*(*W)/n + B/n;
+}
+
+/* effective sample size of chains that are used as they are (not split) */
+static double chainsESS ( const std::vector< std::vector<double> >& chains )
+{
+	unsigned int m,t, M ( chains.size() ), n ( chains[0].size() );
+	std::vector<double> means ( M ), acov ( n, 0 ), chainacov;
+	double W, varplus, rho[2], P, Pold, tau;
+	bool constant ( true );
+
+	// constant draws would only leave rounding errors in the variances
+	for ( m=0; m<M && constant; m++ )
+		for ( t=0; t<n && constant; t++ )
+			constant = chains[m][t]==chains[0][0];
+	if ( constant )
+		return M*n;
+
+	chainvariances ( chains, &means, &W, &varplus );
+	if ( !(varplus>0) )
+		return M*n;
+
+	for ( m=0; m<M; m++ ) {
+		autocovariance ( &(chains[m][0]), n, &chainacov );
+		for ( t=0; t<n; t++ )
+			acov[t] += chainacov[t]/M;
+	}
+
+	// Geyer's initial monotone sequence: sum pairs of autocorrelations while they are positive and decreasing
+	tau = -1;
+	Pold = 1e300;
+	for ( t=0; t+1<n; t+=2 ) {
+		rho[0] = ( t==0 ? 1 : 1 - (W-acov[t])/varplus );
+		rho[1] = 1 - (W-acov[t+1])/varplus;
+		P = rho[0]+rho[1];
+		if ( P<=0 )
+			break;
+		if ( P>Pold )
+			P = Pold;
+		tau += 2*P;
+		Pold = P;
+	}
+
+	return M*n/tau;
+}
+
+double splitRhat ( const std::vector< std::vector<double> >& draws )
+{
+	std::vector< std::vector<double> > halves ( splitchains ( draws ) );
+	std::vector<double> means ( halves.size() );
+	double W, varplus;
+
+	chainvariances ( halves, &means, &W, &varplus );
+
+	return sqrt ( varplus/W );
+}
+
+double effectiveSampleSize ( const std::vector< std::vector<double> >& draws )
+{
+	return chainsESS ( splitchains ( draws ) );
+}
+
+/**********************************************************************
+ *
+ * PsiChainDiagnostics
+ *
+ */
+
+PsiChainDiagnostics::PsiChainDiagnostics ( unsigned int Nchains, unsigned int Maxlag )
+	: nchains ( Nchains ), maxlag ( Maxlag )
+{
+	if ( nchains==0 )
+		throw BadArgumentError ( "PsiChainDiagnostics: at least one chain is needed" );
+}
+
+PsiChainDiagnostics::PsiChainDiagnostics ( const MCMCList& samples, unsigned int Nchains, unsigned int Maxlag, const PsiPsychometric * pmf, const std::vector<double>& cuts )
+	: nchains ( Nchains ), maxlag ( Maxlag )
+{
+	unsigned int i, j, N ( samples.getNsamples() );
+	std::vector<double> est ( samples.getNparams() ), thres ( N );
+
+	if ( nchains==0 )
+		throw BadArgumentError ( "PsiChainDiagnostics: at least one chain is needed" );
+
+	for ( j=0; j<samples.getNparams(); j++ )
+		addVariable ( samples.getColumn ( j ), N );
+
+	if ( pmf==NULL )
+		return;
+	for ( j=0; j<cuts.size(); j++ ) {
+		for ( i=0; i<N; i++ ) {
+			samples.copyEst ( i, &est );
+			thres[i] = pmf->getThres ( est, cuts[j] );
+		}
+		addVariable ( thres );
+	}
+}
+
+unsigned int PsiChainDiagnostics::addVariable ( const double * draws, unsigned int n )
+{
+	unsigned int i, j, k, m, t, S ( n ), nlags, len ( n/nchains );
+	double m1 ( 0 ), m2 ( 0 ), q05, q95, r, da, db, va, vb, essa, essb;
+	std::vector< std::vector<double> > chains ( nchains ), work ( nchains );
+	std::vector<double> sorted ( draws, draws+n ), acov;
+
+	if ( n%nchains!=0 || len<4 )
+		throw BadArgumentError ( "PsiChainDiagnostics: every chain needs the same number of samples (at least 4)" );
+
+	for ( m=0; m<nchains; m++ )
+		chains[m].assign ( draws+m*len, draws+(m+1)*len );
+
+	// mean and standard deviation
+	for ( i=0; i<n; i++ )
+		m1 += draws[i];
+	m1 /= n;
+	for ( i=0; i<n; i++ )
+		m2 += (draws[i]-m1)*(draws[i]-m1);
+	mean.push_back ( m1 );
+	sd.push_back ( sqrt ( m2/(n-1) ) );
+	ess.push_back ( effectiveSampleSize ( chains ) );
+
+	// bulk: rank normalized draws, ties get their average rank
+	std::sort ( sorted.begin(), sorted.end() );
+	for ( m=0; m<nchains; m++ )
+		work[m].resize ( len );
+	for ( i=0; i<n; i++ ) {
+		j = std::lower_bound ( sorted.begin(), sorted.end(), draws[i] ) - sorted.begin();
+		k = std::upper_bound ( sorted.begin(), sorted.end(), draws[i] ) - sorted.begin();
+		r = 0.5*(j+1+k);
+		work[i/len][i%len] = invPhi ( (r-0.375)/(S+0.25) );
+	}
+	bulkess.push_back ( effectiveSampleSize ( work ) );
+
+	// tail: indicators of the 5% and the 95% quantiles
+	q05 = sorted[(unsigned int)(0.05*(n-1))];
+	q95 = sorted[(unsigned int)(0.95*(n-1))];
+	for ( i=0; i<n; i++ )
+		work[i/len][i%len] = ( draws[i]<=q05 ? 1 : 0 );
+	essa = effectiveSampleSize ( work );
+	for ( i=0; i<n; i++ )
+		work[i/len][i%len] = ( draws[i]<=q95 ? 1 : 0 );
+	essb = effectiveSampleSize ( work );
+	tailess.push_back ( essa<essb ? essa : essb );
+
+	// autocorrelation averaged over chains
+	nlags = ( maxlag+1<len ? maxlag+1 : len );
+	std::vector<double> rho ( nlags, 0 );
+	for ( m=0; m<nchains; m++ ) {
+		autocovariance ( &(chains[m][0]), len, &acov );
+		for ( t=0; t<nlags; t++ )
+			rho[t] += acov[t];
+	}
+	for ( t=nlags; t>0; t-- )
+		rho[t-1] = ( rho[0]>0 ? rho[t-1]/rho[0] : ( t==1 ? 1 : 0 ) );
+	acf.push_back ( rho );
+
+	// Geweke: first 10% against last 50% of every chain
+	std::vector<double> z ( nchains, 0 );
+	for ( m=0; m<nchains && len>=20; m++ ) {
+		std::vector< std::vector<double> > a ( 1, std::vector<double> ( chains[m].begin(), chains[m].begin()+len/10 ) );
+		std::vector< std::vector<double> > b ( 1, std::vector<double> ( chains[m].end()-len/2, chains[m].end() ) );
+		std::vector<double> meana ( 1 ), meanb ( 1 );
+		chainvariances ( a, &meana, &va, &da );
+		chainvariances ( b, &meanb, &vb, &db );
+		essa = chainsESS ( a );
+		essb = chainsESS ( b );
+		if ( va/essa + vb/essb > 0 )
+			z[m] = ( meana[0]-meanb[0] ) / sqrt ( va/essa + vb/essb );
+	}
+	geweke.push_back ( z );
+
+	return mean.size()-1;
+}
+
+double PsiChainDiagnostics::getAutocorrelation ( unsigned int var, unsigned int lag ) const
+{
+	checkindex ( var );
+	if ( lag>=acf[var].size() )
+		throw BadIndexError ();
+	return acf[var][lag];
+}
+
+double PsiChainDiagnostics::getGeweke ( unsigned int var, unsigned int chain ) const
+{
+	checkindex ( var );
+	if ( chain>=nchains )
+		throw BadIndexError ();
+	return geweke[var][chain];
+}
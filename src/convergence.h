@@ -0,0 +1,104 @@
+/*
+ *   See COPYING file distributed along with the psignifit package for
+ *   the copyright and license terms
+ */
+#ifndef CONVERGENCE_H
+#define CONVERGENCE_H
+
+#include <vector>
+#include "errors.h"
+#include "mclist.h"
+#include "psychometric.h"
+
+/** \brief autocovariance of a sequence for all lags
+ *
+ * The sequence is centered at its mean and the autocovariances are determined by a fast fourier transform
+ * of the zero padded sequence. Thus, all lags are obtained in O(n log n) instead of O(n^2) time.
+ * acov[t] = 1/n sum_{i=0}^{n-t-1} (x[i]-m)*(x[i+t]-m) for t=0,...,n-1.
+ */
+void autocovariance (
+		const double * x,             ///< the sequence
+		unsigned int n,               ///< length of the sequence
+		std::vector<double> * acov    ///< output: autocovariances at lags 0,...,n-1 (resized to n)
+		);
+
+/** \brief split-Rhat convergence diagnostic
+ *
+ * Every chain is split into two halves and the variance between the halves is compared to the variance
+ * within the halves. Values close to 1 indicate that all chains sample from the same distribution.
+ */
+double splitRhat ( const std::vector< std::vector<double> >& draws );
+
+/** \brief effective sample size of a set of chains
+ *
+ * The autocorrelations are combined over all (split) chains and summed using Geyer's initial
+ * monotone sequence estimator.
+ */
+double effectiveSampleSize ( const std::vector< std::vector<double> >& draws );
+
+/** \brief convergence diagnostics for mcmc samples
+ *
+ * For every variable, this determines
+ * - the autocorrelation function (up to maxlag),
+ * - the effective sample size of the mean (split chains, see effectiveSampleSize()),
+ * - the bulk effective sample size (effective sample size of the rank normalized draws) and the tail effective
+ *   sample size (smaller of the effective sample sizes of the indicators of the 5% and the 95% quantile),
+ *   following Vehtari et al (2021),
+ * - the monte carlo standard error of the mean,
+ * - Geweke's z-score for every chain: the difference between the means of the first 10% and of the last 50% of
+ *   the chain, divided by its standard error (which accounts for the autocorrelation of both parts).
+ *
+ * Variables are the parameters of an MCMCList and, if a model and cuts are given, the thresholds at the cuts.
+ * Further variables can be added with addVariable(). A list that combines several chains (like the list returned
+ * by MultiChainMCMC::sample()) is split into nchains chains of equal length.
+ */
+class PsiChainDiagnostics
+{
+	private:
+		unsigned int nchains;
+		unsigned int maxlag;
+		std::vector<double> mean;
+		std::vector<double> sd;
+		std::vector<double> ess;
+		std::vector<double> bulkess;
+		std::vector<double> tailess;
+		std::vector< std::vector<double> > acf;
+		std::vector< std::vector<double> > geweke;
+		void checkindex ( unsigned int var ) const { if ( var>=mean.size() ) throw BadIndexError (); }
+	public:
+		PsiChainDiagnostics (
+			unsigned int Nchains=1,                        ///< number of chains in every variable
+			unsigned int Maxlag=100                        ///< largest lag of the autocorrelation functions
+			);                           ///< set up diagnostics without any variables
+		PsiChainDiagnostics (
+			const MCMCList& samples,                       ///< mcmc samples
+			unsigned int Nchains=1,                        ///< number of chains that are stored one after another in samples
+			unsigned int Maxlag=100,                       ///< largest lag of the autocorrelation functions
+			const PsiPsychometric * pmf=NULL,              ///< model to determine thresholds for every sample (NULL for parameters only)
+			const std::vector<double>& cuts=std::vector<double>()   ///< cuts at which the thresholds are determined
+			);                           ///< diagnostics for all parameters (variables 0,...,nparams-1) and thresholds (variables nparams,...)
+		unsigned int addVariable (
+			const double * draws,                          ///< all draws of the variable, chain after chain
+			unsigned int n                                 ///< number of draws (a multiple of the number of chains, at least 4 per chain)
+			);                           ///< determine the diagnostics of another variable and return its index
+		unsigned int addVariable ( const std::vector<double>& draws ) { return addVariable ( &(draws[0]), draws.size() ); }  ///< determine the diagnostics of another variable and return its index
+		unsigned int getNvariables ( void ) const { return mean.size(); }                            ///< number of variables
+		unsigned int getNchains ( void ) const { return nchains; }                                  ///< number of chains per variable
+		unsigned int getMaxlag ( void ) const { return maxlag; }                                    ///< largest lag of the autocorrelation functions
+		double getMean ( unsigned int var ) const { checkindex ( var ); return mean[var]; }          ///< mean of all draws
+		double getStd ( unsigned int var ) const { checkindex ( var ); return sd[var]; }             ///< standard deviation of all draws
+		double getESS ( unsigned int var ) const { checkindex ( var ); return ess[var]; }            ///< effective sample size of the mean
+		double getBulkESS ( unsigned int var ) const { checkindex ( var ); return bulkess[var]; }    ///< effective sample size of the rank normalized draws
+		double getTailESS ( unsigned int var ) const { checkindex ( var ); return tailess[var]; }    ///< effective sample size of the 5% and 95% quantiles
+		double getMCSE ( unsigned int var ) const { checkindex ( var ); return sd[var]/sqrt(ess[var]); }   ///< monte carlo standard error of the mean
+		double getAutocorrelation (
+			unsigned int var,                              ///< variable
+			unsigned int lag                               ///< lag (at most getMaxlag() and less than the length of the chains)
+			) const;                     ///< autocorrelation at lag, averaged over chains
+		double getGeweke (
+			unsigned int var,                              ///< variable
+			unsigned int chain=0                           ///< chain
+			) const;                     ///< Geweke's z-score of a chain (0 for chains shorter than 20 samples)
+};
+
+#endif
@@ -8,6 +8,13 @@
  * abCore methods
  */
 
+void abCore::g_batch ( const double * x, unsigned int n, const std::vector<double>& prm, double * out ) const {
+	unsigned int i;
+	double a ( prm[0] ), b ( prm[1] );
+	for ( i=0; i<n; i++ )
+		out[i] = (x[i]-a)/b;
+}
+
 double abCore::dg ( double x, const std::vector<double>& prm, int i ) const {
 	switch (i) {
 	case 0:
@@ -116,6 +123,13 @@ double mwCore::g ( double x, const std::vector<double>& prm ) const {
 	return zalpha*(x-prm[0])/prm[1] + zshift;
 }
 
+void mwCore::g_batch ( const double * x, unsigned int n, const std::vector<double>& prm, double * out ) const {
+	unsigned int i;
+	double m ( prm[0] ), w ( prm[1] );
+	for ( i=0; i<n; i++ )
+		out[i] = zalpha*(x[i]-m)/w + zshift;
+}
+
 double mwCore::dg ( double x, const std::vector<double>& prm, int i ) const {
 	switch (i) {
 		case 0:
@@ -174,6 +188,17 @@ std::vector<double> mwCore::transform ( int nprm, double a, double b ) const {
 	return out;
 }
 
+/************************************************************
+ * linearCore
+ */
+
+void linearCore::g_batch ( const double * x, unsigned int n, const std::vector<double>& prm, double * out ) const {
+	unsigned int i;
+	double a ( prm[0] ), b ( prm[1] );
+	for ( i=0; i<n; i++ )
+		out[i] = a * x[i] + b;
+}
+
 /************************************************************
  * logarithmicCore
  */
@@ -185,6 +210,18 @@ double logCore::g ( double x, const std::vector<double>& prm ) const throw(BadAr
 	return prm[0] * (x==0 ? -1e10 : log(x)) + prm[1];
 }
 
+void logCore::g_batch ( const double * x, unsigned int n, const std::vector<double>& prm, double * out ) const
+{
+	unsigned int i;
+	double a ( prm[0] ), b ( prm[1] );
+	// Check the range first, so that the actual loop is free of branches that could throw
+	for ( i=0; i<n; i++ )
+		if ( x[i]<0 )
+			throw BadArgumentError("logCore.g is only valid in the range x>=0");
+	for ( i=0; i<n; i++ )
+		out[i] = a * (x[i]==0 ? -1e10 : log(x[i])) + b;
+}
+
 logCore::logCore( const PsiData* data, const int sigmoid, const double alpha ) : scale(0) {
 	unsigned int i;
 	// we need this to scale starting values obtained from logistic regression so that they are correct "on average"
@@ -262,6 +299,14 @@ weibullCore::weibullCore( const PsiData* data, const int sigmoid, const double a
 	loglinb = meanlogx - loglina*meanx;
 }
 
+void weibullCore::g_batch ( const double * x, unsigned int n, const std::vector<double>& prm, double * out ) const
+{
+	unsigned int i;
+	double c ( twooverlog2*prm[0]*prm[1] ), logm ( log(prm[0]) );
+	for ( i=0; i<n; i++ )
+		out[i] = c * (log(x[i])-logm) + loglog2;
+}
+
 double weibullCore::dg ( double x, const std::vector<double>& prm, int i ) const throw(BadArgumentError)
 {
 	if (x<0)
@@ -355,6 +400,14 @@ polyCore::polyCore( const PsiData* data, const int sigmoid, const double alpha )
 	x2 = (x2<xmin ? xmin : x2 );
 }
 
+void polyCore::g_batch ( const double * x, unsigned int n, const std::vector<double>& prm, double * out ) const
+{
+	unsigned int i;
+	double a ( prm[0] ), b ( prm[1] );
+	for ( i=0; i<n; i++ )
+		out[i] = ( x[i]>0 ? pow ( x[i]/a, b ) : 0 );
+}
+
 double polyCore::dg ( double x, const std::vector<double>& prm, int i ) const
 {
 	if (x<0)
@@ -441,6 +494,16 @@ NakaRushton::NakaRushton ( const PsiData *data, const int sigmoid, const double
 	}
 }
 
+void NakaRushton::g_batch ( const double * x, unsigned int n, const std::vector<double>& prm, double * out ) const
+{
+	unsigned int i;
+	double k ( prm[1] ), sk ( pow ( prm[0], prm[1] ) ), xk;
+	for ( i=0; i<n; i++ ) {
+		xk = pow ( x[i], k );
+		out[i] = ( x[i]<0 ? 0 : xk / (sk+xk) );
+	}
+}
+
 double NakaRushton::dg ( double x, const std::vector<double>& prm, int i ) const
 {
 	double sigm, k;
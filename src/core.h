@@ -26,6 +26,12 @@ class PsiCore
 			double x,                       ///< stimulus intensity
 			const std::vector<double>& prm  ///< parameter vector
 			) const { throw NotImplementedError(); }          ///< evaluate the core of the sigmoid
+		virtual void g_batch (
+			const double * x,               ///< stimulus intensities
+			unsigned int n,                 ///< number of stimulus intensities
+			const std::vector<double>& prm, ///< parameter vector
+			double * out                    ///< output buffer for n values (may be the same as x)
+			) const { for ( unsigned int i=0; i<n; i++ ) out[i] = g ( x[i], prm ); } ///< evaluate the core at n stimulus intensities
 		virtual double dg (
 			double x,                       ///< stimulus intensity
 			const std::vector<double>& prm, ///< parameter vector
@@ -80,6 +86,12 @@ class abCore : public PsiCore
 			double x,                        ///< stimulus intensity
 			const std::vector<double>& prm   ///< parameter vector
 			) const { return (x-prm[0])/prm[1]; }            ///< evaluate the core of the sigmoid
+		void g_batch (
+			const double * x,                ///< stimulus intensities
+			unsigned int n,                  ///< number of stimulus intensities
+			const std::vector<double>& prm,  ///< parameter vector
+			double * out                     ///< output buffer for n values
+			) const;                                    ///< evaluate the core at n stimulus intensities
 		double dg (
 			double x,                        ///< stimulus intensity
 			const std::vector<double>& prm,  ///< parameter vector
@@ -144,6 +156,12 @@ class mwCore : public PsiCore
 			double x,                        ///< stimulus intensity
 			const std::vector<double>& prm   ///< parameter vector
 			) const;                                    ///< evaluate the core of the sigmoid
+		void g_batch (
+			const double * x,                ///< stimulus intensities
+			unsigned int n,                  ///< number of stimulus intensities
+			const std::vector<double>& prm,  ///< parameter vector
+			double * out                     ///< output buffer for n values
+			) const;                                    ///< evaluate the core at n stimulus intensities
 		double dg (
 			double x,                        ///< stimulus intensity
 			const std::vector<double>& prm,  ///< parameter vector
@@ -203,6 +221,12 @@ class linearCore : public PsiCore
 			double x,                           ///< stimulus intensity
 			const std::vector<double>& prm      ///< parameter vector
 			) const { return prm[0] * x + prm[1]; }   ///< evaluate the core of the sigmoid
+		void g_batch (
+			const double * x,                ///< stimulus intensities
+			unsigned int n,                  ///< number of stimulus intensities
+			const std::vector<double>& prm,  ///< parameter vector
+			double * out                     ///< output buffer for n values
+			) const;                                    ///< evaluate the core at n stimulus intensities
 		double dg (
 			double x,                           ///< stimululs intensity
 			const std::vector<double>& prm,     ///< parameter vector
@@ -260,6 +284,12 @@ class logCore : public PsiCore
 			double x,                                 ///< stimulus intensity
 			const std::vector<double>& prm            ///< parameter vector
 			) const throw(BadArgumentError);   ///< evaluate the core
+		void g_batch (
+			const double * x,                ///< stimulus intensities
+			unsigned int n,                  ///< number of stimulus intensities
+			const std::vector<double>& prm,  ///< parameter vector
+			double * out                     ///< output buffer for n values
+			) const;                                    ///< evaluate the core at n stimulus intensities
 		double dg  (
 			double x,                                 ///< stimulus intensity
 			const std::vector<double>& prm,           ///< parameter vector
@@ -324,6 +354,12 @@ class weibullCore : public PsiCore
 			double x,                           ///< stimulus intensity
 			const std::vector<double>& prm      ///< parameter vector (m,s,...)
 			) const { return twooverlog2*prm[0]*prm[1] * (log(x)-log(prm[0])) + loglog2; } ///< evaluate the weibull core
+		void g_batch (
+			const double * x,                ///< stimulus intensities
+			unsigned int n,                  ///< number of stimulus intensities
+			const std::vector<double>& prm,  ///< parameter vector
+			double * out                     ///< output buffer for n values
+			) const;                                    ///< evaluate the core at n stimulus intensities
 		double dg (
 			double x,                           ///< stimulus intensity
 			const std::vector<double>& prm,     ///< parameter vector
@@ -382,6 +418,12 @@ class polyCore : public PsiCore
 			double x,                                ///< stimulus intensity
 			const std::vector<double>& prm           ///< parameter vector (alpha,beta, ...)
 			) const { return (x>0 ? pow( x/prm[0], prm[1] ) : 0 ); }    ///< evaluate the polyCore
+		void g_batch (
+			const double * x,                ///< stimulus intensities
+			unsigned int n,                  ///< number of stimulus intensities
+			const std::vector<double>& prm,  ///< parameter vector
+			double * out                     ///< output buffer for n values
+			) const;                                    ///< evaluate the core at n stimulus intensities
 		double dg (
 			double x,                                ///< stimulus intensity
 			const std::vector<double>& prm,          ///< parameter vector
@@ -441,6 +483,12 @@ class NakaRushton : public PsiCore
 				double x,
 				const std::vector<double>& prm
 				) const { return (x<0 ? 0 : pow ( x, prm[1] ) / (pow(prm[0],prm[1])+pow(x,prm[1]))); }
+		void g_batch (
+				const double * x,
+				unsigned int n,
+				const std::vector<double>& prm,
+				double * out
+				) const;
 		double dg (
 				double x,
 				const std::vector<double>& prm,
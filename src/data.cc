@@ -42,6 +42,22 @@ PsiData::PsiData (
 	}
 }
 
+PsiData::PsiData (
+	const PsiData& data,
+	unsigned int excludeblock
+	) :
+	intensities ( data.intensities ), Ntrials ( data.Ntrials ), Ncorrect ( data.Ncorrect ), Pcorrect ( data.Pcorrect ), logNoverK ( data.logNoverK ), Nalternatives ( data.Nalternatives )
+{
+	if ( excludeblock>=intensities.size() )
+		throw BadArgumentError ( "PsiData: excluded block does not exist" );
+	intensities.erase ( intensities.begin()+excludeblock );
+	Ntrials.erase ( Ntrials.begin()+excludeblock );
+	Ncorrect.erase ( Ncorrect.begin()+excludeblock );
+	Pcorrect.erase ( Pcorrect.begin()+excludeblock );
+	if ( excludeblock<logNoverK.size() )
+		logNoverK.erase ( logNoverK.begin()+excludeblock );
+}
+
 /************************************************************
  * Setters                                                  *
  ************************************************************/
@@ -54,6 +70,32 @@ void PsiData::setNcorrect ( const std::vector<int>& newNcorrect )
 		Pcorrect[i] = double(Ncorrect[i])/Ntrials[i];
 }
 
+void PsiData::setLeaveOneOut ( const PsiData& data, unsigned int excludeblock )
+{
+	unsigned int i, j, nblocks ( data.intensities.size() );
+	if ( excludeblock>=nblocks )
+		throw BadArgumentError ( "PsiData: excluded block does not exist" );
+
+	intensities.resize ( nblocks-1 );
+	Ntrials.resize ( nblocks-1 );
+	Ncorrect.resize ( nblocks-1 );
+	Pcorrect.resize ( nblocks-1 );
+	logNoverK.resize ( data.logNoverK.size()>0 ? nblocks-1 : 0 );
+	Nalternatives = data.Nalternatives;
+
+	for ( i=0, j=0; i<nblocks; i++ ) {
+		if ( i==excludeblock )
+			continue;
+		intensities[j] = data.intensities[i];
+		Ntrials[j]     = data.Ntrials[i];
+		Ncorrect[j]    = data.Ncorrect[i];
+		Pcorrect[j]    = data.Pcorrect[i];
+		if ( j<logNoverK.size() )
+			logNoverK[j] = data.logNoverK[i];
+		j++;
+	}
+}
+
 /************************************************************
  * Getters                                                  *
  ************************************************************/
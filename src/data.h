@@ -41,10 +41,18 @@ class PsiData
 			std::vector<double> p,     ///< Fraction of correct trials at the respective stimulus intensities
 			int nAFC                   ///< Number of response alternatives (nAFC=1 ~> yes/no task)
 			);                                   ///< constructor
+		PsiData (
+			const PsiData& data,       ///< data set to be copied
+			unsigned int excludeblock  ///< index of the block that should be left out
+			);                                   ///< copy a data set without one block (e.g. for leave-one-out analyses)
 		~PsiData ( void ) {}
 		void setNcorrect (
 			const std::vector<int>& newNcorrect  ///< new number of correct responses
 			);  ///< set the number of correct responses (is probably only useful for bootstrap)
+		void setLeaveOneOut (
+			const PsiData& data,       ///< data set to be copied
+			unsigned int excludeblock  ///< index of the block that should be left out
+			);  ///< replace the blocks by those of data without one block (reuses the storage, e.g. for repeated jackknife fits)
 		const std::vector<double>& getIntensities ( void ) const;        ///< get the stimulus intensities
 		const std::vector<int>&    getNtrials ( void ) const;            ///< get the numbers of trials at the respective stimulus intensities
 		const std::vector<int>&    getNcorrect ( void ) const;           ///< get the numbers of correct trials at the respective stimulus intensities
@@ -1,4 +1,5 @@
 #include "getstart.h"
+#include "parallel.h"
 
 std::vector<double> linspace ( double xmin, double xmax, unsigned int n ) {
 	double dummy;
@@ -84,6 +85,92 @@ PsiGrid PsiGrid::subgrid ( void ) const
 	return PsiGrid ( xmin, xmax, get_gridsize() );
 }
 
+/************************************************** PsiGridBest methods ********************************************/
+
+PsiGridBest::PsiGridBest ( unsigned int nbest, unsigned int ndim ) :
+	nbest ( nbest ),
+	ndim ( ndim ),
+	nadded ( 0 ),
+	points ( nbest*ndim ),
+	L ( nbest ),
+	order ( nbest ),
+	sorted ( true )
+{
+	heap.reserve ( nbest );
+}
+
+bool PsiGridBest::add ( const double * point, double l )
+{
+	unsigned int i, slot, child, parent;
+	unsigned int n ( heap.size() );
+	if ( l!=l ) l = HUGE_VAL;     // undefined values rank last
+	nadded++;
+	if ( nbest==0 )
+		return false;
+
+	// Ties only matter if the point is already stored
+	for ( i=0; i<n; i++ ) {
+		slot = heap[i];
+		if ( L[slot]==l && std::equal ( point, point+ndim, &(points[slot*ndim]) ) )
+			return false;
+	}
+
+	if ( n<nbest ) {
+		// free slot: sift up from the bottom
+		slot = n;
+		heap.push_back ( slot );
+		L[slot] = l;
+		order[slot] = nadded;
+		std::copy ( point, point+ndim, &(points[slot*ndim]) );
+		for ( i=n; i>0; i=parent ) {
+			parent = (i-1)/2;
+			if ( !better ( heap[parent], heap[i] ) ) break;
+			std::swap ( heap[parent], heap[i] );
+		}
+	} else {
+		// replace the worst point on top and sift down
+		slot = heap[0];
+		if ( l>L[slot] )
+			return false;
+		L[slot] = l;
+		order[slot] = nadded;    // later points win ties
+		std::copy ( point, point+ndim, &(points[slot*ndim]) );
+		for ( i=0; (child=2*i+1)<n; i=child ) {
+			if ( child+1<n && better ( heap[child], heap[child+1] ) ) child++;
+			if ( !better ( heap[i], heap[child] ) ) break;
+			std::swap ( heap[i], heap[child] );
+		}
+	}
+	sorted = false;
+	return true;
+}
+
+void PsiGridBest::sort ( void ) const
+{
+	unsigned int i, j;
+	if ( sorted ) return;
+	// insertion sort, there are only few best points
+	ranked = heap;
+	for ( i=1; i<ranked.size(); i++ )
+		for ( j=i; j>0 && better ( ranked[j], ranked[j-1] ); j-- )
+			std::swap ( ranked[j], ranked[j-1] );
+	sorted = true;
+}
+
+const double * PsiGridBest::getPoint ( unsigned int i ) const
+{
+	if ( i>=size() ) throw BadIndexError();
+	sort ();
+	return &(points[ranked[i]*ndim]);
+}
+
+double PsiGridBest::getL ( unsigned int i ) const
+{
+	if ( i>=size() ) throw BadIndexError();
+	sort ();
+	return L[ranked[i]];
+}
+
 /************************************************** PsiGrid functions ********************************************/
 
 void makegridpoints (
@@ -111,6 +198,31 @@ void makegridpoints (
 	}
 }
 
+void makegridpoints ( const PsiGrid& grid, std::vector<double> *gridpoints )
+{
+	if ( grid.empty() )
+		return;
+	unsigned int ndim ( grid.dimension() ), ngrid ( grid.get_gridsize() );
+	unsigned int i, j, npoints ( 1 ), first ( gridpoints->size() );
+	std::vector<unsigned int> index ( ndim, 0 );
+	double * point;
+
+	for ( i=0; i<ndim; i++ )
+		npoints *= ngrid;
+	gridpoints->resize ( first + npoints*ndim );
+	point = &((*gridpoints)[first]);
+
+	// count through all index combinations, the last dimension varies fastest
+	for ( i=0; i<npoints; i++, point+=ndim ) {
+		for ( j=0; j<ndim; j++ )
+			point[j] = grid ( j, index[j] );
+		for ( j=ndim; j>0; j-- ) {
+			if ( ++index[j-1]<ngrid ) break;
+			index[j-1] = 0;
+		}
+	}
+}
+
 std::vector<double> pymakegridpoints (
 		const PsiGrid& grid,
 		std::vector<double> prm,
@@ -136,6 +248,89 @@ std::vector<double> pymakegridpoints (
 }
 
 
+/** \brief evaluation of grid points in chunks
+ *
+ * Every negative log posterior is written to the slot of its grid point, the best points are selected afterwards in the
+ * order of the grid points. That makes the outcome independent of the number of threads.
+ */
+#define GRID_CHUNKSIZE 64
+
+class GridJob : public PsiParallelJob
+{
+	private:
+		const std::vector<double>& gridpoints;
+		std::vector<double> * L;
+		const PsiData * data;
+		const PsiPsychometric * pmf;
+		unsigned int ndim;
+		unsigned int npoints;
+		std::vector< std::vector<double> > prm;    // parameters of a chunk for every thread
+	public:
+		GridJob ( const std::vector<double>& points, std::vector<double> * out, const PsiData * d, const PsiPsychometric * model, unsigned int dim, unsigned int nthreads )
+			: gridpoints ( points ), L ( out ), data ( d ), pmf ( model ), ndim ( dim ), npoints ( out->size() ),
+			prm ( nthreads, std::vector<double> ( GRID_CHUNKSIZE*model->getNparams() ) ) {}
+		void process ( unsigned int chunk, unsigned int thread );
+};
+
+void GridJob::process ( unsigned int chunk, unsigned int thread )
+{
+	const PsiCore * core ( pmf->getCore() );
+	unsigned int nprm ( pmf->getNparams() );
+	unsigned int i, j, first ( chunk*GRID_CHUNKSIZE ), n ( npoints-first<GRID_CHUNKSIZE ? npoints-first : GRID_CHUNKSIZE );
+	double * chunkprm ( &(prm[thread][0]) );
+	std::vector<double> transformed;
+	const double * point;
+	double a, b, lasta(0), lastb(0);
+
+	// Transform parameters
+	for ( i=0; i<n; i++ ) {
+		point = &(gridpoints[(first+i)*ndim]);
+		// a and b vary slowest on a grid, so the core transformation rarely has to be repeated
+		if ( transformed.empty() || point[0]!=lasta || point[1]!=lastb ) {
+			lasta = point[0];
+			lastb = point[1];
+			b = 1./lastb;
+			a = -lasta*b;
+			transformed = core->transform ( nprm, a, b );
+		}
+		for ( j=0; j<nprm; j++ )
+			chunkprm[i*nprm+j] = transformed[j];
+		chunkprm[i*nprm+2] = point[2];
+		if ( nprm > 3 ) chunkprm[i*nprm+3] = point[3];
+	}
+	// and get negative log posterior
+	pmf->neglpost_batch ( chunkprm, n, data, &((*L)[first]) );
+}
+
+void evalgridpoints (
+		const std::vector<double>& gridpoints,
+		PsiGridBest *best,
+		const PsiData* data,
+		const PsiPsychometric* pmf,
+		unsigned int nthreads
+		)
+{
+	unsigned int i, ndim ( best->dimension() );
+	unsigned int npoints ( ndim>0 ? gridpoints.size()/ndim : 0 );
+	if ( npoints==0 )
+		return;
+	if ( ndim != pmf->getNparams() )
+		throw PsiError ( "grid and parameter vector don't match" );
+	std::vector<double> L ( npoints );
+	unsigned int nchunks ( (npoints+GRID_CHUNKSIZE-1)/GRID_CHUNKSIZE );
+
+	if ( nthreads<1 )
+		nthreads = 1;
+	if ( nthreads>nchunks )
+		nthreads = nchunks;
+	GridJob job ( gridpoints, &L, data, pmf, ndim, nthreads );
+	run_parallel ( &job, nchunks, nthreads );
+
+	// Where does it belong?
+	for ( i=0; i<npoints; i++ )
+		best->add ( &(gridpoints[i*ndim]), L[i] );
+}
+
 void evalgridpoints (
 		const std::list< std::vector<double> >& gridpoints,
 		std::list< std::vector<double> > *bestprm,
@@ -146,52 +341,32 @@ void evalgridpoints (
 		)
 {
 	std::list< std::vector<double> >::const_iterator griditer;
-	std::list< std::vector<double> >::iterator iter_prm;
-	std::list< double >::iterator iter_L;
-	double l;
-	double a,b;
-	std::vector<double> prm;
-	const PsiCore *core = pmf->getCore();
-	bool store(true);
-
-	for ( griditer=gridpoints.begin(); griditer!=gridpoints.end(); griditer++ ) {
-		// Transform parameters and get negative log posterior
-		a = (*griditer)[0];
-		b = (*griditer)[1];
-		b = 1./b;
-		a = -a*b;
-		// prm = core->transform ( pmf->getNparams(), 1./b, -a/b );
-		prm = core->transform ( pmf->getNparams(), a, b );
-		prm[2] = (*griditer)[2];
-		if ( pmf->getNparams() > 3 ) prm[3] = (*griditer)[3];
-		l = pmf->neglpost ( prm, data );
-
-		// Where does it belong?
-		for ( iter_L=L->begin(), iter_prm=bestprm->begin() ; iter_L!=L->end(); iter_L++, iter_prm++ ) {
-			if ( l==(*iter_L) ) {
-				if ( (*iter_prm) == (*griditer) )
-					store = false;
-				else
-					store = true;
-				break;
-			} else if ( l<(*iter_L) ) {
-				store = true;
-				break;
-			} else {
-				store = false;
-			}
-		}
-		// insert the values if they are good enough
-		if ( store ) {
-			L->insert ( iter_L, l );
-			bestprm->insert ( iter_prm, std::vector<double>(*griditer) );
-		}
+	std::list< std::vector<double> >::reverse_iterator iter_prm;
+	std::list< double >::reverse_iterator iter_L;
+	unsigned int i, ndim;
+	if ( !bestprm->empty() )
+		ndim = bestprm->front().size();
+	else if ( !gridpoints.empty() )
+		ndim = gridpoints.front().size();
+	else
+		return;
 
-		// Reduce the size of the best parameters list
-		while ( L->size() > nbest ) {
-			L->pop_back();
-			bestprm->pop_back();
-		}
+	// the points found so far are added worst first to keep their ranking
+	PsiGridBest best ( nbest, ndim );
+	for ( iter_L=L->rbegin(), iter_prm=bestprm->rbegin(); iter_L!=L->rend(); iter_L++, iter_prm++ )
+		best.add ( &((*iter_prm)[0]), *iter_L );
+
+	std::vector<double> flatpoints;
+	flatpoints.reserve ( gridpoints.size()*ndim );
+	for ( griditer=gridpoints.begin(); griditer!=gridpoints.end(); griditer++ )
+		flatpoints.insert ( flatpoints.end(), griditer->begin(), griditer->end() );
+	evalgridpoints ( flatpoints, &best, data, pmf );
+
+	bestprm->clear ();
+	L->clear ();
+	for ( i=0; i<best.size(); i++ ) {
+		bestprm->push_back ( std::vector<double> ( best.getPoint(i), best.getPoint(i)+ndim ) );
+		L->push_back ( best.getL(i) );
 	}
 }
 
@@ -229,6 +404,37 @@ void updategridpoints (
 	}
 }
 
+void updategridpoints (
+		const PsiGrid& grid,
+		const PsiGridBest& best,
+		std::vector<double> *newgridpoints,
+		std::list< PsiGrid > *newgrids
+		)
+{
+	// same as above: shift the grid if a best point is on its edge, shrink it around the point otherwise
+	const double * prm;
+	bool isedge (false);
+	unsigned int i, j;
+	PsiGrid newgrid;
+
+	for ( j=0; j<best.size(); j++ ) {
+		prm = best.getPoint ( j );
+		isedge = false;
+		for ( i=0; i<best.dimension(); i++ ) {
+			isedge += prm[i]==grid.get_lower(i);
+			isedge += prm[i]==grid.get_upper(i);
+		}
+
+		if (isedge) {
+			newgrid = grid.shift ( std::vector<double> ( prm, prm+best.dimension() ) );
+		} else {
+			newgrid = grid.shrink ( std::vector<double> ( prm, prm+best.dimension() ) );
+		}
+		makegridpoints ( newgrid, newgridpoints );
+		newgrids->push_back ( newgrid );
+	}
+}
+
 /*************************************** Range heuristics ****************************************/
 
 void a_range ( const PsiData* data, double *xmin, double *xmax ) {
@@ -378,12 +584,12 @@ std::vector<double> getstart (
 		unsigned int gridsize,
 		unsigned int nneighborhoods,
 		unsigned int niterations,
-		std::vector<double> *incr )
+		std::vector<double> *incr,
+		unsigned int nthreads )
 {
 	std::vector<double> xmin ( pmf->getNparams() );
 	std::vector<double> xmax ( pmf->getNparams() );
-	std::list< std::vector<double> > bestprm;
-	std::list< double > L;
+	PsiGridBest bestprm ( nneighborhoods, pmf->getNparams() );
 	unsigned int i,j, ngrids;
 
 	// Set up the initial grid
@@ -397,9 +603,9 @@ std::vector<double> getstart (
 	newgrids.push_back ( grid );
 
 	// Perform first evaluation on the grid
-	std::list< std::vector<double> > gridpoints;
-	makegridpoints ( grid, xmin, 0, &gridpoints );
-	evalgridpoints ( gridpoints, &bestprm, &L, data, pmf, nneighborhoods );
+	std::vector<double> gridpoints;
+	makegridpoints ( grid, &gridpoints );
+	evalgridpoints ( gridpoints, &bestprm, data, pmf, nthreads );
 
 	// potentially more evaluations
 	for ( i=0; i<niterations; i++ ) {
@@ -411,9 +617,9 @@ std::vector<double> getstart (
 		for ( j=0; j<ngrids; j++ ) {
 			currentgrid = newgrids.front ();
 			newgrids.pop_front ();
-			gridpoints = std::list< std::vector<double> > ();
+			gridpoints.clear ();
 			updategridpoints ( currentgrid, bestprm, &gridpoints, &newgrids );
-			evalgridpoints ( gridpoints, &bestprm, &L, data, pmf, nneighborhoods );
+			evalgridpoints ( gridpoints, &bestprm, data, pmf, nthreads );
 		}
 
 		// evalgridpoints ( gridpoints, &bestprm, &L, data, pmf, nneighborhoods );
@@ -421,17 +627,18 @@ std::vector<double> getstart (
 
 	// Now transform the best parameter to the suitable format
 	const PsiCore *core = pmf->getCore();
-	double a ( bestprm.front()[0] ), b ( bestprm.front()[1] );
+	const double * best ( bestprm.getPoint ( 0 ) );
+	double a ( best[0] ), b ( best[1] );
 	// std::cerr << "Raw starting values:";
-	// for (i=0; i<bestprm.front().size(); i++) {
-	// 	std::cerr << " " << bestprm.front()[i];
+	// for (i=0; i<bestprm.dimension(); i++) {
+	// 	std::cerr << " " << best[i];
 	// }
 	// std::cerr << "\n";
 	b = 1./b;
 	a = -a*b;
 	std::vector<double> out = core->transform ( pmf->getNparams(), a, b );
-	out[2] = bestprm.front()[2];
-	if ( pmf->getNparams() > 3 ) out[3] = bestprm.front()[3];
+	out[2] = best[2];
+	if ( pmf->getNparams() > 3 ) out[3] = best[3];
 
 	if ( incr!=NULL ) {
 		if ( incr->size() != pmf->getNparams() ) throw ( BadArgumentError ( "Wrong size for incr" ) );
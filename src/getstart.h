@@ -35,6 +35,40 @@ class PsiGrid {
 		double operator() ( unsigned int i, unsigned int j ) const { return grid1d[i][j]; }
 };
 
+/** \brief the nbest grid points with the lowest negative log posterior
+ *
+ * The points are kept in a bounded heap with the worst stored point on top, so that every new point is compared to
+ * that point only. Points with equal negative log posterior are ranked by the order in which they were added (later
+ * points first). A point that is already stored is not stored again.
+ */
+class PsiGridBest {
+	private:
+		unsigned int nbest;                   // maximum number of stored points
+		unsigned int ndim;                    // number of values per point
+		unsigned int nadded;                  // number of points added so far
+		std::vector<double> points;           // nbest x ndim values, one slot per stored point
+		std::vector<double> L;                // negative log posterior for every slot
+		std::vector<unsigned int> order;      // index of the point in the sequence of added points for every slot
+		std::vector<unsigned int> heap;       // occupied slots, worst point on top
+		mutable std::vector<unsigned int> ranked;  // occupied slots, best point first
+		mutable bool sorted;
+		bool better ( unsigned int slot1, unsigned int slot2 ) const { return L[slot1]<L[slot2] || ( L[slot1]==L[slot2] && order[slot1]>order[slot2] ); }
+		void sort ( void ) const;
+	public:
+		PsiGridBest (
+				unsigned int nbest,               ///< how many "best" parameter constellations should be kept?
+				unsigned int ndim                 ///< number of values per grid point
+				); ///< an empty set of best points
+		bool add (
+				const double * point,             ///< the ndim values of the grid point
+				double l                          ///< negative log posterior at the grid point
+				); ///< add a point if it is among the nbest points so far, returns true if the point is stored
+		unsigned int size ( void ) const { return heap.size(); }             ///< number of stored points
+		unsigned int dimension ( void ) const { return ndim; }              ///< number of values per point
+		const double * getPoint ( unsigned int i ) const;                    ///< the i-th best point (i=0 is the best point)
+		double getL ( unsigned int i ) const;                                ///< negative log posterior of the i-th best point
+};
+
 std::vector<double> linspace (
 		double xmin,
 		double xmax,
@@ -48,6 +82,11 @@ void makegridpoints (
 		std::list< std::vector<double> > *gridpoints   ///< gridpoints list to which new gridpoints are added
 		);    ///< generate new grid points based on a PsiGrid object
 
+void makegridpoints (
+		const PsiGrid& grid,                           ///< PsiGrid object on from which the grid points should be generated
+		std::vector<double> *gridpoints                ///< grid points are appended here, grid.dimension() values per point
+		);    ///< generate all grid points of a PsiGrid object and store them contiguously (the first dimension varies slowest)
+
 void evalgridpoints (
 		const std::list< std::vector<double> >& grid,       ///< gridpoints on which the negative log posterior should be evaluated
 		std::list< std::vector<double> > *bestprm,          ///< list to which the best parameters should be appended
@@ -57,6 +96,14 @@ void evalgridpoints (
 		unsigned int nbest                                  ///< how many "best" parameter constellations should be determined?
 		);              ///< evaluate negative log posterior on a gridpoints and update bestprm and L to refer to the nbest parameter settings encountered so far
 
+void evalgridpoints (
+		const std::vector<double>& gridpoints,               ///< gridpoints on which the negative log posterior should be evaluated, best->dimension() values per point
+		PsiGridBest *best,                                   ///< best points so far, updated with the new grid points
+		const PsiData* data,                                 ///< data set on which the gridsearch should be performed
+		const PsiPsychometric* pmf,                          ///< psychometric function for which the gridsearch should be performed
+		unsigned int nthreads=1                              ///< number of threads that evaluate the negative log posterior (the result does not depend on this)
+		);              ///< evaluate negative log posterior on contiguously stored gridpoints and update the best points
+
 void updategridpoints (
 		const PsiGrid& grid,                              ///< PsiGrid obejct from which the new grids and gridpoints should be generated
 		const std::list< std::vector<double> >& bestprm,  ///< so far best parameter settings
@@ -64,6 +111,13 @@ void updategridpoints (
 		std::list< PsiGrid > *newgrids                    ///< grids corresponding to the new gridpoints
 		);             ///< generate new gridpoints by shifting and shrinking the previous grid and store the newly generated PsiGrid objects
 
+void updategridpoints (
+		const PsiGrid& grid,                              ///< PsiGrid obejct from which the new grids and gridpoints should be generated
+		const PsiGridBest& best,                          ///< so far best parameter settings
+		std::vector<double> *newgridpoints,               ///< new gridpoints to be evaluated are appended here
+		std::list< PsiGrid > *newgrids                    ///< grids corresponding to the new gridpoints
+		);             ///< generate new contiguously stored gridpoints by shifting and shrinking the previous grid around the best points
+
 void a_range ( const PsiData* data,  double *xmin, double *xmax );    ///< Heuristic to generate a first idea of the threshold parameter a
 void b_range ( const PsiData* data,  double *xmin, double *xmax );    ///< Heuristic to generate a first idea of the width parameter b
 void lm_range ( const PsiData* data, double *xmin, double *xmax );    ///< Heuristic to generate a first idea of the lapse rate parameter lm
@@ -77,7 +131,8 @@ std::vector<double> getstart (
 		unsigned int gridsize,         ///< number of grid points to be used
 		unsigned int nneighborhoods,   ///< number of neighborhoods to be studied
 		unsigned int niterations,      ///< number of iterated neighborhood searched to be performed
-		std::vector<double> *incr=NULL ///< increments to be used when constructing a simplex (output)
+		std::vector<double> *incr=NULL, ///< increments to be used when constructing a simplex (output)
+		unsigned int nthreads=1         ///< number of threads that evaluate the grid points (the result does not depend on this)
 		);    ///< Determine a good starting value using nested grid search
 
 std::vector<double> pymakegridpoints (
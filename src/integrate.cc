@@ -1,6 +1,7 @@
 #include "integrate.h"
 #include "errors.h"
 #include "linalg.h"
+#include "parallel.h"
 
 // #define DEBUG_INTEGRATE
 
@@ -12,17 +13,20 @@ PsiIndependentPosterior::PsiIndependentPosterior ( unsigned int nprm,
 	unsigned int i,j,k;
 	double p;
 	std::vector<double> w;
-	Matrix M ( grids[0].size(), 2 );
 
 	for ( i=0; i<nparams; i++ ) {
+		Matrix M ( grids[i].size(), 2 );   // adaptive grids differ in size
 		for ( j=0; j<grids[i].size(); j++ ) {
 			M(j,0) = margins[i][j];
 			p = posteriors[i]->pdf ( grids[i][j] );
 			k = 1;
 			while ( std::isinf ( p ) ) {
+				if ( j+k>= grids[i].size() ) {
+					p = 1e40;
+					break;
+				}
 				p = posteriors[i]->pdf ( grids[i][j+k] );
 				k++;
-				if ( j+k>= grids[i].size() ) p = 1e40;
 			}
 			if ( p!=p ) p=0;
 			M(j,1) = p;
@@ -222,79 +226,185 @@ std::vector<double> match_beta ( const std::vector<double>& x, const std::vector
 }
 // End Moment matching ///////////////////////////
 
+/** \brief evaluation of many parameter vectors shared by all threads
+ *
+ * The parameter vectors are handed out in chunks, every result is written to the slot of its parameter vector.
+ */
+class NeglpostJob : public PsiParallelJob
+{
+	private:
+		const PsiPsychometric * pmf;
+		const PsiData * data;
+		const std::vector<double>& prm;
+		std::vector<double> * out;
+		unsigned int npoints;
+		unsigned int chunksize;
+	public:
+		NeglpostJob ( const PsiPsychometric * model, const PsiData * d, const std::vector<double>& x, std::vector<double> * L, unsigned int n, unsigned int chunk )
+			: pmf ( model ), data ( d ), prm ( x ), out ( L ), npoints ( n ), chunksize ( chunk ) {}
+		void process ( unsigned int chunk, unsigned int thread ) {
+			unsigned int first ( chunk*chunksize ), n;
+			n = ( npoints-first<chunksize ? npoints-first : chunksize );
+			pmf->neglpost_batch ( &(prm[first*pmf->getNparams()]), n, data, &((*out)[first]) );
+		}
+};
+
+void neglpost_parallel (
+		const PsiPsychometric *pmf,
+		const PsiData *data,
+		const std::vector<double>& prm,
+		std::vector<double> *out,
+		unsigned int nthreads
+		)
+{
+	unsigned int chunksize, npoints ( prm.size()/pmf->getNparams() );
+	out->resize ( npoints );
+	if ( npoints==0 )
+		return;
+
+	if ( nthreads<1 )
+		nthreads = 1;
+	if ( nthreads>npoints )
+		nthreads = npoints;
+	chunksize = ( npoints+4*nthreads-1 ) / ( 4*nthreads );   // a few chunks per thread to balance the load
+
+	NeglpostJob job ( pmf, data, prm, out, npoints, chunksize );
+	run_parallel ( &job, ( npoints+chunksize-1 ) / chunksize, nthreads );
+}
+
+/** \brief unnormalized density exp(-neglpost) relative to the best grid point, 0 where the posterior is not defined */
+void marginal_density ( const std::vector<double>& L, std::vector<double> *fx )
+{
+	unsigned int j;
+	double Lmin ( 1e20 );
+
+	for ( j=0; j<L.size(); j++ )
+		if ( L[j]<Lmin ) Lmin = L[j];     // nan never compares smaller
+
+	fx->resize ( L.size() );
+	for ( j=0; j<L.size(); j++ ) {
+		if ( L[j]!=L[j] || std::isinf ( L[j] ) )
+			(*fx)[j] = 0;
+		else
+			(*fx)[j] = exp ( Lmin - L[j] );
+	}
+}
+
+/** \brief midpoints of the grid intervals that hold more than tolerance of the probability mass, at most room of them (the heaviest ones) */
+void refine_intervals ( const std::vector<double>& x, const std::vector<double>& L, double tolerance, unsigned int room, std::vector<double> *newx )
+{
+	unsigned int j;
+	double Z ( 0 );
+	std::vector<double> fx;
+	std::vector<double> mass ( x.size()-1 );
+	std::vector< std::pair<double,unsigned int> > heavy;
+	std::vector<unsigned int> split;
+
+	marginal_density ( L, &fx );
+	for ( j=0; j+1<x.size(); j++ ) {
+		// Trapez Quadrature
+		mass[j] = 0.5*(fx[j]+fx[j+1])*(x[j+1]-x[j]);
+		Z += mass[j];
+	}
+	if ( !(Z>0) || std::isinf ( Z ) )
+		return;
+
+	for ( j=0; j+1<x.size(); j++ )
+		if ( mass[j] > tolerance*Z && x[j]+0.5*(x[j+1]-x[j])>x[j] )    // intervals can not be split beyond numerical precision
+			heavy.push_back ( std::pair<double,unsigned int> ( -mass[j], j ) );
+
+	if ( heavy.size()>room ) {
+		std::nth_element ( heavy.begin(), heavy.begin()+room, heavy.end() );
+		heavy.resize ( room );
+	}
+	for ( j=0; j<heavy.size(); j++ )
+		split.push_back ( heavy[j].second );
+	std::sort ( split.begin(), split.end() );
+
+	newx->clear ();
+	for ( j=0; j<split.size(); j++ )
+		newx->push_back ( 0.5*(x[split[j]]+x[split[j]+1]) );
+}
+
 PsiIndependentPosterior independent_marginals (
 		const PsiPsychometric *pmf,
-		const PsiData *data
+		const PsiData *data,
+		PsiOptimizerMethod method,
+		unsigned int gridsize,
+		double tolerance,
+		unsigned int nthreads
 		)
 {
-	unsigned int gridsize (100);
+	if ( gridsize<2 )
+		throw BadArgumentError ( "independent_marginals needs at least 2 grid points per parameter" );
+	unsigned int maxgridsize ( 10*gridsize );
 
-	unsigned int nprm ( pmf->getNparams() ), i, j;
-	unsigned int maxntrials ( 0 );
-	double minp,minm,maxm,maxw,s,Z,p,m, count;
+	unsigned int nprm ( pmf->getNparams() ), i, j, k, n;
+	double minm,maxm;
 	std::vector< std::vector<double> > grids ( nprm );
-	std::vector< std::vector<double> > margin ( nprm, std::vector<double>(gridsize) );
+	std::vector< std::vector<double> > L ( nprm );
+	std::vector< std::vector<double> > newx ( nprm );
+	std::vector< std::vector<double> > margin ( nprm );
 	std::vector< std::vector<double> > distparams (nprm, std::vector<double>(3) );
 	std::vector<PsiPrior*> fitted_posteriors (nprm);
+	std::vector<double> prm, l, x, Lx;
+	bool refine ( true );
 
-	PsiOptimizer * opt = new PsiOptimizer ( pmf, data );
+	PsiOptimizer * opt = new PsiOptimizer ( pmf, data, method );
 	std::vector<double> MAP ( opt->optimize ( pmf, data ) );
-	std::vector<double> prm ( MAP );
 	delete opt;
 	for ( i=0; i<nprm; i++ ) {
-		// std::cerr << "================= prm " << i << "================\n";
 		// Determine parameter ranges using the same routine as for starting values
 		parameter_range ( data, pmf, i, &minm, &maxm );
-		Z = 0;
 		// This routine is slightly more narrow than we would like for our purposes
 		if ( i>1 ) { minm=0; maxm=1.; }
 		if ( i==1 ) { minm=0; maxm*=2; }
 
-		grids[i] = lingrid ( minm, maxm, gridsize );
-
-		for ( j=0; j<nprm; j++ ) { prm[j] = MAP[j]; }
+		newx[i] = lingrid ( minm, maxm, gridsize );
+	}
 
-		count = 0;
-		for ( j=0; j<gridsize; j++ ) {
-			prm[i] = grids[i][j];
-			p = pmf->neglpost ( prm, data );
-#ifdef DEBUG_INTEGRATE
-			std::cerr << "p(" << i << "," << j << ") = " << p << " " << prm[i];
-#endif
-			// Clip
-			if ( std::isinf ( p ) || p!=p ) {
-				if ( j>0 ) {
-					grids[i][j] = grids[i][j-1];
-					margin[i][j] = margin[i][j-1];
+	while ( refine ) {
+		// Evaluate the new points of all parameters in one go
+		prm.clear ();
+		for ( i=0; i<nprm; i++ ) {
+			for ( j=0; j<newx[i].size(); j++ ) {
+				prm.insert ( prm.end(), MAP.begin(), MAP.end() );
+				prm[prm.size()-nprm+i] = newx[i][j];
+			}
+		}
+		neglpost_parallel ( pmf, data, prm, &l, nthreads );
+
+		// Merge them with the points evaluated before and look for intervals that should be refined
+		refine = false;
+		for ( i=0, n=0; i<nprm; i++ ) {
+			x.clear ();
+			Lx.clear ();
+			for ( j=0, k=0; j<grids[i].size() || k<newx[i].size(); ) {
+				if ( k>=newx[i].size() || ( j<grids[i].size() && grids[i][j]<newx[i][k] ) ) {
+					x.push_back ( grids[i][j] );
+					Lx.push_back ( L[i][j++] );
 				} else {
-					grids[i][j] = grids[i][j+1];
-					prm[i] = grids[i][j+1];
-					margin[i][j] = pmf->neglpost ( prm, data );
-					if ( std::isinf ( margin[i][j] ) ) std::cerr << "WARNING: margin("<<i<<","<<j<<") is inf\n";
+					x.push_back ( newx[i][k++] );
+					Lx.push_back ( l[n]<-1e10 ? -1e10 : l[n] );
+					n++;
 				}
-			} else margin[i][j] = (p > -1e10 ? p : -1e10 );
-			if ( std::isinf ( margin[i][j] ) ) margin[i][j] = 1e20;
-#ifdef DEBUG_INTEGRATE
-			std::cerr << " margin = " << margin[i][j] << "\n";
-#endif
-
-			// And compute average Z online
-			if (p>-1e10 && p<1e10) {
-				Z += exp( -margin[i][j] );
-				count ++;
 			}
+			grids[i].swap ( x );
+			L[i].swap ( Lx );
+
+			newx[i].clear ();
+			if ( tolerance>0 && grids[i].size()<maxgridsize )
+				refine_intervals ( grids[i], L[i], tolerance, maxgridsize-grids[i].size(), &(newx[i]) );
+			if ( newx[i].size()>0 )
+				refine = true;
 		}
-		Z /= count;
-		Z = log ( Z );
-
-		// Include Z for numerical stability
-		for ( j=0; j<gridsize; j++ ) {
-			margin[i][j] = exp ( Z - margin[i][j] );
-		}
-
 	}
 
 	for ( i=0; i<nprm; i++ ) {
+		marginal_density ( L[i], &(margin[i]) );
+#ifdef DEBUG_INTEGRATE
+		std::cerr << "parameter " << i << ": " << grids[i].size() << " grid points\n";
+#endif
 		normalize_probability ( grids[i], margin[i] );
 		switch (i) {
 			case 0:
@@ -314,206 +424,183 @@ PsiIndependentPosterior independent_marginals (
 
 	PsiIndependentPosterior out ( nprm, fitted_posteriors, grids, margin );
 
-	for ( i=0; i<nprm; i++ ) {
-		// delete fitted_posteriors[i];
-	}
-
 	return out;
 }
 
+/** \brief drawing and weighting of proposals shared by all threads
+ *
+ * The proposals are handed out in blocks of SIR_BLOCKSIZE. Every block has its own random number engine and every
+ * proposal and log weight is written to its own slot.
+ */
+class SIRJob : public PsiParallelJob
+{
+	private:
+		const PsiPsychometric * pmf;
+		const PsiData * data;
+		std::vector<PsiRandomEngine>& engines;
+		std::vector<double>& proposed;
+		std::vector<double>& logweights;
+		unsigned int nproposals;
+		std::vector< std::vector<PsiPrior*> > posteriors;    // the posterior approximations carry the engine, every thread has its own
+		SIRJob ( const SIRJob& );
+		SIRJob& operator= ( const SIRJob& );
+	public:
+		SIRJob ( const PsiPsychometric * model, const PsiData * d, PsiIndependentPosterior& post, std::vector<PsiRandomEngine>& e,
+				std::vector<double>& prm, std::vector<double>& w, unsigned int n, unsigned int nthreads );
+		~SIRJob ( void );
+		void process ( unsigned int block, unsigned int thread );
+};
+
+#define SIR_BLOCKSIZE 256
+
+SIRJob::SIRJob ( const PsiPsychometric * model, const PsiData * d, PsiIndependentPosterior& post, std::vector<PsiRandomEngine>& e,
+		std::vector<double>& prm, std::vector<double>& w, unsigned int n, unsigned int nthreads )
+	: pmf ( model ), data ( d ), engines ( e ), proposed ( prm ), logweights ( w ), nproposals ( n ),
+	posteriors ( nthreads, std::vector<PsiPrior*> ( model->getNparams() ) )
+{
+	unsigned int j, k;
+	for ( k=0; k<nthreads; k++ )
+		for ( j=0; j<pmf->getNparams(); j++ )
+			posteriors[k][j] = post.get_posterior ( j );
+}
+
+SIRJob::~SIRJob ( void )
+{
+	unsigned int j, k;
+	for ( k=0; k<posteriors.size(); k++ )
+		for ( j=0; j<posteriors[k].size(); j++ )
+			delete posteriors[k][j];
+}
+
+void SIRJob::process ( unsigned int block, unsigned int thread )
+{
+	unsigned int nprm ( pmf->getNparams() ), i, j, first ( block*SIR_BLOCKSIZE ), n;
+	std::vector<PsiPrior*>& posterior ( posteriors[thread] );
+	double q, q_raw;
+	double * prm;
+
+	n = ( nproposals-first<SIR_BLOCKSIZE ? nproposals-first : SIR_BLOCKSIZE );
+	for ( j=0; j<nprm; j++ )
+		posterior[j]->setEngine ( &(engines[block]) );
+
+	// Propose
+	prm = &(proposed[first*nprm]);
+	for ( i=0; i<n; i++ )
+		for ( j=0; j<nprm; j++ )
+			prm[i*nprm+j] = posterior[j]->rand();
+	pmf->neglpost_batch ( prm, n, data, &(logweights[first]) );
+
+	// determine weight
+	for ( i=0; i<n; i++ ) {
+		q = 0;
+		for ( j=0; j<nprm; j++ ) {
+			q_raw = posterior[j]->pdf ( prm[i*nprm+j] );
+			if ( q_raw > 1e10 )
+				q_raw = 1e10;
+			if ( q_raw != q_raw )
+				q_raw = 1e5;
+			if ( q_raw<1e-5 )
+				q_raw = 1e-5;
+			q += log ( q_raw );
+		}
+		logweights[first+i] = - logweights[first+i] - q;
+	}
+}
+
 MCMCList sample_posterior (
 		const PsiPsychometric *pmf,
 		const PsiData *data,
 		PsiIndependentPosterior& post,
 		unsigned int nsamples,
-		unsigned int propose
+		unsigned int propose,
+		unsigned int nthreads,
+		PsiRandomEngine * engine
 		)
 {
 	unsigned int nprm ( pmf->getNparams() ), i, j, k;
 	unsigned int nproposals ( nsamples*propose );
+	unsigned int nblocks ( (nproposals+SIR_BLOCKSIZE-1)/SIR_BLOCKSIZE );
 	MCMCList finalsamples ( nsamples, nprm, data->getNblocks() );
-	double q,p,q_raw,p_raw;
+	double maxlogweight ( -HUGE_VAL ), w, u, deviance(0);
 	double nduplicate ( 0 );
-	PsiRandom rng;
-	PsiPrior * posteri;
-	std::vector < PsiPrior* > posteriors ( nprm );
-	double H(0),N(0);
+	double H(0),N(0),W2(0);
 
-	std::vector< std::vector<double> > proposed ( nproposals, std::vector<double> (nprm) );
-	std::vector<double> weights ( nproposals );
-	std::vector<double> cum_probs ( nproposals );
-	std::vector<double> rnumbers ( nsamples );
+	if ( nproposals==0 )
+		return finalsamples;
 
-	for ( j=0; j<nprm; j++ ) {
-		posteriors[j] = post.get_posterior (j);
-	}
+	std::vector<double> proposed ( nproposals*nprm );
+	std::vector<double> logweights ( nproposals );
+	std::vector<double> cum_probs ( nproposals );
+	std::vector<double> theta ( nprm );
 
+	// Random number streams for the blocks and the resampling
+	PsiRandom rng;
+	rng.setEngine ( engine );
+	PsiRandomEngine streams ( (unsigned long) ( rng.rngcall() * 4294967296. ) );
+	std::vector<PsiRandomEngine> engines ( nblocks );
+	for ( i=0; i<nblocks; i++ )
+		engines[i] = streams.split ();
+
+	if ( nthreads<1 )
+		nthreads = 1;
+	if ( nthreads>nblocks )
+		nthreads = nblocks;
+	SIRJob job ( pmf, data, post, engines, proposed, logweights, nproposals, nthreads );
+	run_parallel ( &job, nblocks, nthreads );
+
+	// make a cumulative distribution vector for the weights, relative to the largest weight to avoid overflow
+	for ( i=0; i<nproposals; i++ )
+		if ( logweights[i]>maxlogweight && !std::isinf ( logweights[i] ) )
+			maxlogweight = logweights[i];
 	for ( i=0; i<nproposals; i++ ) {
-		// Propose
-		for ( j=0; j<nprm; j++ )
-			proposed[i][j] = posteriors[j]->rand();
-		// determine weight
-		q = 1.;
-        for ( j=0; j<nprm; j++ ) {
-			posteri = post.get_posterior(j);
-			q_raw = posteri->pdf ( proposed[i][j] );
-			if ( q_raw > 1e10 )
-				q_raw = 1e10;
-			if ( q_raw != q_raw )
-				q_raw = 1e5;
-			if ( q_raw<1e-5 )
-				q_raw = 1e-5;
-            q *= q_raw;
-			delete posteri;
-		}
-        p = - pmf->neglpost ( proposed[i], data );
-		if ( std::isinf ( p ) || p!=p )
-			weights[i] = 0;
+		if ( std::isinf ( logweights[i] ) || logweights[i]!=logweights[i] )
+			w = 0;
 		else
-			weights[i] = exp ( p - log (q) );
-#ifdef DEBUG_INTEGRATE
-		if ( weights[i] != weights[i] || weights[i] > 1e10) {
-			std::cerr << "Index: " << i << ", weight: " << weights[i] << ", p: " << p << ", q: " << q << ", th: (" << proposed[i][0];
-			for ( j=1; j<nprm; j++ ) std::cerr << ", " << proposed[i][j];
-			std::cerr << ")\n";
-			std::cerr.flush();
-		}
-#endif
-
-		// make a cumulative distribution vector for the weights
-		if (i>0)
-			cum_probs[i] = cum_probs[i-1] + weights[i];
-		else {
-			cum_probs[0] = weights[0];
-#ifdef DEBUG_INTEGRATE
-			std::cerr << "w0 = " << weights[0] << "\n";
-#endif
-		}
+			w = exp ( logweights[i]-maxlogweight );
+		cum_probs[i] = ( i>0 ? cum_probs[i-1] : 0 ) + w;
+		W2 += w*w;
 	}
+	if ( !(cum_probs[nproposals-1]>0) )
+		throw PsiError ( "sample_posterior: all importance weights are zero" );
 
-	for ( i=0; i<nsamples; i++ ) {
-		// And generate random numbers
-		rnumbers[i] = rng.rngcall();
-	}
+	// Effective sample size of the weights
+	finalsamples.set_ess ( cum_probs[nproposals-1]*cum_probs[nproposals-1]/W2 );
 
 	// Normalize the cumulative distribution
 	for ( i=0; i<nproposals; i++ )
 		cum_probs[i] /= cum_probs[nproposals-1];
 
 	// Calculate entropy for diagnosis
-	if ( cum_probs[0] > 0 )
-		H = - cum_probs[0] * log(cum_probs[0]);
-	else
-		H = 0;
-#ifdef DEBUG_INTEGRATE
-	std::cerr << "H=" << H << ", cum_probs[0] = " << cum_probs[0] << "\n";
-#endif
-	N = 1.;
-	// Avoid zeros
-	for ( i=0; i<nproposals-1; i++ ) {
-		if ((cum_probs[i+1]-cum_probs[i])>0) {
-			H -= (cum_probs[i+1]-cum_probs[i]) * log ( cum_probs[i+1]-cum_probs[i] );
+	for ( i=0; i<nproposals; i++ ) {
+		w = cum_probs[i] - ( i>0 ? cum_probs[i-1] : 0 );
+		if ( w>0 ) {
+			H -= w * log ( w );
 			N += 1;
 		}
-#ifdef DEBUG_INTEGRATE
-		if ( H!=H ) {
-			std::cerr << "H became nan in the " << i << "th iteration, cum_probs["<<i+1<<"] = " << cum_probs[i+1] << ", cum_probs["<<i<<"] = " << cum_probs[i] <<"\n";
-			break;
-		}
-#endif
 	}
-	H /= log(N);
+	H = ( N>1 ? H/log(N) : 0 );
 #ifdef DEBUG_INTEGRATE
-	std::cerr << "H = " << H << "\n";
+	std::cerr << "H = " << H << ", ess = " << finalsamples.get_ess() << "\n";
 #endif
 
-	sort ( rnumbers.begin(), rnumbers.end() );
-
-	// resampling
-	i = j = 0;
-    while (i<nsamples) {
-        k = 0;
-        while (rnumbers[i] <= cum_probs[j]) {
-			finalsamples.setEst ( i, proposed[j], pmf->deviance ( proposed[j], data ) );
-			nduplicate += k;
-			k=1;
-            i++;
-            if (i>=nsamples)
-                break;
-		}
-        j++;
-		if (j>nproposals) {
-#ifdef DEBUG_INTEGRATE
-			std::cerr << "What's going on here? i=" <<  i << ", cum_probs.max() = " << cum_probs[nproposals-1] << "\n";
-#endif
-			break;
+	// systematic resampling: one uniform offset, then nsamples equally spaced points through the cumulative weights
+	u = streams.draw ();
+	for ( i=0, j=0, k=nproposals; i<nsamples; i++ ) {
+		w = (u+i)/nsamples;
+		while ( j<nproposals-1 && cum_probs[j]<w )
+			j++;
+		if ( j==k ) {
+			nduplicate += 1;
+		} else {
+			theta.assign ( &(proposed[j*nprm]), &(proposed[j*nprm])+nprm );
+			deviance = pmf->deviance ( theta, data );
+			k = j;
 		}
+		finalsamples.setEst ( i, theta, deviance );
 	}
 
 	finalsamples.set_accept_rate ( double(nduplicate)/nsamples );
 	finalsamples.set_entropy ( H );
 
-	for ( i=0; i<nprm; i++ )
-		delete posteriors[i];
-
 	return finalsamples;
 }
-
-void sample_diagnostics (
-		const PsiPsychometric *pmf,
-		const PsiData *data,
-		MCMCList *samples
-		)
-{
-	unsigned int i,j,k, nprm ( pmf->getNparams() ), nblocks ( data->getNblocks() );
-	std::vector<double> probs ( nblocks );
-	std::vector<double> est ( nprm );
-	PsiData *localdata = new PsiData ( data->getIntensities(), data->getNtrials(), data->getNcorrect(), data->getNalternatives() );
-	std::vector<int> posterior_predictive ( nblocks );
-
-	std::vector<double> reducedx ( data->getNblocks()-1 );
-	std::vector<int> reducedk ( data->getNblocks()-1 );
-	std::vector<int> reducedn ( data->getNblocks()-1 );
-	std::vector< PsiData* > reduceddata ( data->getNblocks() );
-
-	for ( i=0; i<nblocks; i++ ) {
-		j = 0;
-		for (k=0; k<nblocks; k++ ) {
-			if ( i!=k ) {
-				reducedx[j] = data->getIntensity(k);
-				reducedk[j] = data->getNcorrect(k);
-				reducedn[j] = data->getNtrials(k);
-				j++;
-			}
-		}
-		reduceddata[i] = new PsiData ( reducedx, reducedn, reducedk, data->getNalternatives() );
-	}
-
-	for ( i=0; i<samples->getNsamples(); i++ ) {
-		for ( j=0; j<nprm; j++ )
-			est[j] = samples->getEst ( i, j );
-
-		for ( j=0; j<nblocks; j++ )
-			probs[j] = pmf->evaluate ( data->getIntensity(j), est );
-		newsample ( localdata, probs, &posterior_predictive );
-		localdata->setNcorrect ( posterior_predictive );
-		samples->setppData ( i, posterior_predictive, pmf->deviance ( est, localdata ) );
-
-		probs = pmf->getDevianceResiduals ( est, data );
-		samples->setRpd ( i, pmf->getRpd ( probs, est, data ) );
-		samples->setRkd ( i, pmf->getRkd ( probs, data ) );
-
-		probs = pmf->getDevianceResiduals ( est, localdata );
-		samples->setppRpd ( i, pmf->getRpd ( probs, est, localdata ) );
-		samples->setppRkd ( i, pmf->getRkd ( probs, localdata ) );
-
-		// Store log posterior ratios for reduced data sets
-		for ( j=0; j<nblocks; j++ )
-			samples->setlogratio ( i, j, pmf->neglpost(est,data) - pmf->neglpost(est,reduceddata[j]) );
-	}
-
-	for ( i=0; i<nblocks; i++ ) {
-		delete reduceddata[i];
-	}
-	delete localdata;
-}
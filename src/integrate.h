@@ -5,6 +5,7 @@
 #include "data.h"
 #include "getstart.h"
 #include "bootstrap.h"
+#include "mcmc.h"
 #include <vector>
 #include <algorithm>
 
@@ -66,23 +67,49 @@ class PsiIndependentPosterior {
 		std::vector<double> get_margin ( unsigned int parameter ) { return margins[parameter]; } ///< get the (marginal) density of a single parameter
 };
 
+void neglpost_parallel (
+		const PsiPsychometric *pmf,        ///< psychometric function model
+		const PsiData *data,               ///< dataset
+		const std::vector<double>& prm,    ///< parameter vectors of pmf->getNparams() values each, stored one after the other
+		std::vector<double> *out,          ///< output: negative log posterior for every parameter vector (resized)
+		unsigned int nthreads=1            ///< number of threads that evaluate the negative log posterior (the result does not depend on this)
+		);  ///< evaluate the negative log posterior for many parameter vectors on several threads
+
+/** \brief determine an approximation to the posterior distribution that approximates the posterior as a product of independent distributions for all parameters
+ *
+ * The marginal of every parameter is evaluated along a line through the MAP estimate. Evaluation starts on a regular grid of
+ * gridsize points. If tolerance is larger than 0, every interval between neighbouring grid points that holds more than a
+ * fraction tolerance of the probability mass is split in two, until no interval holds more than that or the grid has
+ * grown to 10*gridsize points. The default is a fixed grid as in earlier versions. Grid points at which the posterior is not defined get a density of 0.
+ */
 PsiIndependentPosterior independent_marginals (
 		const PsiPsychometric *pmf,    ///< psychometric function model
-		const PsiData *data            ///< dataset
-		);  ///< determine an approximation to the posterior distribution that approximates the posterior as a product of independent distributions for all parameters
+		const PsiData *data,           ///< dataset
+		PsiOptimizerMethod method=OPTIMIZER_SIMPLEX,   ///< optimization method used to find the MAP estimate
+		unsigned int gridsize=100,     ///< number of grid points per parameter before refinement
+		double tolerance=0,            ///< largest fraction of the probability mass between two neighbouring grid points (0 for a fixed grid)
+		unsigned int nthreads=1        ///< number of threads that evaluate the grid points (the result does not depend on this)
+		);
 
+/** \brief sample from the posterior using sampling importance resampling
+ *
+ * nsamples*propose proposals are drawn from the posterior approximation and weighted by the ratio of the posterior and the
+ * approximation. The proposals are drawn and weighted in blocks on nthreads threads. Every block draws from its own
+ * random number stream, split off from engine (or from a seed drawn from the global generator if engine is NULL), so
+ * that the samples do not depend on the number of threads. nsamples proposals are then selected by systematic
+ * resampling over the cumulative weights.
+ *
+ * The returned list reports the normalized entropy of the weights (get_entropy()), their effective sample size
+ * (get_ess(), (sum w)^2/sum w^2) and the fraction of duplicate samples (get_accept_rate()).
+ */
 MCMCList sample_posterior (
 		const PsiPsychometric *pmf,    ///< psychometric function model
 		const PsiData *data,           ///< dataset
 		PsiIndependentPosterior& post, ///< posterior approximation
 		unsigned int nsamples=600,     ///< number of samples to be drawn
-		unsigned int propose=25        ///< oversampling factor for the proposals
-		);   ///< sample from the posterior using sampling importance resampling
-
-void sample_diagnostics (
-		const PsiPsychometric *pmf,   ///< psychometric function model
-		const PsiData *data,          ///< dataset
-		MCMCList *samples             ///< parameter samples
-		);  ///< calculate sample diagnostics
+		unsigned int propose=25,       ///< oversampling factor for the proposals
+		unsigned int nthreads=1,       ///< number of threads that draw and weight the proposals
+		PsiRandomEngine * engine=NULL  ///< engine from which the random number streams are split (NULL for the global generator)
+		);
 
 #endif
@@ -0,0 +1,453 @@
+/*
+ *   See COPYING file distributed along with the psignifit package for
+ *   the copyright and license terms
+ */
+#include "mcfile.h"
+
+#include <cstdio>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/************************************************************
+ * File layout
+ */
+
+static const char mcfile_magic[8] = { 'P','S','I','M','C','B','I','N' };
+static const uint32_t mcfile_byteorder = 0x01020304;
+
+/* Fixed header at the start of every file (56 bytes, no padding) */
+struct PsiMCFileHead {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteorder;
+	uint32_t kind;
+	uint32_t nsamples;
+	uint32_t nparams;
+	uint32_t nblocks;
+	uint32_t ncuts;
+	uint32_t nsections;
+	uint64_t seed;
+	uint32_t textlength;         // header text: model and priors separated by newlines
+	uint32_t reserved;
+};
+
+/* Entry of the section table that follows the fixed header (24 bytes) */
+struct PsiMCFileEntry {
+	uint32_t id;
+	uint32_t type;               // 0: double, 1: int32
+	uint64_t count;              // number of values in the section
+	uint64_t offset;             // position of the first value from the start of the file
+};
+
+enum { MCFILE_DOUBLE=0, MCFILE_INT=1 };
+
+static uint64_t align8 ( uint64_t n ) { return (n+7) & ~uint64_t(7); }
+
+static uint64_t typesize ( uint32_t type ) { return type==MCFILE_DOUBLE ? sizeof(double) : sizeof(int32_t); }
+
+static PsiMCFileEntry makeentry ( PsiMCFileSection id, uint32_t type, uint64_t count ) {
+	PsiMCFileEntry entry;
+	entry.id = id;
+	entry.type = type;
+	entry.count = count;
+	entry.offset = 0;
+	return entry;
+}
+
+/************************************************************
+ * Writing
+ */
+
+static void write_or_throw ( const void * buffer, size_t size, size_t n, FILE * f ) {
+	if ( n>0 && fwrite ( buffer, size, n, f ) != n ) {
+		fclose ( f );
+		throw PsiError ( "writeMCFile: could not write sample file" );
+	}
+}
+
+static void write_padding ( uint64_t written, FILE * f ) {
+	static const char zeros[8] = { 0,0,0,0,0,0,0,0 };
+	write_or_throw ( zeros, 1, align8 ( written ) - written, f );
+}
+
+static FILE * write_head (
+		const std::string& fname,
+		PsiMCFileKind kind,
+		unsigned int nsamples, unsigned int nparams, unsigned int nblocks, unsigned int ncuts,
+		const PsiMCFileHeader& header,
+		std::vector<PsiMCFileEntry> * table
+		)
+{
+	/* Write fixed header, section table and header text. Offsets in table are filled in here. */
+	unsigned int i;
+	std::string text ( header.model );
+	for ( i=0; i<header.priors.size(); i++ )
+		text += "\n" + header.priors[i];
+
+	PsiMCFileHead head;
+	memset ( &head, 0, sizeof(head) );
+	memcpy ( head.magic, mcfile_magic, 8 );
+	head.version    = PSI_MCFILE_VERSION;
+	head.byteorder  = mcfile_byteorder;
+	head.kind       = kind;
+	head.nsamples   = nsamples;
+	head.nparams    = nparams;
+	head.nblocks    = nblocks;
+	head.ncuts      = ncuts;
+	head.nsections  = table->size();
+	head.seed       = header.seed;
+	head.textlength = text.size();
+
+	uint64_t offset ( align8 ( sizeof(head) + table->size()*sizeof(PsiMCFileEntry) + text.size() ) );
+	for ( i=0; i<table->size(); i++ ) {
+		(*table)[i].offset = offset;
+		offset = align8 ( offset + (*table)[i].count * typesize ( (*table)[i].type ) );
+	}
+
+	FILE * f ( fopen ( fname.c_str(), "wb" ) );
+	if ( f==NULL )
+		throw PsiError ( "writeMCFile: could not open sample file for writing" );
+
+	write_or_throw ( &head, sizeof(head), 1, f );
+	write_or_throw ( &((*table)[0]), sizeof(PsiMCFileEntry), table->size(), f );
+	write_or_throw ( text.data(), 1, text.size(), f );
+	write_padding ( sizeof(head) + table->size()*sizeof(PsiMCFileEntry) + text.size(), f );
+	return f;
+}
+
+static void write_doubles ( const double * x, uint64_t n, FILE * f ) {
+	write_or_throw ( x, sizeof(double), n, f );
+}
+
+static void write_doubles ( const std::vector<double>& x, FILE * f ) {
+	write_doubles ( x.size()>0 ? &(x[0]) : NULL, x.size(), f );
+}
+
+static void write_rows ( const int * row, unsigned int n, std::vector<int32_t> * buffer, FILE * f ) {
+	/* int may be wider than the 4 bytes stored in the file */
+	if ( n==0 )
+		return;
+	std::copy ( row, row+n, buffer->begin() );
+	write_or_throw ( &((*buffer)[0]), sizeof(int32_t), n, f );
+}
+
+static void close_or_throw ( FILE * f ) {
+	if ( fclose ( f ) != 0 )
+		throw PsiError ( "writeMCFile: could not write sample file" );
+}
+
+void writeMCFile (
+		const std::string& fname,
+		const MCMCList& samples,
+		const PsiMCFileHeader& header,
+		const PsiPsychometric * pmf,
+		const std::vector<double>& cuts
+		)
+{
+	unsigned int i, j;
+	unsigned int N ( samples.getNsamples() ), nprm ( samples.getNparams() ), nblocks ( samples.getNblocks() );
+	unsigned int ncuts ( pmf==NULL ? 0 : cuts.size() );
+	std::vector<double> column ( N );
+	std::vector<int32_t> row ( nblocks );
+
+	std::vector<PsiMCFileEntry> table;
+	table.push_back ( makeentry ( MCFILE_ESTIMATES,   MCFILE_DOUBLE, uint64_t(N)*nprm ) );
+	table.push_back ( makeentry ( MCFILE_DEVIANCES,   MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_RPD,         MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_RKD,         MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_DATA,        MCFILE_INT,    uint64_t(N)*nblocks ) );
+	table.push_back ( makeentry ( MCFILE_PPDEVIANCES, MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_PPRPD,       MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_PPRKD,       MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_LOGRATIOS,   MCFILE_DOUBLE, uint64_t(N)*nblocks ) );
+	if ( ncuts>0 ) {
+		table.push_back ( makeentry ( MCFILE_CUTS,       MCFILE_DOUBLE, ncuts ) );
+		table.push_back ( makeentry ( MCFILE_THRESHOLDS, MCFILE_DOUBLE, uint64_t(N)*ncuts ) );
+		table.push_back ( makeentry ( MCFILE_SLOPES,     MCFILE_DOUBLE, uint64_t(N)*ncuts ) );
+	}
+
+	FILE * f ( write_head ( fname, MCFILE_MCMC, N, nprm, nblocks, ncuts, header, &table ) );
+
+	for ( j=0; j<nprm; j++ )
+		write_doubles ( samples.getColumn ( j ), N, f );
+	write_doubles ( samples.getDeviances(), N, f );
+	for ( i=0; i<N; i++ ) column[i] = samples.getRpd ( i );
+	write_doubles ( column, f );
+	for ( i=0; i<N; i++ ) column[i] = samples.getRkd ( i );
+	write_doubles ( column, f );
+	for ( i=0; i<N; i++ )
+		write_rows ( samples.getppDataRow ( i ), nblocks, &row, f );
+	write_padding ( uint64_t(N)*nblocks*sizeof(int32_t), f );
+	for ( i=0; i<N; i++ ) column[i] = samples.getppDeviance ( i );
+	write_doubles ( column, f );
+	for ( i=0; i<N; i++ ) column[i] = samples.getppRpd ( i );
+	write_doubles ( column, f );
+	for ( i=0; i<N; i++ ) column[i] = samples.getppRkd ( i );
+	write_doubles ( column, f );
+	for ( i=0; i<N; i++ )
+		write_doubles ( samples.getlogratioRow ( i ), nblocks, f );
+
+	if ( ncuts>0 ) {
+		std::vector<double> theta ( nprm );
+		std::vector<double> slopes ( uint64_t(N)*ncuts );
+		write_doubles ( cuts, f );
+		// Thresholds are written column by column, slopes are kept until all thresholds are written
+		for ( j=0; j<ncuts; j++ ) {
+			for ( i=0; i<N; i++ ) {
+				samples.copyEst ( i, &theta );
+				column[i] = pmf->getThres ( theta, cuts[j] );
+				slopes[j*N+i] = pmf->getSlope ( theta, column[i] );
+			}
+			write_doubles ( column, f );
+		}
+		write_doubles ( slopes, f );
+	}
+
+	close_or_throw ( f );
+}
+
+void writeMCFile (
+		const std::string& fname,
+		const BootstrapList& samples,
+		const PsiMCFileHeader& header
+		)
+{
+	unsigned int i, j;
+	unsigned int N ( samples.getNsamples() ), nprm ( samples.getNparams() ), nblocks ( samples.getNblocks() );
+	unsigned int ncuts ( samples.getNcuts() );
+	std::vector<double> column ( N );
+	std::vector<int32_t> row ( nblocks );
+
+	std::vector<PsiMCFileEntry> table;
+	table.push_back ( makeentry ( MCFILE_ESTIMATES,  MCFILE_DOUBLE, uint64_t(N)*nprm ) );
+	table.push_back ( makeentry ( MCFILE_DEVIANCES,  MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_RPD,        MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_RKD,        MCFILE_DOUBLE, N ) );
+	table.push_back ( makeentry ( MCFILE_DATA,       MCFILE_INT,    uint64_t(N)*nblocks ) );
+	table.push_back ( makeentry ( MCFILE_CUTS,       MCFILE_DOUBLE, ncuts ) );
+	table.push_back ( makeentry ( MCFILE_THRESHOLDS, MCFILE_DOUBLE, uint64_t(N)*ncuts ) );
+	table.push_back ( makeentry ( MCFILE_SLOPES,     MCFILE_DOUBLE, uint64_t(N)*ncuts ) );
+
+	FILE * f ( write_head ( fname, MCFILE_BOOTSTRAP, N, nprm, nblocks, ncuts, header, &table ) );
+
+	for ( j=0; j<nprm; j++ )
+		write_doubles ( samples.getColumn ( j ), N, f );
+	write_doubles ( samples.getDeviances(), N, f );
+	for ( i=0; i<N; i++ ) column[i] = samples.getRpd ( i );
+	write_doubles ( column, f );
+	for ( i=0; i<N; i++ ) column[i] = samples.getRkd ( i );
+	write_doubles ( column, f );
+	for ( i=0; i<N; i++ )
+		write_rows ( samples.getDataRow ( i ), nblocks, &row, f );
+	write_padding ( uint64_t(N)*nblocks*sizeof(int32_t), f );
+	std::vector<double> cutvalues ( ncuts );
+	for ( j=0; j<ncuts; j++ ) cutvalues[j] = samples.getCut ( j );
+	write_doubles ( cutvalues, f );
+	for ( j=0; j<ncuts; j++ )
+		write_doubles ( samples.getThresColumn ( j ), N, f );
+	for ( j=0; j<ncuts; j++ )
+		write_doubles ( samples.getSlopeColumn ( j ), N, f );
+
+	close_or_throw ( f );
+}
+
+/************************************************************
+ * PsiMCFile methods
+ */
+
+/* Type and number of values of a known section in a file with the sizes in head, false for sections that are not known */
+static bool section_layout ( uint32_t id, const PsiMCFileHead * head, uint32_t * type, uint64_t * count )
+{
+	uint64_t N ( head->nsamples );
+	*type = MCFILE_DOUBLE;
+	switch ( id ) {
+		case MCFILE_ESTIMATES:
+			*count = N*head->nparams; break;
+		case MCFILE_DEVIANCES: case MCFILE_RPD: case MCFILE_RKD:
+		case MCFILE_PPDEVIANCES: case MCFILE_PPRPD: case MCFILE_PPRKD:
+			*count = N; break;
+		case MCFILE_CUTS:
+			*count = head->ncuts; break;
+		case MCFILE_THRESHOLDS: case MCFILE_SLOPES:
+			*count = N*head->ncuts; break;
+		case MCFILE_DATA:
+			*type = MCFILE_INT;
+			*count = N*head->nblocks; break;
+		case MCFILE_LOGRATIOS:
+			*count = N*head->nblocks; break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+/* The file is mapped into memory where mmap is available. On Windows, it is read into a buffer instead. */
+static void * load_file ( const std::string& fname, size_t * length )
+{
+#ifdef _WIN32
+	FILE * f ( fopen ( fname.c_str(), "rb" ) );
+	if ( f==NULL )
+		throw PsiError ( "PsiMCFile: could not open sample file" );
+	long size ( -1 );
+	if ( fseek ( f, 0, SEEK_END )==0 )
+		size = ftell ( f );
+	if ( size < long(sizeof(PsiMCFileHead)) || fseek ( f, 0, SEEK_SET )!=0 ) {
+		fclose ( f );
+		throw PsiError ( "PsiMCFile: not a sample file" );
+	}
+	*length = size;
+	char * buffer ( new char [*length] );
+	if ( fread ( buffer, 1, *length, f ) != *length ) {
+		fclose ( f );
+		delete [] buffer;
+		throw PsiError ( "PsiMCFile: could not read sample file" );
+	}
+	fclose ( f );
+	return buffer;
+#else
+	int fd ( open ( fname.c_str(), O_RDONLY ) );
+	if ( fd<0 )
+		throw PsiError ( "PsiMCFile: could not open sample file" );
+
+	struct stat st;
+	if ( fstat ( fd, &st ) != 0 || size_t(st.st_size) < sizeof(PsiMCFileHead) ) {
+		close ( fd );
+		throw PsiError ( "PsiMCFile: not a sample file" );
+	}
+	*length = st.st_size;
+	void * mapping ( mmap ( NULL, *length, PROT_READ, MAP_SHARED, fd, 0 ) );
+	close ( fd );
+	if ( mapping==MAP_FAILED )
+		throw PsiError ( "PsiMCFile: could not map sample file" );
+	return mapping;
+#endif
+}
+
+static void unload_file ( void * mapping, size_t length )
+{
+#ifdef _WIN32
+	delete [] static_cast<char*> ( mapping );
+#else
+	munmap ( mapping, length );
+#endif
+}
+
+PsiMCFile::PsiMCFile ( const std::string& fname ) : mapping ( NULL ), length ( 0 ), sections ( MCFILE_LOGRATIOS+1, (const void*)NULL )
+{
+	mapping = load_file ( fname, &length );
+
+	const char * base ( static_cast<const char*> ( mapping ) );
+	const PsiMCFileHead * head ( reinterpret_cast<const PsiMCFileHead*> ( base ) );
+	const char * error ( NULL );
+	if ( memcmp ( head->magic, mcfile_magic, 8 ) != 0 )
+		error = "PsiMCFile: not a sample file";
+	else if ( head->byteorder != mcfile_byteorder )
+		error = "PsiMCFile: sample file was written with a different byte order";
+	else if ( head->version > PSI_MCFILE_VERSION )
+		error = "PsiMCFile: sample file was written by a newer version";
+	else if ( head->kind!=MCFILE_MCMC && head->kind!=MCFILE_BOOTSTRAP )
+		error = "PsiMCFile: unknown kind of sample list";
+	else if ( sizeof(PsiMCFileHead) + uint64_t(head->nsections)*sizeof(PsiMCFileEntry) + head->textlength > length )
+		error = "PsiMCFile: sample file is truncated";
+
+	// Sections must be within the file and have the sizes given in the header, such
+	// that the getters can rely on the header sizes
+	unsigned int i;
+	uint32_t type;
+	uint64_t count;
+	const PsiMCFileEntry * table ( reinterpret_cast<const PsiMCFileEntry*> ( base + sizeof(PsiMCFileHead) ) );
+	for ( i=0; error==NULL && i<head->nsections; i++ ) {
+		if ( table[i].offset%8 != 0 || table[i].offset > length || table[i].count > (length-table[i].offset)/typesize ( table[i].type ) )
+			error = "PsiMCFile: sample file is truncated";
+		else if ( !section_layout ( table[i].id, head, &type, &count ) )
+			continue;                              // Sections added by later versions are skipped
+		else if ( table[i].type!=type || table[i].count!=count )
+			error = "PsiMCFile: section does not match the sizes in the header";
+		else
+			sections[table[i].id] = base + table[i].offset;
+	}
+	if ( error!=NULL ) {
+		unload_file ( mapping, length );
+		throw PsiError ( error );
+	}
+
+	version  = head->version;
+	kind     = PsiMCFileKind ( head->kind );
+	nsamples = head->nsamples;
+	nparams  = head->nparams;
+	nblocks  = head->nblocks;
+	ncuts    = head->ncuts;
+
+	// Header text
+	std::string text ( base + sizeof(PsiMCFileHead) + head->nsections*sizeof(PsiMCFileEntry), head->textlength );
+	size_t start ( 0 ), end ( text.find ( '\n' ) );
+	header.model = text.substr ( 0, end );
+	while ( end!=std::string::npos ) {
+		start = end+1;
+		end = text.find ( '\n', start );
+		header.priors.push_back ( text.substr ( start, end==std::string::npos ? std::string::npos : end-start ) );
+	}
+	header.seed = head->seed;
+}
+
+PsiMCFile::~PsiMCFile ( void )
+{
+	if ( mapping!=NULL )
+		unload_file ( mapping, length );
+}
+
+bool PsiMCFile::hasSection ( PsiMCFileSection section ) const
+{
+	if ( unsigned(section)>=sections.size() )
+		return false;
+	return sections[section]!=NULL;
+}
+
+const double * PsiMCFile::doubleSection ( PsiMCFileSection section ) const
+{
+	if ( !hasSection ( section ) )
+		throw BadArgumentError ( "PsiMCFile: section not present in sample file" );
+	return static_cast<const double*> ( sections[section] );
+}
+
+const double * PsiMCFile::getColumn ( unsigned int prm ) const
+{
+	if ( prm>=nparams )
+		throw BadIndexError();
+	return doubleSection ( MCFILE_ESTIMATES ) + uint64_t(prm)*nsamples;
+}
+
+const double * PsiMCFile::getThresColumn ( unsigned int cut ) const
+{
+	if ( cut>=ncuts )
+		throw BadIndexError();
+	return doubleSection ( MCFILE_THRESHOLDS ) + uint64_t(cut)*nsamples;
+}
+
+const double * PsiMCFile::getSlopeColumn ( unsigned int cut ) const
+{
+	if ( cut>=ncuts )
+		throw BadIndexError();
+	return doubleSection ( MCFILE_SLOPES ) + uint64_t(cut)*nsamples;
+}
+
+const int32_t * PsiMCFile::getDataRow ( unsigned int i ) const
+{
+	if ( i>=nsamples )
+		throw BadIndexError();
+	if ( !hasSection ( MCFILE_DATA ) )
+		throw BadArgumentError ( "PsiMCFile: section not present in sample file" );
+	return static_cast<const int32_t*> ( sections[MCFILE_DATA] ) + uint64_t(i)*nblocks;
+}
+
+const double * PsiMCFile::getlogratioRow ( unsigned int i ) const
+{
+	if ( i>=nsamples )
+		throw BadIndexError();
+	return doubleSection ( MCFILE_LOGRATIOS ) + uint64_t(i)*nblocks;
+}
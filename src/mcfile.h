@@ -0,0 +1,126 @@
+/*
+ *   See COPYING file distributed along with the psignifit package for
+ *   the copyright and license terms
+ */
+#ifndef MCFILE_H
+#define MCFILE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "errors.h"
+#include "mclist.h"
+#include "psychometric.h"
+
+/** \brief version of the binary sample file format written by this library */
+#define PSI_MCFILE_VERSION 1
+
+/** \brief kind of sample list stored in a binary sample file */
+enum PsiMCFileKind {
+	MCFILE_MCMC=1,          ///< samples from an MCMCList
+	MCFILE_BOOTSTRAP=2      ///< samples from a BootstrapList
+};
+
+/** \brief sections of a binary sample file
+ *
+ * All sections are columnar: a "column" is a contiguous run of getNsamples() values. Sections of type double hold
+ * 8 byte doubles, sections of type int hold 4 byte integers. Only sections that apply to the stored list are present.
+ */
+enum PsiMCFileSection {
+	MCFILE_ESTIMATES=1,     ///< double, getNparams() columns (one per parameter)
+	MCFILE_DEVIANCES=2,     ///< double, one column
+	MCFILE_CUTS=3,          ///< double, getNcuts() values
+	MCFILE_THRESHOLDS=4,    ///< double, getNcuts() columns (one per cut)
+	MCFILE_SLOPES=5,        ///< double, getNcuts() columns (one per cut)
+	MCFILE_RPD=6,           ///< double, one column
+	MCFILE_RKD=7,           ///< double, one column
+	MCFILE_DATA=8,          ///< int, getNsamples() rows of getNblocks() responses (bootstrap data or posterior predictive data)
+	MCFILE_PPDEVIANCES=9,   ///< double, one column (MCMC only)
+	MCFILE_PPRPD=10,        ///< double, one column (MCMC only)
+	MCFILE_PPRKD=11,        ///< double, one column (MCMC only)
+	MCFILE_LOGRATIOS=12     ///< double, getNsamples() rows of getNblocks() log posterior ratios (MCMC only)
+};
+
+/** \brief description of the analysis that produced a sample file
+ *
+ * The model and the priors are stored as free text (e.g. the command line specification "mw0.1 logistic nafc=2" and
+ * "Gauss(0,5)"). Neither may contain a newline.
+ */
+struct PsiMCFileHeader {
+	std::string model;                  ///< description of the psychometric function model
+	std::vector<std::string> priors;    ///< description of the prior for each parameter
+	unsigned long seed;                 ///< seed of the random number generator used for sampling
+	PsiMCFileHeader ( void ) : seed ( 0 ) {}
+};
+
+/** \brief write mcmc samples to a binary sample file
+ *
+ * If pmf is given, thresholds and slopes at cuts are determined for every sample and stored as well.
+ */
+void writeMCFile (
+		const std::string& fname,                          ///< name of the output file
+		const MCMCList& samples,                           ///< samples to be stored
+		const PsiMCFileHeader& header,                     ///< description of the analysis
+		const PsiPsychometric * pmf=NULL,                  ///< model used to determine thresholds and slopes
+		const std::vector<double>& cuts=std::vector<double>()  ///< cuts at which thresholds and slopes are determined
+		);
+
+/** \brief write bootstrap samples to a binary sample file */
+void writeMCFile (
+		const std::string& fname,                          ///< name of the output file
+		const BootstrapList& samples,                      ///< samples to be stored
+		const PsiMCFileHeader& header                      ///< description of the analysis
+		);
+
+/** \brief read only view of a binary sample file
+ *
+ * The file is mapped into memory as a whole (on Windows, it is read into memory instead). All pointers returned refer
+ * directly into the mapping (nothing is copied) and are valid as long as the PsiMCFile object exists.
+ *
+ * The file starts with a fixed header (magic "PSIMCBIN", format version, byte order mark, kind of list, sizes and
+ * seed), followed by a table of sections, the header text and the sections themselves, each aligned to 8 bytes.
+ * Files are written in the native byte order; files with a different byte order are rejected, as are files with
+ * sections that do not match the sizes in the header.
+ */
+class PsiMCFile
+{
+	private:
+		void * mapping;
+		size_t length;
+		unsigned int version;
+		PsiMCFileKind kind;
+		unsigned int nsamples;
+		unsigned int nparams;
+		unsigned int nblocks;
+		unsigned int ncuts;
+		PsiMCFileHeader header;
+		std::vector<const void*> sections;   // indexed by PsiMCFileSection, NULL if not present
+		PsiMCFile ( const PsiMCFile& );
+		PsiMCFile& operator= ( const PsiMCFile& );
+		const double * doubleSection ( PsiMCFileSection section ) const;
+	public:
+		PsiMCFile ( const std::string& fname );                            ///< map the file fname into memory
+		~PsiMCFile ( void );
+		unsigned int getVersion ( void ) const { return version; }         ///< format version of the file
+		PsiMCFileKind getKind ( void ) const { return kind; }              ///< kind of list stored in the file
+		unsigned int getNsamples ( void ) const { return nsamples; }       ///< number of samples
+		unsigned int getNparams ( void ) const { return nparams; }         ///< number of parameters
+		unsigned int getNblocks ( void ) const { return nblocks; }         ///< number of blocks in the data
+		unsigned int getNcuts ( void ) const { return ncuts; }             ///< number of cuts at which thresholds and slopes are stored
+		const PsiMCFileHeader& getHeader ( void ) const { return header; } ///< model, priors and seed
+		bool hasSection ( PsiMCFileSection section ) const;                ///< is the section present in the file?
+		const double * getColumn ( unsigned int prm ) const;               ///< all samples of parameter prm
+		const double * getDeviances ( void ) const { return doubleSection ( MCFILE_DEVIANCES ); }     ///< all deviances
+		const double * getCuts ( void ) const { return doubleSection ( MCFILE_CUTS ); }               ///< the cuts
+		const double * getThresColumn ( unsigned int cut ) const;          ///< all thresholds at cut
+		const double * getSlopeColumn ( unsigned int cut ) const;          ///< all slopes at cut
+		const double * getRpd ( void ) const { return doubleSection ( MCFILE_RPD ); }                 ///< correlations between predicted values and deviance residuals
+		const double * getRkd ( void ) const { return doubleSection ( MCFILE_RKD ); }                 ///< correlations between block index and deviance residuals
+		const int32_t * getDataRow ( unsigned int i ) const;               ///< the getNblocks() responses of sample i
+		const double * getppDeviances ( void ) const { return doubleSection ( MCFILE_PPDEVIANCES ); } ///< deviances of the posterior predictive data
+		const double * getppRpd ( void ) const { return doubleSection ( MCFILE_PPRPD ); }             ///< Rpd of the posterior predictive data
+		const double * getppRkd ( void ) const { return doubleSection ( MCFILE_PPRKD ); }             ///< Rkd of the posterior predictive data
+		const double * getlogratioRow ( unsigned int i ) const;            ///< the getNblocks() log posterior ratios of sample i
+};
+
+#endif
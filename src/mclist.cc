@@ -4,10 +4,11 @@
  */
 #include "mclist.h"
 
-void newsample ( const PsiData * data, const std::vector<double>& p, std::vector<int> * sample ) {
+void newsample ( const PsiData * data, const std::vector<double>& p, std::vector<int> * sample, PsiRandomEngine * engine ) {
 	/* Draw a new sample from the psychometric function */
 	BinomialRandom binomial ( 10, 0.5 );    // Initialize with nonsense parameters
 	unsigned int k;                                            // Block index
+	binomial.setEngine ( engine );
 
 	for ( k=0; k<data->getNblocks(); k++ ) {
 		binomial.setprm ( data->getNtrials(k), p[k] );
@@ -25,13 +26,28 @@ std::vector<double> PsiMClist::getEst ( unsigned int i ) const
 	if ( i>=getNsamples() )
 		throw BadIndexError();
 
-	unsigned int k;
 	std::vector<double> out ( getNparams() );
+	copyEst ( i, &out );
+
+	return out;
+}
 
+void PsiMClist::copyEst ( unsigned int i, std::vector<double> * est ) const
+{
+	if ( i>=getNsamples() )
+		throw BadIndexError();
+
+	unsigned int k;
 	for (k=0; k<getNparams(); k++)
-		out[k] = mcestimates[k][i];
+		(*est)[k] = mcestimates[k*nsamples+i];
+}
 
-	return out;
+const double * PsiMClist::getColumn ( unsigned int prm ) const
+{
+	if ( prm>=getNparams() )
+		throw BadIndexError();
+
+	return nsamples>0 ? &(mcestimates[prm*nsamples]) : NULL;
 }
 
 double PsiMClist::getEst ( unsigned int i, unsigned int prm ) const
@@ -42,19 +58,22 @@ double PsiMClist::getEst ( unsigned int i, unsigned int prm ) const
 	if ( prm>=getNparams() )
 		throw BadIndexError();
 
-	return mcestimates[prm][i];
+	return mcestimates[prm*nsamples+i];
 }
 
-void PsiMClist::setEst ( unsigned int i, const std::vector<double> est, double deviance )
+void PsiMClist::setEst ( unsigned int i, const std::vector<double>& est, double deviance )
 {
 	// Check that the call does not ask for something we can't do
 	if ( i>=getNsamples() )
 		throw BadIndexError();
 
 	unsigned int k;
-	for ( k=0; k<getNparams(); k++ )
-		mcestimates[k][i] = est[k];
+	for ( k=0; k<getNparams(); k++ ) {
+		mcestimates[k*nsamples+i] = est[k];
+		estimateorder[k].invalidate();
+	}
 	deviances[i] = deviance;
+	devianceorder.invalidate();
 }
 
 double PsiMClist::getPercentile ( double p, unsigned int prm ) {
@@ -64,11 +83,9 @@ double PsiMClist::getPercentile ( double p, unsigned int prm ) {
 		throw BadArgumentError();
 
 	int position;
-	sort( mcestimates[prm].begin(),mcestimates[prm].end() );
-
 	position = getNsamples()*p;
 
-	return mcestimates[prm][position];
+	return estimateorder[prm].get ( getColumn ( prm ), nsamples, position );
 }
 
 void PsiMClist::setdeviance ( unsigned int i, double deviance ) {
@@ -76,6 +93,7 @@ void PsiMClist::setdeviance ( unsigned int i, double deviance ) {
 		throw BadIndexError();
 
 	deviances[i] = deviance;
+	devianceorder.invalidate();
 }
 
 double PsiMClist::getdeviance ( unsigned int i ) const {
@@ -91,9 +109,7 @@ double PsiMClist::getDeviancePercentile ( double p ) {
 
 	int ind ( p*deviances.size() );
 
-	sort( deviances.begin(), deviances.end() );
-
-	return deviances[ind];
+	return devianceorder.get ( getDeviances(), nsamples, ind );
 }
 
 double PsiMClist::getMean ( unsigned int prm ) const {
@@ -102,8 +118,9 @@ double PsiMClist::getMean ( unsigned int prm ) const {
 	if ( prm>=getNparams() )
 		throw BadIndexError();
 
+	const double * column ( getColumn ( prm ) );
 	for (i=0; i<Nsamples; i++)
-		m += getEst ( i, prm );
+		m += column[i];
 
 	m /= Nsamples;
 	return m;
@@ -115,8 +132,9 @@ double PsiMClist::getStd ( unsigned int prm ) const {
 	if ( prm>=getNparams() )
 		throw BadIndexError();
 
+	const double * column ( getColumn ( prm ) );
 	for (i=0; i<Nsamples; i++) {
-		ss = getEst ( i, prm ) - m;
+		ss = column[i] - m;
 		s += ss*ss;
 	}
 
@@ -135,15 +153,37 @@ void BootstrapList::setData ( unsigned int i, const std::vector<int>& newdata )
 
 	unsigned int k;
 	for ( k=0; k<getNblocks(); k++ )
-		data[i][k] = newdata[k];
+		data[i*nblocks+k] = newdata[k];
 }
 
 std::vector<int> BootstrapList::getData ( unsigned int i ) const
 {
-	if ( i>=getNsamples() || i<0 )
+	const int * row ( getDataRow ( i ) );
+	return std::vector<int> ( row, row+nblocks );
+}
+
+const int * BootstrapList::getDataRow ( unsigned int i ) const
+{
+	if ( i>=getNsamples() )
 		throw BadIndexError();
 
-	return data[i];
+	return nblocks>0 ? &(data[i*nblocks]) : NULL;
+}
+
+const double * BootstrapList::getThresColumn ( unsigned int cut ) const
+{
+	if ( cut>=cuts.size() )
+		throw BadIndexError();
+
+	return getNsamples()>0 ? &(thresholds[cut*getNsamples()]) : NULL;
+}
+
+const double * BootstrapList::getSlopeColumn ( unsigned int cut ) const
+{
+	if ( cut>=cuts.size() )
+		throw BadIndexError();
+
+	return getNsamples()>0 ? &(slopes[cut*getNsamples()]) : NULL;
 }
 
 double BootstrapList::getThres ( double p, unsigned int cut ) {
@@ -153,7 +193,6 @@ double BootstrapList::getThres ( double p, unsigned int cut ) {
 		throw BadArgumentError();
 
 	int position;
-	sort( thresholds[cut].begin(), thresholds[cut].end() );
 
 	// Bias correction of p
 	if (BCa)
@@ -161,7 +200,7 @@ double BootstrapList::getThres ( double p, unsigned int cut ) {
 
 	position = int(getNsamples()*p);
 
-	return thresholds[cut][position];
+	return thresholdorder[cut].get ( getThresColumn ( cut ), getNsamples(), position );
 }
 
 double BootstrapList::getThres_byPos ( unsigned int i, unsigned int cut ) {
@@ -170,7 +209,7 @@ double BootstrapList::getThres_byPos ( unsigned int i, unsigned int cut ) {
 	if (i>getNsamples())
 		throw BadIndexError();
 
-	return thresholds[cut][i];
+	return thresholds[cut*getNsamples()+i];
 }
 
 void BootstrapList::setThres ( double thres, unsigned int i, unsigned int cut )
@@ -180,7 +219,8 @@ void BootstrapList::setThres ( double thres, unsigned int i, unsigned int cut )
 	if (cut>=cuts.size() )
 		throw BadIndexError();
 
-	thresholds[cut][i] = thres;
+	thresholds[cut*getNsamples()+i] = thres;
+	thresholdorder[cut].invalidate();
 }
 
 double BootstrapList::getSlope ( double p, unsigned int cut ) {
@@ -190,7 +230,6 @@ double BootstrapList::getSlope ( double p, unsigned int cut ) {
 		throw BadArgumentError();
 
 	int position;
-	sort( slopes[cut].begin(), slopes[cut].end() );
 
 	// Bias correction of p
 	if (BCa)
@@ -198,7 +237,7 @@ double BootstrapList::getSlope ( double p, unsigned int cut ) {
 
 	position = int(getNsamples()*p);
 
-	return slopes[cut][position];
+	return slopeorder[cut].get ( getSlopeColumn ( cut ), getNsamples(), position );
 }
 
 double BootstrapList::getSlope_byPos ( unsigned int i, unsigned int cut ) {
@@ -207,7 +246,7 @@ double BootstrapList::getSlope_byPos ( unsigned int i, unsigned int cut ) {
 	if (i>getNsamples())
 		throw BadIndexError();
 
-	return slopes[cut][i];
+	return slopes[cut*getNsamples()+i];
 }
 
 void BootstrapList::setSlope ( double slope, unsigned int i, unsigned int cut )
@@ -217,7 +256,8 @@ void BootstrapList::setSlope ( double slope, unsigned int i, unsigned int cut )
 	if (cut>=cuts.size() )
 		throw BadIndexError();
 
-	slopes[cut][i] = slope;
+	slopes[cut*getNsamples()+i] = slope;
+	slopeorder[cut].invalidate();
 }
 
 double BootstrapList::getCut ( unsigned int i ) const
@@ -233,6 +273,7 @@ void BootstrapList::setRpd ( unsigned int i, double r_pd ) {
 		throw BadIndexError();
 
 	Rpd[i] = r_pd;
+	Rpdorder.invalidate();
 }
 
 double BootstrapList::getRpd ( unsigned int i ) const {
@@ -248,9 +289,7 @@ double BootstrapList::percRpd ( double p ) {
 
 	int index ( p*(getNsamples()-1));
 
-	sort ( Rpd.begin(), Rpd.end() );
-
-	return Rpd[index];
+	return Rpdorder.get ( &(Rpd[0]), getNsamples(), index );
 }
 
 void BootstrapList::setRkd ( unsigned int i, double r_kd ) {
@@ -258,6 +297,7 @@ void BootstrapList::setRkd ( unsigned int i, double r_kd ) {
 		throw BadIndexError();
 
 	Rkd[i] = r_kd;
+	Rkdorder.invalidate();
 }
 
 double BootstrapList::getRkd ( unsigned int i ) const {
@@ -273,9 +313,7 @@ double BootstrapList::percRkd ( double p ) {
 
 	int index ( p*(getNsamples()-1) );
 
-	sort ( Rkd.begin(), Rkd.end() );
-
-	return Rkd[index];
+	return Rkdorder.get ( &(Rkd[0]), getNsamples(), index );
 }
 
 /************************************************************
@@ -320,16 +358,22 @@ void MCMCList::setppData ( unsigned int i, const std::vector<int>& ppdata, doubl
 
 	unsigned int k;
 	for ( k=0; k<getNblocks(); k++ )
-		posterior_predictive_data[i][k] = ppdata[k];
+		posterior_predictive_data[i*nblocks+k] = ppdata[k];
 	posterior_predictive_deviances[i] = ppdeviance;
 }
 
 std::vector<int> MCMCList::getppData ( unsigned int i ) const
 {
-	if ( i>=getNsamples() || i<0 )
+	const int * row ( getppDataRow ( i ) );
+	return std::vector<int> ( row, row+nblocks );
+}
+
+const int * MCMCList::getppDataRow ( unsigned int i ) const
+{
+	if ( i>=getNsamples() )
 		throw BadIndexError();
 
-	return posterior_predictive_data[i];
+	return nblocks>0 ? &(posterior_predictive_data[i*nblocks]) : NULL;
 }
 
 int MCMCList::getppData ( unsigned int i, unsigned int j ) const
@@ -339,7 +383,7 @@ int MCMCList::getppData ( unsigned int i, unsigned int j ) const
 	if ( j>=getNblocks() )
 		throw BadIndexError();
 
-	return posterior_predictive_data[i][j];
+	return posterior_predictive_data[i*nblocks+j];
 }
 
 double MCMCList::getppDeviance ( unsigned int i ) const
@@ -422,7 +466,7 @@ void MCMCList::setlogratio ( unsigned int i, unsigned int j, double logratio )
 	if ( j>=getNblocks() )
 		throw BadIndexError();
 
-	logratios[i][j] = logratio;
+	logratios[i*nblocks+j] = logratio;
 }
 
 double MCMCList::getlogratio ( unsigned int i, unsigned int j ) const
@@ -432,5 +476,180 @@ double MCMCList::getlogratio ( unsigned int i, unsigned int j ) const
 	if ( j>=getNblocks() )
 		throw BadIndexError();
 
-	return logratios[i][j];
+	return logratios[i*nblocks+j];
+}
+
+const double * MCMCList::getlogratioRow ( unsigned int i ) const
+{
+	if ( i>=getNsamples() )
+		throw BadIndexError();
+
+	return nblocks>0 ? &(logratios[i*nblocks]) : NULL;
+}
+
+/************************************************************
+ * PsiP2Quantile methods
+ */
+
+PsiP2Quantile::PsiP2Quantile ( double prob ) : p ( prob ), count ( 0 )
+{
+	if ( prob<=0 || prob>=1 )
+		throw BadArgumentError ( "PsiP2Quantile: probability has to be in the range (0,1)" );
+	unsigned int i;
+	for ( i=0; i<5; i++ )
+		q[i] = n[i] = 0;
+	np[0] = 0; np[1] = 2*p; np[2] = 4*p; np[3] = 2+2*p; np[4] = 4;
+	dn[0] = 0; dn[1] = p/2; dn[2] = p;   dn[3] = (1+p)/2; dn[4] = 1;
+}
+
+void PsiP2Quantile::add ( double x )
+{
+	int i, k, s;
+	double d, qp;
+
+	if ( count<5 ) {
+		q[count++] = x;
+		if ( count==5 ) {
+			std::sort ( q, q+5 );
+			for ( i=0; i<5; i++ )
+				n[i] = i;
+		}
+		return;
+	}
+
+	// Find the cell of x and adjust the extreme markers
+	if ( x<q[0] ) {
+		q[0] = x;
+		k = 0;
+	} else if ( x>=q[4] ) {
+		q[4] = x;
+		k = 3;
+	} else {
+		for ( k=0; k<3; k++ )
+			if ( x<q[k+1] ) break;
+	}
+
+	for ( i=k+1; i<5; i++ )
+		n[i] += 1;
+	for ( i=0; i<5; i++ )
+		np[i] += dn[i];
+
+	// Adjust the heights of the middle markers
+	for ( i=1; i<4; i++ ) {
+		d = np[i]-n[i];
+		if ( ( d>=1 && n[i+1]-n[i]>1 ) || ( d<=-1 && n[i-1]-n[i]<-1 ) ) {
+			s = ( d>0 ? 1 : -1 );
+			// parabolic prediction
+			qp = q[i] + s/(n[i+1]-n[i-1]) * ( (n[i]-n[i-1]+s)*(q[i+1]-q[i])/(n[i+1]-n[i]) + (n[i+1]-n[i]-s)*(q[i]-q[i-1])/(n[i]-n[i-1]) );
+			if ( q[i-1]<qp && qp<q[i+1] )
+				q[i] = qp;
+			else
+				q[i] += s*(q[i+s]-q[i])/(n[i+s]-n[i]);    // linear prediction
+			n[i] += s;
+		}
+	}
+	count++;
+}
+
+double PsiP2Quantile::get ( void ) const
+{
+	if ( count==0 )
+		throw BadIndexError();
+	if ( count<5 ) {
+		std::vector<double> sorted ( q, q+count );
+		std::sort ( sorted.begin(), sorted.end() );
+		return sorted[int(p*(count-1)+.5)];
+	}
+	return q[2];
+}
+
+/************************************************************
+ * PsiRunningStatistics methods
+ */
+
+PsiRunningStatistics::PsiRunningStatistics ( unsigned int nvars, const std::vector<double>& quantileprobs )
+	: nvariables ( nvars ), count ( 0 ), means ( nvars, 0 ), comoments ( nvars*nvars, 0 ), delta ( nvars ), probs ( quantileprobs )
+{
+	unsigned int i, q;
+	quantiles.reserve ( nvars*probs.size() );
+	for ( i=0; i<nvars; i++ )
+		for ( q=0; q<probs.size(); q++ )
+			quantiles.push_back ( PsiP2Quantile ( probs[q] ) );
+}
+
+void PsiRunningStatistics::add ( const std::vector<double>& x )
+{
+	unsigned int i, j;
+	count++;
+	for ( i=0; i<nvariables; i++ ) {
+		delta[i] = x[i]-means[i];
+		means[i] += delta[i]/count;
+	}
+	for ( i=0; i<nvariables; i++ )
+		for ( j=0; j<nvariables; j++ )
+			comoments[i*nvariables+j] += delta[i]*(x[j]-means[j]);
+	for ( i=0; i<nvariables; i++ )
+		for ( j=0; j<probs.size(); j++ )
+			quantiles[i*probs.size()+j].add ( x[i] );
+}
+
+double PsiRunningStatistics::getMean ( unsigned int i ) const
+{
+	if ( i>=nvariables )
+		throw BadIndexError();
+	return means[i];
+}
+
+double PsiRunningStatistics::getCov ( unsigned int i, unsigned int j ) const
+{
+	if ( i>=nvariables || j>=nvariables )
+		throw BadIndexError();
+	if ( count<2 )
+		return 0;
+	return comoments[i*nvariables+j]/(count-1);
+}
+
+double PsiRunningStatistics::getQuantile ( unsigned int i, unsigned int q ) const
+{
+	if ( i>=nvariables || q>=probs.size() )
+		throw BadIndexError();
+	return quantiles[i*probs.size()+q].get();
+}
+
+/************************************************************
+ * PsiMCSummary methods
+ */
+
+std::vector<double> PsiMCSummary::defaultquantiles ( void )
+{
+	std::vector<double> out ( 3 );
+	out[0] = 0.025; out[1] = 0.5; out[2] = 0.975;
+	return out;
+}
+
+PsiMCSummary::PsiMCSummary ( unsigned int nprm, const std::vector<double>& Cuts )
+	: cuts ( Cuts ),
+	estimates ( nprm, defaultquantiles() ),
+	deviance ( 1, defaultquantiles() ),
+	thresholds ( Cuts.size(), defaultquantiles() ),
+	slopes ( Cuts.size(), defaultquantiles() ),
+	dev ( 1 )
+{}
+
+PsiMCSummary::PsiMCSummary ( unsigned int nprm, const std::vector<double>& Cuts, const std::vector<double>& quantileprobs )
+	: cuts ( Cuts ),
+	estimates ( nprm, quantileprobs ),
+	deviance ( 1, quantileprobs ),
+	thresholds ( Cuts.size(), quantileprobs ),
+	slopes ( Cuts.size(), quantileprobs ),
+	dev ( 1 )
+{}
+
+void PsiMCSummary::add ( const std::vector<double>& est, double D, const std::vector<double>& thres, const std::vector<double>& slope )
+{
+	dev[0] = D;
+	estimates.add ( est );
+	deviance.add ( dev );
+	thresholds.add ( thres );
+	slopes.add ( slope );
 }
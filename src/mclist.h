@@ -14,30 +14,73 @@
 #include "data.h"
 #include "rng.h"
 
+/** \brief order statistics of a column of samples
+ *
+ * A sorted copy of the column is built when the first order statistic is requested and reused until the column
+ * changes. The samples themselves are never reordered.
+ */
+class PsiOrderStatistics
+{
+	private:
+		std::vector<double> sorted;
+		bool valid;
+	public:
+		PsiOrderStatistics ( void ) : valid ( false ) {}   ///< set up an empty index
+		void invalidate ( void ) { valid = false; }           ///< mark the index as outdated (call this whenever the column changes)
+		double get (
+			const double * column,                        ///< samples in the column
+			unsigned int n,                               ///< number of samples in the column
+			unsigned int position                         ///< rank of the requested sample (0 is the smallest)
+			) {
+				if ( !valid ) {
+					sorted.assign ( column, column+n );
+					std::sort ( sorted.begin(), sorted.end() );
+					valid = true;
+				}
+				return sorted[position];
+			}   ///< sample with the given rank in the column
+};
+
 /** \brief basic monte carlo samples list
  *
  * This list stores monte carlo samples and deviances, nothing else.
+ *
+ * All samples are stored in a single block of memory that is allocated when the list is set up. The samples of one
+ * parameter are contiguous (column-major storage), getColumn gives direct access to them without copying.
+ * Percentiles are taken from cached order statistics, repeated queries do not sort again.
  */
 class PsiMClist
 {
 	private:
-		std::vector< std::vector<double> > mcestimates;
+		unsigned int nsamples;
+		unsigned int nparams;
+		std::vector<double> mcestimates;          // nparams columns of nsamples values each
 		std::vector<double> deviances;
+		std::vector<PsiOrderStatistics> estimateorder;
+		PsiOrderStatistics devianceorder;
 	public:
 		PsiMClist (
 			int N,                      ///< number of samples to be drawn
 			int nprm                    ///< number of parameters in the model that is analyzed
-			) : mcestimates(nprm, std::vector<double>(N) ), deviances(N) {}   ///< Initialize the list to take N samples of nprm parameters
-		PsiMClist ( const PsiMClist& mclist ) : mcestimates ( mclist.mcestimates ), deviances ( mclist.deviances ) {}   ///< copy a list of mcsamples
-		~PsiMClist ( ) {} ///< destructor
+			) : nsamples(N), nparams(nprm), mcestimates(N*nprm), deviances(N), estimateorder(nprm) {}   ///< Initialize the list to take N samples of nprm parameters
+		PsiMClist ( const PsiMClist& mclist ) : nsamples ( mclist.nsamples ), nparams ( mclist.nparams ), mcestimates ( mclist.mcestimates ), deviances ( mclist.deviances ), estimateorder ( mclist.nparams ) {}   ///< copy a list of mcsamples
+		virtual ~PsiMClist ( ) {} ///< destructor
 		std::vector<double> getEst ( unsigned int i ) const;       ///< get a single parameter estimate at sample i
+		void copyEst (
+			unsigned int i,                                        ///< sample index
+			std::vector<double> * est                              ///< output: parameter vector at sample i (must have getNparams() elements)
+			) const;                                                           ///< get a single parameter estimate at sample i without allocating a new vector
 		double getEst (
 			unsigned int i,                                        ///< sample index
 			unsigned int prm                                       ///< parameter index
 			) const;                                                           ///< get a single sample of a single parameter
+		const double * getColumn (
+			unsigned int prm                                       ///< parameter index
+			) const;                                                           ///< all getNsamples() samples of parameter prm (contiguous, valid as long as the list exists)
+		const double * getDeviances ( void ) const { return nsamples>0 ? &(deviances[0]) : NULL; }   ///< all getNsamples() deviances (contiguous)
 		void setEst (
 			unsigned int i,                                        ///< index of the sample to be set
-			const std::vector<double> est,                ///< parameter vector to be set at index
+			const std::vector<double>& est,               ///< parameter vector to be set at index
 			double deviance                               ///< deviance associated with the sample
 			);                                                                 ///< set a sample of parameters
 		virtual void setdeviance ( unsigned int i, double deviance );                   ///< set the deviance separately for sample i
@@ -52,8 +95,8 @@ class PsiMClist
 			unsigned int prm                             ///< index of the parameter of interest
 			) const ;                                                          ///< get the standard deviantion of parameter prm
 		double getdeviance ( unsigned int i ) const;                                    ///< get the deviance of sample i
-		unsigned int getNsamples ( void ) const { return mcestimates[0].size(); }       ///< get the total number of samples
-		unsigned int getNparams ( void ) const { return mcestimates.size(); }           ///< get the number of parameters
+		unsigned int getNsamples ( void ) const { return nsamples; }                    ///< get the total number of samples
+		unsigned int getNparams ( void ) const { return nparams; }                      ///< get the number of parameters
 		double getDeviancePercentile ( double p );                             ///< get the p-percentile of the deviance (p in the range (0,1) )
 };
 
@@ -65,6 +108,9 @@ class PsiMClist
  * -# The thresholds that are associated with each parameter vector
  * -# the bootstrap samples themselves and not only the resulting parameter estimates
  * -# correlations of the psychometric function with the bootstrap samples "sequence"
+ *
+ * Simulated data sets are stored row by row (one row per sample), thresholds and slopes column by column
+ * (one column per cut) in single blocks of memory.
  */
 class BootstrapList : public PsiMClist
 {
@@ -74,17 +120,22 @@ class BootstrapList : public PsiMClist
 		std::vector<double> bias_t;
 		std::vector<double> acceleration_s;
 		std::vector<double> bias_s;
-		std::vector< std::vector<int> > data;
+		unsigned int nblocks;
+		std::vector<int> data;                      // N rows of nblocks responses
 		std::vector<double> cuts;
-		std::vector< std::vector<double> > thresholds;
-		std::vector< std::vector<double> > slopes;
+		std::vector<double> thresholds;             // one column of N thresholds per cut
+		std::vector<double> slopes;                 // one column of N slopes per cut
 		std::vector<double> Rpd;
 		std::vector<double> Rkd;
+		std::vector<PsiOrderStatistics> thresholdorder;
+		std::vector<PsiOrderStatistics> slopeorder;
+		PsiOrderStatistics Rpdorder;
+		PsiOrderStatistics Rkdorder;
 	public:
 		BootstrapList (
 			unsigned int N,                                              ///< number of samples to be drawn
 			unsigned int nprm,                                           ///< number of parameters in the model
-			unsigned int nblocks,                                        ///< number of blocks in the experiment
+			unsigned int Nblocks,                                        ///< number of blocks in the experiment
 			std::vector<double> Cuts                                     ///< performance levels at which thresholds should be determined
 			) : PsiMClist (N,nprm),
 				BCa(false),
@@ -92,12 +143,15 @@ class BootstrapList : public PsiMClist
 				bias_t(Cuts.size()),
 				acceleration_s(Cuts.size()),
 				bias_s(Cuts.size()),
-				data(N,std::vector<int>(nblocks)),
+				nblocks(Nblocks),
+				data(N*Nblocks),
 				cuts(Cuts),
-				thresholds (Cuts.size(), std::vector<double> (N)),
-				slopes     (Cuts.size(), std::vector<double> (N)),
+				thresholds (Cuts.size()*N),
+				slopes     (Cuts.size()*N),
 				Rpd(N),
-				Rkd(N)
+				Rkd(N),
+				thresholdorder(Cuts.size()),
+				slopeorder(Cuts.size())
 			{ } ///< set up the list
 		// TODO: should setBCa be private and friend of parametric bootstrap?
 		void setBCa_t (
@@ -115,6 +169,7 @@ class BootstrapList : public PsiMClist
 			const std::vector<int>& newdata                                ///< response counts in the new bootstrap sample (not proportion correct)
 			);   ///< store a simulated data set
 		std::vector<int> getData ( unsigned int i ) const;                 ///< get a simulated data set at posititon i
+		const int * getDataRow ( unsigned int i ) const;                   ///< get the getNblocks() responses of the simulated data set at position i without copying
 
 		double getThres ( double p, unsigned int cut );                    ///< get the p-th percentile associated with the threshold at cut
 		double getThres_byPos ( unsigned int i, unsigned int cut );        ///< get the threshold for the i-th sample
@@ -130,8 +185,11 @@ class BootstrapList : public PsiMClist
 				unsigned int cut      ///< index of the desired cut
 				);  ///< set the value of the slope associated with the threshold at cut
 
-		unsigned int getNblocks ( void ) const { return data[0].size(); }  ///< get the number of blocks in the underlying dataset
+		const double * getThresColumn ( unsigned int cut ) const;          ///< all getNsamples() thresholds at cut in sample order (contiguous)
+		const double * getSlopeColumn ( unsigned int cut ) const;          ///< all getNsamples() slopes at cut in sample order (contiguous)
+		unsigned int getNblocks ( void ) const { return nblocks; }         ///< get the number of blocks in the underlying dataset
 		double getCut ( unsigned int i ) const;                            ///< get the value of cut i
+		unsigned int getNcuts ( void ) const { return cuts.size(); }       ///< get the number of cuts
 		double getAcc_t ( unsigned int i ) const { return acceleration_t[i]; } ///< get the acceleration constant for cut i
 		double getBias_t ( unsigned int i ) const { return bias_t[i]; }       ///< get the bias for cut i
 		double getAcc_s ( unsigned int i ) const { return acceleration_s[i]; } ///< get the acceleration constant for cut i
@@ -195,32 +253,39 @@ class JackKnifeList : public PsiMClist
  *    can be considered samples from the posterior predictive distribution
  * 2. For each sample from the posterior predictive distribution, the deviance is stored
  * 3. the list allows to obtain the estimated bayesian p-value
+ *
+ * Posterior predictive data and log posterior ratios are stored row by row (one row of nblocks values per sample)
+ * in single blocks of memory.
  */
 class MCMCList : public PsiMClist
 {
 	private:
 		std::vector<double> posterior_Rpd;
 		std::vector<double> posterior_Rkd;
-		std::vector< std::vector<int> > posterior_predictive_data;
+		unsigned int nblocks;
+		std::vector<int> posterior_predictive_data;         // N rows of nblocks responses
 		std::vector<double> posterior_predictive_deviances;
 		std::vector<double> posterior_predictive_Rpd;
 		std::vector<double> posterior_predictive_Rkd;
-		std::vector< std::vector<double> > logratios;       // log ratios of the unnormalized posteriors for the full model and the models with one block omitted
+		std::vector<double> logratios;                      // log ratios of the unnormalized posteriors for the full model and the models with one block omitted (N rows of nblocks values)
 		double accept_rate;
 		double H;
+		double ess;
 	public:
 		MCMCList (
 			unsigned int N,                                                ///< number of samples to be drawn
 			unsigned int nprm,                                             ///< number of parameters in the model
-			unsigned int nblocks                                           ///< number of blocks in the experiment
+			unsigned int Nblocks                                           ///< number of blocks in the experiment
 			) : PsiMClist ( N, nprm),
 				posterior_Rpd(N),
 				posterior_Rkd(N),
-				posterior_predictive_data(N,std::vector<int>(nblocks)),
+				nblocks(Nblocks),
+				posterior_predictive_data(N*Nblocks),
 				posterior_predictive_deviances ( N ),
 				posterior_predictive_Rpd ( N ),
 				posterior_predictive_Rkd ( N ),
-				logratios ( N, std::vector<double>(nblocks ) ) {};      ///< set up MCMCList
+				logratios ( N*Nblocks ),
+				ess ( 0 ) {};      ///< set up MCMCList
 		void setppData (
 			unsigned int i,                                                ///< index of the posterior predictive sample to be set
 			const std::vector<int>& ppdata,                                ///< posterior predictive data sample
@@ -228,6 +293,7 @@ class MCMCList : public PsiMClist
 			);               ///< store a posterior predictive data set
 		std::vector<int> getppData ( unsigned int i ) const;               ///< get a posterior predictive data sample
 		int getppData ( unsigned int i, unsigned int j ) const;
+		const int * getppDataRow ( unsigned int i ) const;                 ///< get the getNblocks() responses of posterior predictive sample i without copying
 		double getppDeviance ( unsigned int i ) const;                     ///< get deviance associated with a posterior predictive sample
 		void setppRpd ( unsigned int i, double Rpd );
 		double getppRpd ( unsigned int i ) const;
@@ -237,15 +303,123 @@ class MCMCList : public PsiMClist
 		double getRpd ( unsigned int i ) const;
 		void setRkd ( unsigned int i, double Rkd );
 		double getRkd ( unsigned int i ) const;
-		unsigned int getNblocks ( void ) const { return posterior_predictive_data[0].size(); }  ///< get the number of blocks
+		unsigned int getNblocks ( void ) const { return nblocks; }         ///< get the number of blocks
 		void setlogratio ( unsigned int i, unsigned int j, double logratio );              ///< set the log posterior ratio for sample i and block j
 		double getlogratio ( unsigned int i, unsigned int j ) const;                       ///< get the log posterior ratio for sample i and block j
+		const double * getlogratioRow ( unsigned int i ) const;                            ///< get the getNblocks() log posterior ratios of sample i without copying
 		void set_accept_rate(double rate) {accept_rate = rate; }  ///< set the acceptance rate
 		double get_accept_rate(void) const {return accept_rate; } ///< get the acceptance rate
 		void set_entropy ( double entropy ) { H = entropy; } ///< set the entropy if needed
 		double get_entropy ( void ) const { return H; }
+		void set_ess ( double neff ) { ess = neff; } ///< set the effective sample size of the importance weights (sampling importance resampling)
+		double get_ess ( void ) const { return ess; } ///< get the effective sample size of the importance weights
+};
+
+/** \brief streaming estimate of a single quantile
+ *
+ * The P^2 algorithm tracks a quantile with five markers that are adjusted as samples arrive. Memory is constant,
+ * independent of the number of samples. Until five samples have arrived, the quantile of the stored samples is returned.
+ *
+ * Jain, R & Chlamtac, I (1985): The P^2 algorithm for dynamic calculation of quantiles and histograms without storing
+ * observations. Communications of the ACM, 28(10), 1076-1085.
+ */
+class PsiP2Quantile
+{
+	private:
+		double p;
+		unsigned int count;
+		double q[5];           // marker heights
+		double n[5];           // marker positions
+		double np[5];          // desired marker positions
+		double dn[5];          // increments of the desired marker positions
+	public:
+		PsiP2Quantile (
+			double prob                                   ///< probability of the quantile to be tracked (in the range (0,1))
+			);  ///< set up the estimator
+		void add ( double x );                              ///< add a sample
+		double get ( void ) const;                          ///< current estimate of the quantile
+		double getProbability ( void ) const { return p; } ///< probability of the tracked quantile
+		unsigned int getN ( void ) const { return count; } ///< number of samples so far
+};
+
+/** \brief streaming summary statistics of a set of variables
+ *
+ * Means, variances and covariances are updated with Welford's algorithm in a single pass, quantiles are tracked
+ * by P^2 estimators. No samples are stored.
+ */
+class PsiRunningStatistics
+{
+	private:
+		unsigned int nvariables;
+		unsigned int count;
+		std::vector<double> means;
+		std::vector<double> comoments;      // nvariables x nvariables sums of products of deviations
+		std::vector<double> delta;
+		std::vector<double> probs;
+		std::vector<PsiP2Quantile> quantiles;   // nvariables x probs.size()
+	public:
+		PsiRunningStatistics (
+			unsigned int nvars,                           ///< number of variables
+			const std::vector<double>& quantileprobs      ///< probabilities of the quantiles that should be tracked for every variable
+			); ///< set up the accumulator
+		void add ( const std::vector<double>& x );          ///< add a sample of all variables
+		unsigned int getN ( void ) const { return count; }  ///< number of samples so far
+		unsigned int getNvariables ( void ) const { return nvariables; } ///< number of variables
+		double getMean ( unsigned int i ) const;            ///< mean of variable i
+		double getVar ( unsigned int i ) const { return getCov ( i, i ); }   ///< variance of variable i
+		double getStd ( unsigned int i ) const { return sqrt ( getVar ( i ) ); }  ///< standard deviation of variable i
+		double getCov ( unsigned int i, unsigned int j ) const;   ///< covariance of variables i and j
+		double getQuantile (
+			unsigned int i,                               ///< index of the variable
+			unsigned int q                                ///< index of the quantile in the probabilities given on construction
+			) const; ///< quantile estimate
+};
+
+/** \brief streaming summary of posterior samples
+ *
+ * Keeps running statistics of the parameters, the deviance and the thresholds and slopes at a set of cuts. It can be
+ * filled by PsiSampler::summarize instead of storing the samples in an MCMCList, so that very long chains run with
+ * bounded memory. Quantiles default to 2.5%, 50% and 97.5%, which gives medians and 95% credible intervals.
+ */
+class PsiMCSummary
+{
+	private:
+		std::vector<double> cuts;
+		PsiRunningStatistics estimates;
+		PsiRunningStatistics deviance;
+		PsiRunningStatistics thresholds;
+		PsiRunningStatistics slopes;
+		std::vector<double> dev;
+		static std::vector<double> defaultquantiles ( void );
+	public:
+		PsiMCSummary (
+			unsigned int nprm,                            ///< number of parameters in the model
+			const std::vector<double>& Cuts               ///< performance levels at which thresholds and slopes should be summarized
+			); ///< set up a summary with the default quantiles
+		PsiMCSummary (
+			unsigned int nprm,                            ///< number of parameters in the model
+			const std::vector<double>& Cuts,              ///< performance levels at which thresholds and slopes should be summarized
+			const std::vector<double>& quantileprobs      ///< probabilities of the quantiles that should be tracked
+			); ///< set up a summary
+		void add (
+			const std::vector<double>& est,               ///< parameter sample
+			double dev,                                   ///< deviance of the sample
+			const std::vector<double>& thres,             ///< thresholds at all cuts
+			const std::vector<double>& slope              ///< slopes at all cuts
+			); ///< add a sample
+		const std::vector<double>& getCuts ( void ) const { return cuts; }                      ///< cuts at which thresholds and slopes are summarized
+		unsigned int getN ( void ) const { return estimates.getN(); }                          ///< number of samples so far
+		const PsiRunningStatistics& getEstimates ( void ) const { return estimates; }         ///< statistics of the parameters
+		const PsiRunningStatistics& getDeviance ( void ) const { return deviance; }           ///< statistics of the deviance
+		const PsiRunningStatistics& getThresholds ( void ) const { return thresholds; }       ///< statistics of the thresholds (one variable per cut)
+		const PsiRunningStatistics& getSlopes ( void ) const { return slopes; }               ///< statistics of the slopes (one variable per cut)
 };
 
-void newsample ( const PsiData * data, const std::vector<double>& p, std::vector<int> * sample );
+void newsample (
+		const PsiData * data,                   ///< data set that determines the number of trials per block
+		const std::vector<double>& p,           ///< probability of a correct response in every block
+		std::vector<int> * sample,              ///< resulting numbers of correct responses
+		PsiRandomEngine * engine=NULL           ///< engine to draw from (NULL means the global generator)
+		); ///< draw a new binomial sample
 
 #endif
@@ -3,12 +3,102 @@
  *   the copyright and license terms
  */
 #include "mcmc.h"
+#include "parallel.h"
 
 // #define DEBUG_MCMC
 
 #include <iostream>
 #include <iomanip>
 
+/**********************************************************************
+ *
+ * PsiSampler
+ *
+ */
+
+void PsiSampler::summarize ( unsigned int N, PsiMCSummary * summary )
+{
+	const std::vector<double>& cuts ( summary->getCuts() );
+	std::vector<double> est;
+	std::vector<double> thres ( cuts.size() );
+	std::vector<double> slope ( cuts.size() );
+	unsigned int i, cut;
+
+	for ( i=0; i<N; i++ ) {
+		est = draw ();
+		for ( cut=0; cut<cuts.size(); cut++ ) {
+			thres[cut] = model->getThres ( est, cuts[cut] );
+			slope[cut] = model->getSlope ( est, thres[cut] );
+		}
+		summary->add ( est, getDeviance(), thres, slope );
+	}
+}
+
+MCMCList PsiSampler::sampleToPrecision ( double targetess, double targetmcse, const std::vector<double>& cuts,
+		unsigned int chunksize, unsigned int maxsamples, PsiChainDiagnostics * diagnostics )
+{
+	unsigned int i, j, n, N ( 0 ), nprm ( model->getNparams() ), nthres ( cuts.size() );
+	// every variable is kept as a single chain that grows with every chunk
+	std::vector< std::vector< std::vector<double> > > draws ( nprm+nthres, std::vector< std::vector<double> > ( 1 ) );
+	std::vector<double> deviances, est ( nprm ), mean ( nthres, 0 ), M2 ( nthres, 0 );
+	double accept ( 0 ), x, delta;
+	bool reached ( false ), diag ( getDiagnostics() );
+	bool keepthres ( targetmcse>0 || diagnostics!=NULL );
+
+	if ( chunksize<4 || maxsamples<chunksize )
+		throw BadArgumentError ( "sampleToPrecision: chunks need at least 4 samples and maxsamples has to be at least chunksize" );
+
+	setDiagnostics ( false );
+	while ( !reached && N<maxsamples ) {
+		n = ( maxsamples-N<chunksize ? maxsamples-N : chunksize );
+		MCMCList chunk ( sample ( n ) );
+		for ( i=0; i<n; i++ ) {
+			chunk.copyEst ( i, &est );
+			for ( j=0; j<nprm; j++ )
+				draws[j][0].push_back ( est[j] );
+			// running (Welford) mean and sum of squared deviations of the thresholds
+			for ( j=0; j<nthres && keepthres; j++ ) {
+				x = model->getThres ( est, cuts[j] );
+				draws[nprm+j][0].push_back ( x );
+				delta = x-mean[j];
+				mean[j] += delta/(N+i+1);
+				M2[j] += delta*(x-mean[j]);
+			}
+			deviances.push_back ( chunk.getdeviance ( i ) );
+		}
+		accept += chunk.get_accept_rate()*n;
+		N += n;
+
+		// The effective sample sizes are recomputed from all draws, but only for the targets that are set and
+		// only until the first target that is missed
+		reached = true;
+		for ( j=0; j<nprm && reached && targetess>0; j++ )
+			reached = effectiveSampleSize ( draws[j] )>=targetess;
+		for ( j=0; j<nthres && reached && targetmcse>0; j++ )
+			reached = sqrt ( M2[j]/(N-1)/effectiveSampleSize ( draws[nprm+j] ) )<=targetmcse;
+	}
+	setDiagnostics ( diag );
+
+	MCMCList out ( N, nprm, data->getNblocks() );
+	for ( i=0; i<N; i++ ) {
+		for ( j=0; j<nprm; j++ )
+			est[j] = draws[j][0][i];
+		out.setEst ( i, est, deviances[i] );
+	}
+	out.set_accept_rate ( accept/N );
+
+	if ( diagnostics!=NULL ) {
+		*diagnostics = PsiChainDiagnostics ( 1, diagnostics->getMaxlag() );
+		for ( j=0; j<nprm+nthres; j++ )
+			diagnostics->addVariable ( draws[j][0] );
+	}
+
+	if ( diag )
+		sample_diagnostics ( model, data, &out, 1, engine );
+
+	return out;
+}
+
 /**********************************************************************
  *
  * MetropolisHastings sampling
@@ -31,6 +121,23 @@ MetropolisHastings::MetropolisHastings ( const PsiPsychometric * pmf, const PsiD
     currentdeviance = (pmf->deviance(currenttheta,dat));
 }
 
+MetropolisHastings::MetropolisHastings ( const MetropolisHastings& original )
+	: PsiSampler ( original ),
+	propose ( original.propose->clone() ),
+	currenttheta ( original.currenttheta ),
+	newtheta ( original.newtheta ),
+	stepwidths ( original.stepwidths ),
+	currentdeviance ( original.currentdeviance ),
+	accept ( original.accept ),
+	qold ( original.qold )
+{
+}
+
+void MetropolisHastings::setEngine ( PsiRandomEngine * rngengine ) {
+	PsiSampler::setEngine ( rngengine );
+	propose->setEngine ( rngengine );
+}
+
 std::vector<double> MetropolisHastings::draw ( void ) {
 	double qnew, acc(propose->rngcall());
 	const PsiPsychometric * model (getModel());
@@ -112,7 +219,8 @@ void MetropolisHastings::setTheta ( const std::vector<double>& prm ) {
 		currenttheta = prm;
 	else
 		throw BadArgumentError();
-	qold = getModel()->neglpost( currenttheta, getData() );
+	qold = acceptance_probability ( currenttheta, currenttheta );
+	currentdeviance = getModel()->deviance ( currenttheta, getData() );
 }
 
 void MetropolisHastings::setStepSize ( double size, unsigned int param ) {
@@ -133,29 +241,8 @@ MCMCList MetropolisHastings::sample ( unsigned int N ) {
 	const PsiPsychometric * model ( getModel() );
 	accept = 0;
 	MCMCList out ( N, model->getNparams(), data->getNblocks() );
-	PsiData *localdata = new PsiData ( data->getIntensities(), data->getNtrials(), data->getNcorrect(), data->getNalternatives() );
-	std::vector< PsiData* > reduceddata (data->getNblocks() );
-	std::vector<int> posterior_predictive ( data->getNblocks() );
-	std::vector<double> probs ( data->getNblocks() );
 	std::vector<double> est ( model->getNparams() );
-	unsigned int i,j,k,l;
-
-	std::vector<double> reducedx ( data->getNblocks()-1 );
-	std::vector<int> reducedk ( data->getNblocks()-1 );
-	std::vector<int> reducedn ( data->getNblocks()-1 );
-
-	for ( k=0; k<data->getNblocks(); k++ ) {
-		j = 0;
-		for ( l=0; l<data->getNblocks(); l++ ) {
-			if ( l!=k ) {
-				reducedx[j] = data->getIntensity(l);
-				reducedk[j] = data->getNcorrect(l);
-				reducedn[j] = data->getNtrials(l);
-				j++;
-			}
-		}
-		reduceddata[k] = new PsiData ( reducedx, reducedn, reducedk, data->getNalternatives() );
-	}
+	unsigned int i;
 
 	qold = acceptance_probability ( currenttheta, currenttheta );
 
@@ -164,38 +251,6 @@ MCMCList MetropolisHastings::sample ( unsigned int N ) {
 		est = draw();
 		out.setEst ( i, est, 0. );
 		out.setdeviance ( i, getDeviance() );
-
-		// determine posterior predictives
-		for ( k=0; k<data->getNblocks(); k++ )
-			probs[k] = model->evaluate ( data->getIntensity(k), est );
-		newsample ( localdata, probs, &posterior_predictive);
-		localdata->setNcorrect ( posterior_predictive );
-		out.setppData ( i, posterior_predictive, model->deviance ( est, localdata ) );
-
-		probs = model->getDevianceResiduals ( est, data );
-		out.setRpd ( i, model->getRpd ( probs, est, data ) );
-		out.setRkd ( i, model->getRkd ( probs, data ) );
-
-		probs = model->getDevianceResiduals ( est, localdata );
-		out.setppRpd ( i, model->getRpd ( probs, est, localdata ) );
-		out.setppRkd ( i, model->getRkd ( probs, localdata ) );
-
-		// Store log posterior ratios for reduced data sets
-		for ( k=0; k<data->getNblocks(); k++) {
-			/*
-			j=0;
-			for ( l=0; l<data->getNblocks(); l++ ) {
-				if ( l!=k ) {
-					reducedx[j] = data->getIntensity(l);
-					reducedk[j] = data->getNcorrect(l);
-					reducedn[j] = data->getNtrials(l);
-					j++;
-				}
-			}
-			reduceddata = new PsiData ( reducedx, reducedn, reducedk, data->getNalternatives() );
-			*/
-			out.setlogratio ( i, k, model->neglpost(est,data)-model->neglpost(est,reduceddata[k]) );
-		}
 #ifdef DEBUG_MCMC
 		std::cerr << " accept: " << std::setiosflags ( std::ios::fixed ) << double(accept)/(i+1) << "\n";
 #endif
@@ -206,10 +261,9 @@ MCMCList MetropolisHastings::sample ( unsigned int N ) {
 #endif
 	out.set_accept_rate(double(accept)/N);
 
-	delete localdata;
-	for ( k=0; k<reduceddata.size(); k++ ) {
-		delete reduceddata[k];
-	}
+	// posterior predictives and goodness of fit
+	if ( getDiagnostics() )
+		sample_diagnostics ( model, data, &out, 1, getEngine() );
 
 	return out;
 }
@@ -272,6 +326,117 @@ void GenericMetropolis::findOptimalStepwidth( PsiMClist const &pilot ){
 	delete [] paramindex;
 }
 
+/**********************************************************************
+ *
+ * AdaptiveMetropolis
+ *
+ */
+AdaptiveMetropolis::AdaptiveMetropolis ( const PsiPsychometric * Model, const PsiData * Data, PsiRandom * proposal, unsigned int nadaptationsteps, double targetacceptance )
+	: MetropolisHastings ( Model, Data, proposal ),
+	nadapt ( nadaptationsteps ),
+	nadapted ( 0 ),
+	targetrate ( targetacceptance ),
+	logscale ( 0 ),
+	mean ( Model->getNparams(), 0 ),
+	M2 ( Model->getNparams()*Model->getNparams(), 0 ),
+	z ( Model->getNparams() )
+{
+	if ( targetrate<=0 || targetrate>=1 )
+		throw BadArgumentError ( "AdaptiveMetropolis: target acceptance rate has to be between 0 and 1" );
+}
+
+std::vector<double> AdaptiveMetropolis::draw ( void ) {
+	std::vector<double> previous ( getTheta() );
+	std::vector<double> theta ( MetropolisHastings::draw() );
+
+	if ( nadapted<nadapt )
+		updateCovariance ( theta, theta!=previous );   // a rejected proposal leaves the state unchanged
+
+	return theta;
+}
+
+void AdaptiveMetropolis::updateCovariance ( const std::vector<double>& theta, bool accepted ) {
+	unsigned int i, j, nprm ( mean.size() ), n;
+	std::vector<double> delta ( nprm );
+	bool positive ( true );
+
+	// Welford's online update of mean and cross products
+	n = ++nadapted;
+	for ( i=0; i<nprm; i++ ) {
+		delta[i] = theta[i]-mean[i];
+		mean[i] += delta[i]/n;
+	}
+	for ( i=0; i<nprm; i++ )
+		for ( j=0; j<=i; j++ )
+			M2[j*nprm+i] = M2[i*nprm+j] += delta[i]*(theta[j]-mean[j]);
+
+	// Robbins-Monro step towards the target acceptance rate with decaying gain
+	logscale += pow ( double(n), -0.6 ) * ( (accepted ? 1. : 0.) - targetrate );
+
+	// Proposal covariance, once a few states per parameter have been visited
+	if ( n<10*nprm )
+		return;
+	Matrix C ( nprm, nprm );
+	for ( i=0; i<nprm; i++ ) {
+		for ( j=0; j<nprm; j++ )
+			C(i,j) = M2[i*nprm+j]/(n-1) * 2.38*2.38/nprm;
+		C(i,i) += 1e-10;     // keep the covariance positive definite if a parameter did not move
+	}
+	Matrix * L = C.cholesky_dec ();
+	for ( i=0; i<nprm; i++ )
+		positive = positive && (*L)(i,i)>0;
+	if ( positive ) {
+		if ( factor.empty() )
+			logscale = 0;    // the scale was learned for the stepwidths
+		factor.assign ( nprm*nprm, 0 );
+		for ( i=0; i<nprm; i++ )
+			for ( j=0; j<=i; j++ )
+				factor[i*nprm+j] = (*L)(i,j);
+	}
+	delete L;
+}
+
+void AdaptiveMetropolis::proposePoint ( std::vector<double> &current_theta,
+		std::vector<double> &step_widths,
+		PsiRandom * proposal,
+		std::vector<double> &new_theta )
+{
+	unsigned int i, j, nprm ( current_theta.size() );
+	double scale ( exp ( logscale ) );
+
+	if ( factor.empty() ) {
+		for ( i=0; i<nprm; i++ )
+			new_theta[i] = current_theta[i] + scale * step_widths[i] * proposal->draw ( );
+		return;
+	}
+
+	// correlated gaussian step: scale * L * z
+	for ( i=0; i<nprm; i++ )
+		z[i] = proposal->draw ( );
+	for ( i=0; i<nprm; i++ ) {
+		new_theta[i] = current_theta[i];
+		for ( j=0; j<=i; j++ )
+			new_theta[i] += scale * factor[i*nprm+j] * z[j];
+	}
+}
+
+void AdaptiveMetropolis::adapt ( void ) {
+	while ( nadapted<nadapt )
+		draw ();
+}
+
+MCMCList AdaptiveMetropolis::sample ( unsigned int N ) {
+	adapt ();
+	return MetropolisHastings::sample ( N );
+}
+
+double AdaptiveMetropolis::getCovariance ( unsigned int i, unsigned int j ) const {
+	unsigned int nprm ( mean.size() );
+	if ( i>=nprm || j>=nprm )
+		throw BadIndexError ();
+	return ( nadapted<2 ? 0 : M2[i*nprm+j]/(nadapted-1) );
+}
+
 /**********************************************************************
  *
  * DefaultMCMC
@@ -286,6 +451,26 @@ DefaultMCMC::DefaultMCMC ( const PsiPsychometric* Model, const PsiData* Data, Ps
 #endif
 }
 
+DefaultMCMC::DefaultMCMC ( const DefaultMCMC& original ) :
+	MetropolisHastings ( original ),
+	proposaldistributions ( original.proposaldistributions.size(), NULL )
+{
+	unsigned int i;
+	for (i=0; i<proposaldistributions.size(); i++) {
+		if ( original.proposaldistributions[i]!=NULL )
+			proposaldistributions[i] = original.proposaldistributions[i]->clone();
+	}
+}
+
+void DefaultMCMC::setEngine ( PsiRandomEngine * rngengine ) {
+	unsigned int i;
+	MetropolisHastings::setEngine ( rngengine );
+	for (i=0; i<proposaldistributions.size(); i++) {
+		if ( proposaldistributions[i]!=NULL )
+			proposaldistributions[i]->setEngine ( rngengine );
+	}
+}
+
 DefaultMCMC::~DefaultMCMC ( void ) {
 	unsigned int i;
 	for (i=0; i<proposaldistributions.size(); i++) {
@@ -366,6 +551,29 @@ HybridMCMC::HybridMCMC ( const PsiPsychometric* Model, const PsiData* Data, int
 	stepsizes[2] = 0.0001;
 }
 
+HybridMCMC::HybridMCMC ( const HybridMCMC& original )
+	: PsiSampler ( original ),
+	proposal ( original.proposal->clone() ),
+	currenttheta ( original.currenttheta ),
+	newtheta ( original.newtheta ),
+	momentum ( original.momentum ),
+	currentH ( original.currentH ),
+	newH ( original.newH ),
+	energy ( original.energy ),
+	newenergy ( original.newenergy ),
+	gradient ( original.gradient ),
+	currentgradient ( original.currentgradient ),
+	stepsizes ( original.stepsizes ),
+	Nleapfrog ( original.Nleapfrog ),
+	Naccepted ( original.Naccepted )
+{
+}
+
+void HybridMCMC::setEngine ( PsiRandomEngine * rngengine ) {
+	PsiSampler::setEngine ( rngengine );
+	proposal->setEngine ( rngengine );
+}
+
 std::vector<double> HybridMCMC::draw ( void ) {
 	unsigned int i;
 	const PsiPsychometric * model ( getModel() );
@@ -410,12 +618,10 @@ std::vector<double> HybridMCMC::draw ( void ) {
 }
 
 void HybridMCMC::setTheta ( const std::vector<double>& theta ) {
-	unsigned int i;
 	currenttheta = theta;
 
-	for (i=0; i<getModel()->getNparams(); i++) {
-		gradient[i] = getModel()->dlposteri ( currenttheta, getData(), i );
-	}
+	gradient = getModel()->dlposterior ( currenttheta, getData() );
+	currentgradient = gradient;
 	energy = getModel()->neglpost ( currenttheta, getData() );
 }
 
@@ -448,8 +654,7 @@ void HybridMCMC::leapfrog ( void ) {
 		for (i=0; i<Nparams; i++)
 			newtheta[i] +=          stepsizes[i] * momentum[i];
 
-		for (i=0; i<Nparams; i++)
-			gradient[i] = model->dlposteri ( newtheta, getData(), i );
+		gradient = model->dlposterior ( newtheta, getData() );
 
 		for (i=0; i<Nparams; i++)
 			momentum[i] -= 0.5 * stepsizes[i] * gradient[i];
@@ -480,9 +685,954 @@ MCMCList HybridMCMC::sample ( unsigned int N ) {
 	std::cerr << "Acceptance rate: " << double(Naccepted)/N << "\n";
 #endif
 
+	if ( getDiagnostics() )
+		sample_diagnostics ( getModel(), getData(), &out, 1, getEngine() );
+
 	return out;
 }
 
+/**********************************************************************
+ *
+ * NoUTurnSampler
+ *
+ */
+
+/** \brief a (sub)trajectory of the No-U-Turn sampler
+ *
+ * The leftmost and the rightmost state of the trajectory and the state proposed from it. All positions are on the
+ * unconstrained scale.
+ */
+struct NoUTurnSampler::Tree {
+	std::vector<double> qminus, pminus, gradminus;
+	std::vector<double> qplus, pplus, gradplus;
+	std::vector<double> qprop, gradprop, thetaprop;
+	double energyprop;
+	double n;              // number of states in the slice
+	bool s;                // false if the trajectory turned back or diverged
+	double alpha;          // sum of the acceptance probabilities of the states
+	unsigned int nalpha;   // number of states
+};
+
+#define NUTS_MAXDELTAH 1000.
+#define NUTS_GAMMA .05
+#define NUTS_T0 10.
+#define NUTS_KAPPA .75
+
+NoUTurnSampler::NoUTurnSampler ( const PsiPsychometric * Model, const PsiData * Data, unsigned int nadaptationsteps, double targetacceptance, unsigned int maximumdepth )
+	: PsiSampler ( Model, Data ),
+	lower ( Model->getNparams() ),
+	upper ( Model->getNparams() ),
+	invmass ( Model->getNparams(), 1 ),
+	stepsize ( 0 ),
+	maxdepth ( maximumdepth ),
+	nadapt ( nadaptationsteps ),
+	nadapted ( 0 ),
+	targetrate ( targetacceptance ),
+	mu ( 0 ),
+	Hbar ( 0 ),
+	logstepsizebar ( 0 ),
+	ndual ( 0 ),
+	nwindow ( 0 ),
+	mean ( Model->getNparams(), 0 ),
+	M2 ( Model->getNparams(), 0 ),
+	acceptstat ( 0 ),
+	ngradients ( 0 ),
+	ndivergent ( 0 )
+{
+	unsigned int i;
+
+	if ( targetrate<=0 || targetrate>=1 )
+		throw BadArgumentError ( "NoUTurnSampler: target acceptance rate has to be between 0 and 1" );
+	if ( maxdepth==0 )
+		throw BadArgumentError ( "NoUTurnSampler: maximum depth has to be at least 1" );
+
+	for ( i=0; i<lower.size(); i++ )
+		Model->getSupport ( i, &(lower[i]), &(upper[i]) );
+
+	proposal = new GaussRandom;
+
+	setTheta ( Model->getStart ( Data ) );
+}
+
+NoUTurnSampler::NoUTurnSampler ( const NoUTurnSampler& original )
+	: PsiSampler ( original ),
+	proposal ( original.proposal->clone() ),
+	lower ( original.lower ),
+	upper ( original.upper ),
+	currenttheta ( original.currenttheta ),
+	currentposition ( original.currentposition ),
+	currentgradient ( original.currentgradient ),
+	energy ( original.energy ),
+	invmass ( original.invmass ),
+	stepsize ( original.stepsize ),
+	maxdepth ( original.maxdepth ),
+	nadapt ( original.nadapt ),
+	nadapted ( original.nadapted ),
+	targetrate ( original.targetrate ),
+	mu ( original.mu ),
+	Hbar ( original.Hbar ),
+	logstepsizebar ( original.logstepsizebar ),
+	ndual ( original.ndual ),
+	nwindow ( original.nwindow ),
+	mean ( original.mean ),
+	M2 ( original.M2 ),
+	acceptstat ( original.acceptstat ),
+	ngradients ( original.ngradients ),
+	ndivergent ( original.ndivergent )
+{
+}
+
+void NoUTurnSampler::setEngine ( PsiRandomEngine * rngengine ) {
+	PsiSampler::setEngine ( rngengine );
+	proposal->setEngine ( rngengine );
+}
+
+void NoUTurnSampler::setTheta ( const std::vector<double>& theta ) {
+	unsigned int i;
+	double l, u;
+
+	if ( theta.size()!=lower.size() )
+		throw BadArgumentError ( "NoUTurnSampler: wrong number of parameters" );
+
+	currentposition.resize ( theta.size() );
+	for ( i=0; i<theta.size(); i++ ) {
+		l = lower[i]; u = upper[i];
+		if ( l>-HUGE_VAL && u<HUGE_VAL )
+			currentposition[i] = log ( (theta[i]-l)/(u-theta[i]) );
+		else if ( l>-HUGE_VAL )
+			currentposition[i] = log ( theta[i]-l );
+		else if ( u<HUGE_VAL )
+			currentposition[i] = log ( u-theta[i] );
+		else
+			currentposition[i] = theta[i];
+	}
+	energy = potential ( currentposition, currenttheta, currentgradient );
+}
+
+void NoUTurnSampler::setStepSize ( double size, unsigned int param ) {
+	if ( param>=invmass.size() )
+		throw BadIndexError ();
+	if ( size<=0 )
+		throw BadArgumentError ( "NoUTurnSampler: scales have to be positive" );
+	invmass[param] = size*size;
+	stepsize = 0;
+}
+
+void NoUTurnSampler::setStepSize ( const std::vector<double>& sizes ) {
+	unsigned int i;
+	if ( sizes.size()!=invmass.size() )
+		throw BadArgumentError ();
+	for ( i=0; i<sizes.size(); i++ )
+		setStepSize ( sizes[i], i );
+}
+
+double NoUTurnSampler::getInverseMass ( unsigned int prm ) const {
+	if ( prm>=invmass.size() )
+		throw BadIndexError ();
+	return invmass[prm];
+}
+
+double NoUTurnSampler::getDeviance ( void ) {
+	return getModel()->deviance ( currenttheta, getData() );
+}
+
+double NoUTurnSampler::potential ( const std::vector<double>& position, std::vector<double>& theta, std::vector<double>& gradient ) {
+	unsigned int i, nprm ( position.size() );
+	double U, l, u, s, e;
+	std::vector<double> dtheta ( nprm, 1 ), dlogjacobian ( nprm, 0 );
+
+	// back to the original scale, keeping track of the jacobian
+	theta.resize ( nprm );
+	U = 0;
+	for ( i=0; i<nprm; i++ ) {
+		l = lower[i]; u = upper[i];
+		if ( l>-HUGE_VAL && u<HUGE_VAL ) {
+			s = 1./(1+exp(-position[i]));
+			theta[i] = l + (u-l)*s;
+			dtheta[i] = (u-l)*s*(1-s);
+			dlogjacobian[i] = 1-2*s;
+			U -= log ( u-l ) - log1p ( exp ( -position[i] ) ) - log1p ( exp ( position[i] ) );
+		} else if ( l>-HUGE_VAL || u<HUGE_VAL ) {
+			e = exp ( position[i] );
+			theta[i] = ( l>-HUGE_VAL ? l+e : u-e );
+			dtheta[i] = ( l>-HUGE_VAL ? e : -e );
+			dlogjacobian[i] = 1;
+			U -= position[i];
+		} else
+			theta[i] = position[i];
+	}
+
+	// posterior and full gradient in one pass over the blocks
+	U += getModel()->neglpost_derivatives ( theta, getData(), &gradient );
+	ngradients++;
+
+	for ( i=0; i<nprm; i++ )
+		gradient[i] = gradient[i]*dtheta[i] - dlogjacobian[i];
+
+	return U;
+}
+
+double NoUTurnSampler::kinetic ( const std::vector<double>& p ) const {
+	unsigned int i;
+	double K ( 0 );
+	for ( i=0; i<p.size(); i++ )
+		K += invmass[i] * p[i] * p[i];
+	return 0.5*K;
+}
+
+double NoUTurnSampler::leapfrog ( std::vector<double>& position, std::vector<double>& p, std::vector<double>& gradient, std::vector<double>& theta, double eps ) {
+	unsigned int i, nprm ( position.size() );
+	double U;
+
+	for ( i=0; i<nprm; i++ ) {
+		p[i] -= 0.5 * eps * gradient[i];
+		position[i] += eps * invmass[i] * p[i];
+	}
+
+	U = potential ( position, theta, gradient );
+
+	for ( i=0; i<nprm; i++ )
+		p[i] -= 0.5 * eps * gradient[i];
+
+	return U;
+}
+
+bool NoUTurnSampler::noturn ( const Tree& tree ) const {
+	unsigned int i;
+	double dminus ( 0 ), dplus ( 0 ), dq;
+	for ( i=0; i<invmass.size(); i++ ) {
+		dq = tree.qplus[i] - tree.qminus[i];
+		dminus += dq * invmass[i] * tree.pminus[i];
+		dplus  += dq * invmass[i] * tree.pplus[i];
+	}
+	return dminus>=0 && dplus>=0;
+}
+
+void NoUTurnSampler::buildtree ( const std::vector<double>& position, const std::vector<double>& p, const std::vector<double>& gradient,
+		double logu, int direction, unsigned int depth, double H0, Tree& out )
+{
+	double H;
+
+	if ( depth==0 ) {
+		// a single leapfrog step
+		out.qprop = position;
+		out.pplus = p;
+		out.gradprop = gradient;
+		out.energyprop = leapfrog ( out.qprop, out.pplus, out.gradprop, out.thetaprop, direction*stepsize );
+		H = out.energyprop + kinetic ( out.pplus );
+		out.qminus = out.qplus = out.qprop;
+		out.pminus = out.pplus;
+		out.gradminus = out.gradplus = out.gradprop;
+		out.n = ( logu<=-H ? 1 : 0 );
+		out.s = ( -H > logu-NUTS_MAXDELTAH );   // false for nonfinite H as well
+		if ( !out.s )
+			ndivergent++;
+		out.alpha = ( H==H ? ( H0-H<0 ? exp ( H0-H ) : 1 ) : 0 );
+		out.nalpha = 1;
+		return;
+	}
+
+	// first half of the subtree
+	buildtree ( position, p, gradient, logu, direction, depth-1, H0, out );
+	if ( !out.s )
+		return;
+
+	// second half, continuing from the end in direction
+	Tree inner;
+	if ( direction<0 ) {
+		buildtree ( out.qminus, out.pminus, out.gradminus, logu, direction, depth-1, H0, inner );
+		out.qminus = inner.qminus;
+		out.pminus = inner.pminus;
+		out.gradminus = inner.gradminus;
+	} else {
+		buildtree ( out.qplus, out.pplus, out.gradplus, logu, direction, depth-1, H0, inner );
+		out.qplus = inner.qplus;
+		out.pplus = inner.pplus;
+		out.gradplus = inner.gradplus;
+	}
+	if ( inner.n>0 && proposal->rngcall() < inner.n/(out.n+inner.n) ) {
+		out.qprop = inner.qprop;
+		out.gradprop = inner.gradprop;
+		out.thetaprop = inner.thetaprop;
+		out.energyprop = inner.energyprop;
+	}
+	out.alpha += inner.alpha;
+	out.nalpha += inner.nalpha;
+	out.n += inner.n;
+	out.s = inner.s && noturn ( out );
+}
+
+std::vector<double> NoUTurnSampler::draw ( void ) {
+	unsigned int i, depth, nprm ( invmass.size() );
+	std::vector<double> p ( nprm );
+	double H0, logu, alpha ( 0 );
+	unsigned int nalpha ( 0 );
+	int direction;
+	Tree tree, sub;
+
+	if ( stepsize<=0 ) {
+		findStepSize ();
+		restartDualAveraging ();
+	}
+
+	for ( i=0; i<nprm; i++ )
+		p[i] = proposal->draw() / sqrt ( invmass[i] );
+	H0 = energy + kinetic ( p );
+	logu = log ( proposal->rngcall() ) - H0;
+
+	tree.qminus = tree.qplus = currentposition;
+	tree.pminus = tree.pplus = p;
+	tree.gradminus = tree.gradplus = currentgradient;
+	tree.n = 1;
+	tree.s = true;
+
+	for ( depth=0; depth<maxdepth && tree.s; depth++ ) {
+		direction = ( proposal->rngcall()<0.5 ? -1 : 1 );
+		if ( direction<0 ) {
+			buildtree ( tree.qminus, tree.pminus, tree.gradminus, logu, direction, depth, H0, sub );
+			tree.qminus = sub.qminus;
+			tree.pminus = sub.pminus;
+			tree.gradminus = sub.gradminus;
+		} else {
+			buildtree ( tree.qplus, tree.pplus, tree.gradplus, logu, direction, depth, H0, sub );
+			tree.qplus = sub.qplus;
+			tree.pplus = sub.pplus;
+			tree.gradplus = sub.gradplus;
+		}
+		if ( sub.s && sub.n>0 && proposal->rngcall() < sub.n/tree.n ) {
+			currentposition = sub.qprop;
+			currentgradient = sub.gradprop;
+			currenttheta = sub.thetaprop;
+			energy = sub.energyprop;
+		}
+		alpha += sub.alpha;
+		nalpha += sub.nalpha;
+		tree.n += sub.n;
+		tree.s = sub.s && noturn ( tree );
+	}
+
+	acceptstat = alpha/nalpha;
+	if ( nadapted<nadapt )
+		updateAdaptation ( acceptstat );
+
+	return currenttheta;
+}
+
+void NoUTurnSampler::findStepSize ( void ) {
+	unsigned int i, k, nprm ( invmass.size() );
+	std::vector<double> position, p ( nprm ), q, gradient, theta;
+	double H0, dH, eps ( stepsize>0 ? stepsize : 1. );
+	int a ( 0 );
+
+	for ( i=0; i<nprm; i++ )
+		p[i] = proposal->draw() / sqrt ( invmass[i] );
+	H0 = energy + kinetic ( p );
+
+	// double or halve the stepsize until the acceptance probability of a single step crosses 1/2 (Hoffman & Gelman, 2014)
+	for ( k=0; k<100; k++ ) {
+		position = currentposition;
+		gradient = currentgradient;
+		q = p;
+		dH = H0 - leapfrog ( position, q, gradient, theta, eps ) - kinetic ( q );
+		if ( dH!=dH )
+			dH = -HUGE_VAL;
+		if ( a==0 )
+			a = ( dH>log(0.5) ? 1 : -1 );
+		if ( a*dH <= a*log(0.5) )
+			break;
+		eps *= ( a>0 ? 2. : 0.5 );
+	}
+
+	stepsize = eps;
+}
+
+void NoUTurnSampler::restartDualAveraging ( void ) {
+	mu = log ( 10*stepsize );
+	Hbar = 0;
+	logstepsizebar = 0;
+	ndual = 0;
+}
+
+void NoUTurnSampler::updateAdaptation ( double acceptrate ) {
+	unsigned int i, nprm ( invmass.size() ), windowstart ( nadapt*15/100 ), windowend ( nadapt*75/100 );
+	double logeps, eta, w, delta;
+
+	nadapted++;
+
+	// dual averaging of the log stepsize (Nesterov, 2009; Hoffman & Gelman, 2014)
+	ndual++;
+	eta = 1./(ndual+NUTS_T0);
+	Hbar = (1-eta)*Hbar + eta*(targetrate-acceptrate);
+	logeps = mu - sqrt(double(ndual))/NUTS_GAMMA * Hbar;
+	w = pow ( double(ndual), -NUTS_KAPPA );
+	logstepsizebar = w*logeps + (1-w)*logstepsizebar;
+	stepsize = exp ( logeps );
+
+	// variance of the states in the window (Welford)
+	if ( nadapted>windowstart && nadapted<=windowend ) {
+		nwindow++;
+		for ( i=0; i<nprm; i++ ) {
+			delta = currentposition[i]-mean[i];
+			mean[i] += delta/nwindow;
+			M2[i] += delta*(currentposition[i]-mean[i]);
+		}
+	}
+	if ( nadapted==windowend && nwindow>1 ) {
+		// shrink towards a small constant as long as there are few states
+		for ( i=0; i<nprm; i++ )
+			invmass[i] = nwindow/(nwindow+5.) * M2[i]/(nwindow-1) + 1e-3 * 5./(nwindow+5.);
+		findStepSize ();
+		restartDualAveraging ();
+	}
+
+	if ( nadapted==nadapt )
+		stepsize = exp ( logstepsizebar );
+}
+
+void NoUTurnSampler::adapt ( void ) {
+	while ( nadapted<nadapt )
+		draw ();
+}
+
+MCMCList NoUTurnSampler::sample ( unsigned int N ) {
+	MCMCList out ( N, getModel()->getNparams(), getData()->getNblocks() );
+	unsigned int i;
+	double accept ( 0 );
+
+	adapt ();
+
+	for ( i=0; i<N; i++ ) {
+		out.setEst ( i, draw(), 0. );
+		out.setdeviance ( i, getDeviance() );
+		accept += acceptstat;
+	}
+	out.set_accept_rate ( N>0 ? accept/N : 0 );
+
+	if ( getDiagnostics() )
+		sample_diagnostics ( getModel(), getData(), &out, 1, getEngine() );
+
+	return out;
+}
+
+/**********************************************************************
+ *
+ * Parallel tempering
+ *
+ */
+
+ParallelTempering::ParallelTempering ( const PsiPsychometric * Model, const PsiData * Data, unsigned int nreplicas,
+		double maxtemperature, unsigned int Swapinterval, unsigned int nadaptationsteps, unsigned int Nthreads )
+	: PsiSampler ( Model, Data ),
+	replicas ( nreplicas ),
+	temperatures ( nreplicas, 1 ),
+	stepwidths ( Model->getNparams(), .1 ),
+	engines ( nreplicas+1 ),
+	swapinterval ( Swapinterval ),
+	nthreads ( Nthreads ),
+	nadapt ( nadaptationsteps ),
+	nsteps ( 0 ),
+	swapsum ( nreplicas>1 ? nreplicas-1 : 0, 0 ),
+	nswaps ( 0 ),
+	naccepted ( 0 )
+{
+	unsigned int k;
+
+	if ( nreplicas<1 )
+		throw BadArgumentError ( "ParallelTempering needs at least one replica" );
+	if ( nreplicas>1 && !(maxtemperature>1) )
+		throw BadArgumentError ( "ParallelTempering: the hottest replica needs a temperature above 1" );
+	if ( swapinterval<1 )
+		throw BadArgumentError ( "ParallelTempering: swapinterval has to be at least 1" );
+
+	// geometric ladder to start with
+	for ( k=0; k<nreplicas; k++ ) {
+		if ( nreplicas>1 )
+			temperatures[k] = pow ( maxtemperature, double(k)/(nreplicas-1) );
+		replicas[k].logscale = 0.5*log ( temperatures[k] );
+	}
+
+	seedStreams ();
+	setTheta ( Model->getStart ( Data ) );
+}
+
+ParallelTempering::ParallelTempering ( const ParallelTempering& original )
+	: PsiSampler ( original ),
+	replicas ( original.replicas ),
+	temperatures ( original.temperatures ),
+	stepwidths ( original.stepwidths ),
+	engines ( original.engines ),
+	swapinterval ( original.swapinterval ),
+	nthreads ( original.nthreads ),
+	nadapt ( original.nadapt ),
+	nsteps ( original.nsteps ),
+	swapsum ( original.swapsum ),
+	nswaps ( original.nswaps ),
+	naccepted ( original.naccepted )
+{
+	unsigned int k;
+	// the copies of the replicas have to draw from the copies of the streams
+	for ( k=0; k<replicas.size(); k++ )
+		replicas[k].normal.setEngine ( &(engines[k]) );
+}
+
+void ParallelTempering::seedStreams ( void ) {
+	unsigned int k;
+	PsiRandom rng;
+	rng.setEngine ( getEngine() );
+	PsiRandomEngine streams ( (unsigned long) ( rng.rngcall() * 4294967296. ) );
+
+	for ( k=0; k<engines.size(); k++ )
+		engines[k] = streams.split ();
+	for ( k=0; k<replicas.size(); k++ )
+		replicas[k].normal.setEngine ( &(engines[k]) );
+}
+
+void ParallelTempering::setEngine ( PsiRandomEngine * rngengine ) {
+	PsiSampler::setEngine ( rngengine );
+	seedStreams ();
+}
+
+void ParallelTempering::setTheta ( const std::vector<double>& prm ) {
+	unsigned int k;
+	double energy;
+
+	if ( prm.size()!=stepwidths.size() )
+		throw BadArgumentError ( "ParallelTempering: wrong number of parameters" );
+
+	energy = getModel()->neglpost ( prm, getData() );
+	for ( k=0; k<replicas.size(); k++ ) {
+		replicas[k].theta = prm;
+		replicas[k].energy = energy;
+	}
+}
+
+void ParallelTempering::setStepSize ( double size, unsigned int param ) {
+	if ( param>=stepwidths.size() )
+		throw BadIndexError ();
+	if ( size<=0 )
+		throw BadArgumentError ( "ParallelTempering: stepwidths have to be positive" );
+	stepwidths[param] = size;
+}
+
+void ParallelTempering::setStepSize ( const std::vector<double>& sizes ) {
+	unsigned int i;
+	if ( sizes.size()!=stepwidths.size() )
+		throw BadArgumentError ();
+	for ( i=0; i<sizes.size(); i++ )
+		setStepSize ( sizes[i], i );
+}
+
+double ParallelTempering::getDeviance ( void ) {
+	return getModel()->deviance ( replicas[0].theta, getData() );
+}
+
+double ParallelTempering::getTemperature ( unsigned int k ) const {
+	if ( k>=temperatures.size() )
+		throw BadIndexError ();
+	return temperatures[k];
+}
+
+double ParallelTempering::getScale ( unsigned int k ) const {
+	if ( k>=replicas.size() )
+		throw BadIndexError ();
+	return exp ( replicas[k].logscale );
+}
+
+double ParallelTempering::getSwapRate ( unsigned int k ) const {
+	if ( k>=swapsum.size() )
+		throw BadIndexError ();
+	return ( nswaps>0 ? swapsum[k]/nswaps : 0 );
+}
+
+bool ParallelTempering::step ( unsigned int k, unsigned long t ) {
+	Replica& replica ( replicas[k] );
+	unsigned int i, nprm ( stepwidths.size() );
+	std::vector<double> newtheta ( nprm );
+	double scale ( exp ( replica.logscale ) ), energy;
+	bool accepted;
+
+	for ( i=0; i<nprm; i++ )
+		newtheta[i] = replica.theta[i] + scale*stepwidths[i]*replica.normal.draw();
+	energy = getModel()->neglpost ( newtheta, getData() );
+
+	// a proposal with undefined posterior is never accepted
+	accepted = log ( engines[k].draw() ) < -(energy-replica.energy)/temperatures[k];
+	if ( accepted ) {
+		replica.theta = newtheta;
+		replica.energy = energy;
+	}
+
+	// Robbins-Monro step towards the target acceptance rate with decaying gain
+	if ( t<nadapt )
+		replica.logscale += pow ( double(t+1), -0.6 ) * ( (accepted ? 1. : 0.) - 0.234 );
+
+	return accepted;
+}
+
+void ParallelTempering::exchange ( void ) {
+	unsigned int i, K ( replicas.size() );
+	unsigned long round ( nsteps/swapinterval );
+	std::vector<double> p ( swapsum.size() );
+	double logp, pbar ( 0 ), total ( 0 ), gain;
+
+	if ( K<2 )
+		return;
+
+	// acceptance probabilities of all neighbouring pairs, only every second pair is proposed
+	for ( i=0; i+1<K; i++ ) {
+		logp = (1./temperatures[i]-1./temperatures[i+1]) * (replicas[i].energy-replicas[i+1].energy);
+		p[i] = ( logp>=0 ? 1 : exp ( logp ) );
+		swapsum[i] += p[i];
+		pbar += p[i]/(K-1);
+	}
+	nswaps++;
+
+	for ( i=round%2; i+1<K; i+=2 ) {
+		if ( engines[K].draw() < p[i] ) {
+			std::swap ( replicas[i].theta, replicas[i+1].theta );
+			std::swap ( replicas[i].energy, replicas[i+1].energy );
+		}
+	}
+
+	// Move the intermediate temperatures: pairs that exchange more often than the average are spread apart
+	if ( nsteps<=nadapt && K>2 ) {
+		gain = pow ( double(round), -0.6 );
+		std::vector<double> spacing ( K-1 );
+		for ( i=0; i+1<K; i++ ) {
+			spacing[i] = log ( temperatures[i+1]/temperatures[i] ) * exp ( gain*(p[i]-pbar) );
+			total += spacing[i];
+		}
+		for ( i=0; i+1<K; i++ )
+			spacing[i] *= log ( temperatures[K-1] )/total;
+		for ( i=1; i+1<K; i++ )
+			temperatures[i] = temperatures[i-1]*exp ( spacing[i-1] );
+	}
+}
+
+std::vector<double> ParallelTempering::draw ( void ) {
+	unsigned int k;
+
+	for ( k=0; k<replicas.size(); k++ )
+		if ( step ( k, nsteps ) && k==0 )
+			naccepted++;
+	nsteps++;
+	if ( nsteps%swapinterval==0 )
+		exchange ();
+
+	return replicas[0].theta;
+}
+
+/** \brief steps of all replicas up to the next exchange round
+ *
+ * Every item is one replica. Replicas only interact in the exchanges, which run in the calling thread between two
+ * rounds.
+ */
+class ParallelTemperingRound : public PsiParallelJob
+{
+	private:
+		ParallelTempering * sampler;
+		MCMCList * out;
+		unsigned int first;                     // index in out of the first step of the round
+		unsigned int nsteps;                    // number of steps in the round
+	public:
+		ParallelTemperingRound ( ParallelTempering * S, MCMCList * samples, unsigned int done, unsigned int m )
+			: sampler ( S ), out ( samples ), first ( done ), nsteps ( m ) {}
+		void process ( unsigned int k, unsigned int thread ) {
+			unsigned int s;
+			for ( s=0; s<nsteps; s++ ) {
+				if ( sampler->step ( k, sampler->nsteps+s ) && k==0 )
+					sampler->naccepted++;
+				if ( k==0 && out!=NULL ) {
+					out->setEst ( first+s, sampler->replicas[0].theta, 0. );
+					out->setdeviance ( first+s, sampler->getDeviance() );
+				}
+			}
+		}
+};
+
+void ParallelTempering::run ( unsigned int N, MCMCList * out ) {
+	unsigned int m, done ( 0 );
+
+	while ( done<N ) {
+		m = swapinterval - nsteps%swapinterval;
+		if ( m>N-done )
+			m = N-done;
+
+		ParallelTemperingRound round ( this, out, done, m );
+		run_parallel ( &round, replicas.size(), nthreads );
+
+		nsteps += m;
+		if ( nsteps%swapinterval==0 )
+			exchange ();
+		done += m;
+	}
+}
+
+void ParallelTempering::adapt ( void ) {
+	if ( nsteps<nadapt )
+		run ( nadapt-nsteps, NULL );
+}
+
+MCMCList ParallelTempering::sample ( unsigned int N ) {
+	MCMCList out ( N, getModel()->getNparams(), getData()->getNblocks() );
+
+	adapt ();
+
+	naccepted = 0;
+	nswaps = 0;
+	swapsum.assign ( swapsum.size(), 0 );
+	run ( N, &out );
+	out.set_accept_rate ( N>0 ? double(naccepted)/N : 0 );
+
+	if ( getDiagnostics() )
+		sample_diagnostics ( getModel(), getData(), &out, nthreads, getEngine() );
+
+	return out;
+}
+
+/**********************************************************************
+ *
+ * Sample diagnostics
+ *
+ */
+
+/** \brief diagnostics shared by all threads
+ *
+ * The samples are handed out in blocks of DIAGNOSTICS_BLOCKSIZE, every block has its own random number engine.
+ * Every result is written to the slot of its sample.
+ */
+class DiagnosticsJob : public PsiParallelJob
+{
+	private:
+		const PsiPsychometric * pmf;
+		const PsiData * data;
+		MCMCList * samples;
+		std::vector<PsiRandomEngine>& engines;
+	public:
+		DiagnosticsJob ( const PsiPsychometric * model, const PsiData * d, MCMCList * mcmclist, std::vector<PsiRandomEngine>& e )
+			: pmf ( model ), data ( d ), samples ( mcmclist ), engines ( e ) {}
+		void process ( unsigned int block, unsigned int thread );
+};
+
+#define DIAGNOSTICS_BLOCKSIZE 64
+
+void DiagnosticsJob::process ( unsigned int block, unsigned int thread )
+{
+	unsigned int i, j, nblocks ( data->getNblocks() ), N ( samples->getNsamples() );
+	unsigned int first ( block*DIAGNOSTICS_BLOCKSIZE ), last ( N-first<DIAGNOSTICS_BLOCKSIZE ? N : first+DIAGNOSTICS_BLOCKSIZE );
+	std::vector<double> probs ( nblocks );
+	std::vector<double> est ( pmf->getNparams() );
+	std::vector<int> posterior_predictive ( nblocks );
+	std::vector<double> logratios ( nblocks );
+	PsiData localdata ( data->getIntensities(), data->getNtrials(), data->getNcorrect(), data->getNalternatives() );
+
+	for ( i=first; i<last; i++ ) {
+		samples->copyEst ( i, &est );
+
+		// determine posterior predictives
+		pmf->evaluate_batch ( est, data, &probs );
+		newsample ( &localdata, probs, &posterior_predictive, &(engines[block]) );
+		localdata.setNcorrect ( posterior_predictive );
+		samples->setppData ( i, posterior_predictive, pmf->deviance ( est, &localdata ) );
+
+		probs = pmf->getDevianceResiduals ( est, data );
+		samples->setRpd ( i, pmf->getRpd ( probs, est, data ) );
+		samples->setRkd ( i, pmf->getRkd ( probs, data ) );
+
+		probs = pmf->getDevianceResiduals ( est, &localdata );
+		samples->setppRpd ( i, pmf->getRpd ( probs, est, &localdata ) );
+		samples->setppRkd ( i, pmf->getRkd ( probs, &localdata ) );
+
+		// Store log posterior ratios for reduced data sets
+		pmf->leaveoneout_logratios ( est, data, &logratios );
+		for ( j=0; j<nblocks; j++ )
+			samples->setlogratio ( i, j, logratios[j] );
+	}
+}
+
+void sample_diagnostics (
+		const PsiPsychometric *pmf,
+		const PsiData *data,
+		MCMCList *samples,
+		unsigned int nthreads,
+		PsiRandomEngine * engine
+		)
+{
+	unsigned int i, nblocks ( (samples->getNsamples()+DIAGNOSTICS_BLOCKSIZE-1)/DIAGNOSTICS_BLOCKSIZE );
+	if ( nblocks==0 )
+		return;
+
+	// Random number streams for the blocks
+	PsiRandom rng;
+	rng.setEngine ( engine );
+	PsiRandomEngine streams ( (unsigned long) ( rng.rngcall() * 4294967296. ) );
+	std::vector<PsiRandomEngine> engines ( nblocks );
+	for ( i=0; i<nblocks; i++ )
+		engines[i] = streams.split ();
+
+	DiagnosticsJob job ( pmf, data, samples, engines );
+	run_parallel ( &job, nblocks, nthreads );
+}
+
+/**********************************************************************
+ *
+ * Multiple chains
+ *
+ */
+
+/** \brief sampling of several chains, every item is one chain */
+class MultiChainJob : public PsiParallelJob
+{
+	private:
+		std::vector<PsiSampler*> * samplers;
+		std::vector<MCMCList*> * chains;
+		unsigned int N;
+	public:
+		MultiChainJob ( std::vector<PsiSampler*> * s, std::vector<MCMCList*> * c, unsigned int n ) : samplers ( s ), chains ( c ), N ( n ) {}
+		void process ( unsigned int k, unsigned int thread ) {
+			// Every chain has its own sampler and engine, so chains do not share any state
+			(*chains)[k] = new MCMCList ( (*samplers)[k]->sample ( N ) );
+		}
+};
+
+MultiChainMCMC::MultiChainMCMC ( const PsiSampler * sampler, unsigned int nchains, unsigned long seed, bool startfromprior )
+	: samplers ( nchains, NULL ),
+	engines ( nchains ),
+	chains ( nchains, NULL ),
+	Rhat ( sampler->getModel()->getNparams(), 0 ),
+	Neff ( sampler->getModel()->getNparams(), 0 )
+{
+	const PsiPsychometric * model ( sampler->getModel() );
+	std::vector<double> theta;
+	PsiPrior * prior;
+	unsigned int i,k;
+
+	if ( nchains<1 )
+		throw BadArgumentError ( "MultiChainMCMC needs at least one chain" );
+
+	for ( k=0; k<nchains; k++ ) {
+		// engines does not change size after this point, so the samplers can keep pointers to its elements
+		engines[k] = PsiRandomEngine ( seed, k );
+		samplers[k] = sampler->clone();
+		samplers[k]->setEngine ( &(engines[k]) );
+
+		if ( startfromprior ) {
+			theta = samplers[k]->getTheta();
+			for ( i=0; i<model->getNparams(); i++ ) {
+				// Improper priors can not be sampled, these parameters start at the state of the template
+				try {
+					prior = model->getPrior ( i )->clone();
+				} catch ( NotImplementedError& ) {
+					continue;
+				}
+				prior->setEngine ( &(engines[k]) );
+				theta[i] = prior->rand();
+				delete prior;
+			}
+			samplers[k]->setTheta ( theta );
+		}
+	}
+}
+
+MultiChainMCMC::~MultiChainMCMC ( void )
+{
+	unsigned int k;
+	clearchains ();
+	for ( k=0; k<samplers.size(); k++ )
+		delete samplers[k];
+}
+
+void MultiChainMCMC::clearchains ( void )
+{
+	unsigned int k;
+	for ( k=0; k<chains.size(); k++ ) {
+		delete chains[k];
+		chains[k] = NULL;
+	}
+}
+
+MCMCList MultiChainMCMC::sample ( unsigned int N, unsigned int nthreads )
+{
+	unsigned int i,j,k,l,prm, K ( samplers.size() );
+	unsigned int nprm ( samplers[0]->getModel()->getNparams() ), nblocks ( samplers[0]->getData()->getNblocks() );
+	std::vector< std::vector<double> > draws ( K, std::vector<double> ( N ) );
+	double accept ( 0 );
+
+	clearchains ();
+
+	MultiChainJob job ( &samplers, &chains, N );
+	try {
+		run_parallel ( &job, K, nthreads );
+	} catch ( ... ) {
+		clearchains ();
+		throw;
+	}
+
+	// Combine the chains
+	MCMCList out ( N*K, nprm, nblocks );
+	std::vector<double> est ( nprm );
+	std::vector<int> ppdata ( nblocks );
+	for ( k=0; k<K; k++ ) {
+		const MCMCList& chain ( *(chains[k]) );
+		for ( i=0; i<N; i++ ) {
+			l = k*N+i;
+			chain.copyEst ( i, &est );
+			out.setEst ( l, est, chain.getdeviance ( i ) );
+			std::copy ( chain.getppDataRow ( i ), chain.getppDataRow ( i )+nblocks, ppdata.begin() );
+			out.setppData ( l, ppdata, chain.getppDeviance ( i ) );
+			out.setRpd ( l, chain.getRpd ( i ) );
+			out.setRkd ( l, chain.getRkd ( i ) );
+			out.setppRpd ( l, chain.getppRpd ( i ) );
+			out.setppRkd ( l, chain.getppRkd ( i ) );
+			for ( j=0; j<nblocks; j++ )
+				out.setlogratio ( l, j, chain.getlogratio ( i, j ) );
+		}
+		accept += chain.get_accept_rate();
+	}
+	out.set_accept_rate ( accept/K );
+
+	// Convergence diagnostics
+	for ( prm=0; prm<nprm; prm++ ) {
+		for ( k=0; k<K; k++ )
+			for ( i=0; i<N; i++ )
+				draws[k][i] = chains[k]->getEst ( i, prm );
+		Rhat[prm] = ( N<4 ? -1 : splitRhat ( draws ) );
+		Neff[prm] = ( N<4 ? -1 : effectiveSampleSize ( draws ) );
+	}
+
+	return out;
+}
+
+const MCMCList& MultiChainMCMC::getChain ( unsigned int i ) const
+{
+	if ( i>=chains.size() )
+		throw BadIndexError();
+	if ( chains[i]==NULL )
+		throw BadArgumentError ( "no samples have been drawn yet" );
+	return *(chains[i]);
+}
+
+PsiSampler * MultiChainMCMC::getSampler ( unsigned int i )
+{
+	if ( i>=samplers.size() )
+		throw BadIndexError();
+	return samplers[i];
+}
+
+double MultiChainMCMC::getRhat ( unsigned int prm ) const
+{
+	if ( prm>=Rhat.size() )
+		throw BadIndexError();
+	return Rhat[prm];
+}
+
+double MultiChainMCMC::getNeff ( unsigned int prm ) const
+{
+	if ( prm>=Neff.size() )
+		throw BadIndexError();
+	return Neff[prm];
+}
+
 /**********************************************************************
  *
  * Evidence
@@ -10,21 +10,42 @@
 #include "rng.h"
 #include "mclist.h"
 #include "getstart.h"
+#include "convergence.h"
 
 class PsiSampler
 {
 	private:
 		const PsiPsychometric * model;
 		const PsiData * data;
+		PsiRandomEngine * engine;
+		bool diagnostics;
 	public:
-		PsiSampler ( const PsiPsychometric * Model, const PsiData * Data ) : model(Model), data(Data) {}///< set up a sampler to sample from the posterior of the parameters of pmf given the data dat
+		PsiSampler ( const PsiPsychometric * Model, const PsiData * Data ) : model(Model), data(Data), engine(NULL), diagnostics(true) {}///< set up a sampler to sample from the posterior of the parameters of pmf given the data dat
+		virtual ~PsiSampler ( void ) {}
+		virtual PsiSampler * clone ( void ) const { throw NotImplementedError(); }                     ///< clone the sampler including its current state (the engine is shared with the clone)
+		virtual void setEngine ( PsiRandomEngine * rngengine ) { engine = rngengine; }                 ///< draw random numbers from rngengine instead of the global generator (the engine is borrowed)
+		PsiRandomEngine * getEngine ( void ) const { return engine; }                                  ///< engine used by the sampler (NULL means global generator)
+		void setDiagnostics ( bool compute ) { diagnostics = compute; }                                ///< should sample() compute sample diagnostics (see sample_diagnostics()) after sampling?
+		bool getDiagnostics ( void ) const { return diagnostics; }                                     ///< does sample() compute sample diagnostics?
 		virtual std::vector<double> draw ( void ) { throw NotImplementedError(); }                     ///< draw a sample from the posterior
-		virtual void setTheta ( const std::vector<double> theta ) { throw NotImplementedError(); }     ///< set the "state" of the underlying markov chain
+		virtual void setTheta ( const std::vector<double>& theta ) { throw NotImplementedError(); }    ///< set the "state" of the underlying markov chain
 		virtual std::vector<double> getTheta ( void ) { throw NotImplementedError(); }                 ///< get the "state" of the underlying markov chain
 		virtual void setStepSize ( double size, unsigned int param ) { throw NotImplementedError(); }  ///< set the size of the steps for parameter param of the sampler
 		virtual void setStepSize ( const std::vector<double>& sizes ) { throw NotImplementedError(); } ///< set all stepsizes of the sampler
 		virtual double getDeviance ( void ) { throw NotImplementedError(); }                           ///< return the model deviance for the current state
 		virtual MCMCList sample ( unsigned int N ) { throw NotImplementedError(); }                   ///< draw N samples from the posterior
+		void summarize (
+			unsigned int N,                                                              ///< number of samples to be drawn
+			PsiMCSummary * summary                                                       ///< summary to which the samples are added
+			);   ///< draw N samples from the posterior and only accumulate their summary statistics (memory does not grow with N)
+		MCMCList sampleToPrecision (
+			double targetess,                                                            ///< smallest effective sample size of every parameter (0 for no target)
+			double targetmcse,                                                           ///< largest monte carlo standard error of every threshold (0 for no target)
+			const std::vector<double>& cuts,                                             ///< cuts of the thresholds that are checked against targetmcse
+			unsigned int chunksize=1000,                                                 ///< number of samples drawn between two checks of the targets
+			unsigned int maxsamples=20000,                                               ///< largest number of samples that is drawn if the targets are not met
+			PsiChainDiagnostics * diagnostics=NULL                                       ///< output: convergence diagnostics of the parameters and thresholds of the returned samples (ignored if NULL)
+			);   ///< draw samples in chunks until the targets are met (or maxsamples are drawn) and return all of them
 		const PsiPsychometric * getModel() const { return model; }                                     ///< return the underlying model instance
 		const PsiData         * getData()  const { return data;  }                                     ///< return the underlying data instance
 };
@@ -46,7 +67,10 @@ class MetropolisHastings : public PsiSampler
 			const PsiData * Data,                                                           ///< data to base inference on
 			PsiRandom* proposal                                                             ///< proposal distribution (will usually be a gaussian)
 			);                                                          ///< initialize the sampler
+		MetropolisHastings ( const MetropolisHastings& original );                          ///< copy constructor (copies the proposal distribution and the state of the chain)
 		~MetropolisHastings ( void ) { delete propose; }
+		PsiSampler * clone ( void ) const { return new MetropolisHastings ( *this ); }   ///< clone the sampler
+		void setEngine ( PsiRandomEngine * rngengine );                                  ///< draw proposals and posterior predictive data from rngengine
 		std::vector<double> draw ( void );                                                ///< perform a metropolis hastings step and draw a sample from the posterior
 		virtual double acceptance_probability ( const std::vector<double>& current_theta, const std::vector<double>& new_theta );
 		void setTheta ( const std::vector<double>& prm );                                 ///< set the current state of the sampler
@@ -74,6 +98,7 @@ class GenericMetropolis : public MetropolisHastings
 			PsiRandom* proposal                                               			  ///< proposal distribution (will usually be a gaussian)
 			): MetropolisHastings ( Model, Data, proposal ),
 			   currentindex(0) {}
+		PsiSampler * clone ( void ) const { return new GenericMetropolis ( *this ); }    ///< clone the sampler
 		void proposePoint( std::vector<double> &current_theta,
 							std::vector<double> &step_widths,
 							PsiRandom * proposal,
@@ -88,6 +113,53 @@ class GenericMetropolis : public MetropolisHastings
 		void findOptimalStepwidth ( PsiMClist const &pilot );
 };
 
+/** \brief adaptive metropolis sampler with a learned proposal covariance
+ *
+ * The first nadapt steps of the chain are an adaptation phase (Haario et al, 2001; Andrieu & Thoms, 2008). During
+ * this phase, the covariance of the visited states is accumulated online and proposals are drawn from a gaussian with
+ * this covariance (scaled by 2.38^2/nparams). Before enough states have been visited, the diagonal stepwidths of
+ * MetropolisHastings are used. In addition, a global log scale factor is adapted with a decaying gain, such that the
+ * acceptance rate approaches targetrate. After the adaptation phase, the proposal is frozen, so that the production
+ * samples come from a proper markov chain. sample() runs the remaining adaptation steps first and discards them.
+ *
+ * Strongly correlated parameters (like a and b of the ab core) are proposed along their correlation, which requires
+ * neither a pilot sample nor hand tuned stepwidths.
+ *
+ * proposal should draw standard normal random numbers.
+ */
+class AdaptiveMetropolis : public MetropolisHastings
+{
+	private:
+		unsigned int nadapt;           // number of adaptation steps
+		unsigned int nadapted;         // adaptation steps done so far
+		double targetrate;
+		double logscale;               // log of the global scale factor of the proposal
+		std::vector<double> mean;      // running mean of the visited states
+		std::vector<double> M2;        // running sums of cross products of deviations from the mean (nprm x nprm)
+		std::vector<double> factor;    // lower triangular cholesky factor of the proposal covariance (nprm x nprm), empty while stepwidths are used
+		std::vector<double> z;         // standard normal draws for a proposal
+		void updateCovariance ( const std::vector<double>& theta, bool accepted );
+	public:
+		AdaptiveMetropolis (
+			const PsiPsychometric * Model,                                                  ///< psychometric function model to sample from
+			const PsiData * Data,                                                           ///< data to base inference on
+			PsiRandom* proposal,                                                            ///< standard normal random numbers for the proposals
+			unsigned int nadaptationsteps=1000,                                             ///< length of the adaptation phase
+			double targetacceptance=0.234                                                   ///< acceptance rate aimed at during adaptation
+			);
+		PsiSampler * clone ( void ) const { return new AdaptiveMetropolis ( *this ); }   ///< clone the sampler (including the state of the adaptation)
+		std::vector<double> draw ( void );                                                ///< perform a metropolis step (and an adaptation step during the adaptation phase)
+		void proposePoint ( std::vector<double> &current_theta,
+				std::vector<double> &step_widths,
+				PsiRandom * proposal,
+				std::vector<double> &new_theta);                                          ///< propose a new point from the (learned) proposal distribution
+		void adapt ( void );                                                              ///< run the remaining steps of the adaptation phase
+		MCMCList sample ( unsigned int N );                                               ///< finish the adaptation phase and draw N samples with the frozen proposal
+		bool adapting ( void ) const { return nadapted<nadapt; }                        ///< is the sampler still in the adaptation phase?
+		double getScale ( void ) const { return exp ( logscale ); }                       ///< global scale factor of the proposal
+		double getCovariance ( unsigned int i, unsigned int j ) const;                    ///< covariance of parameters i and j estimated during adaptation
+};
+
 class DefaultMCMC : public MetropolisHastings
 {
 	private:
@@ -97,7 +169,10 @@ class DefaultMCMC : public MetropolisHastings
 				const PsiData * Data,                                                     ///< data to base inference on
 				PsiRandom* proposal                                                       ///< IGNORED
 				);
+		DefaultMCMC ( const DefaultMCMC& original );                                      ///< copy constructor (copies the proposal distributions)
 		~DefaultMCMC ( void );
+		PsiSampler * clone ( void ) const { return new DefaultMCMC ( *this ); }          ///< clone the sampler
+		void setEngine ( PsiRandomEngine * rngengine );                                  ///< draw proposals from rngengine
 		double acceptance_probability (
 				const std::vector<double> &current_theta,
 				const std::vector<double> &new_theta );
@@ -108,6 +183,7 @@ class DefaultMCMC : public MetropolisHastings
         void set_proposal(unsigned int i, PsiPrior* proposal){
             delete proposaldistributions.at(i);
             proposaldistributions.at(i) = proposal->clone();
+            proposaldistributions.at(i)->setEngine ( getEngine() );
         }
 };
 
@@ -134,7 +210,10 @@ class HybridMCMC : public PsiSampler
 			const PsiData * Data,                                                          ///< data to base inference on
 			int Nleap                                                                     ///< number of leapfrog steps to be performed for each sample
 			);                                                             ///< initialize the sampler
+		HybridMCMC ( const HybridMCMC& original );                                        ///< copy constructor (copies the momentum distribution and the state of the chain)
 		~HybridMCMC ( void ) { delete proposal; }
+		PsiSampler * clone ( void ) const { return new HybridMCMC ( *this ); }           ///< clone the sampler
+		void setEngine ( PsiRandomEngine * rngengine );                                  ///< draw momenta from rngengine
 		std::vector<double> draw ( void );                                                ///< draw a sample from the posterior
 		void setTheta ( const std::vector<double>& prm );                                 ///< set the current state of the sampler
 		std::vector<double> getTheta ( void ) { return currenttheta; }                    ///< get the current state of the sampler
@@ -144,6 +223,224 @@ class HybridMCMC : public PsiSampler
 		MCMCList sample ( unsigned int N );                                              ///< draw N samples from the posterior
 };
 
+/** \brief No-U-Turn sampler with adaptive stepsize and mass matrix
+ *
+ * Hamiltonian monte carlo without a fixed number of leapfrog steps (Hoffman & Gelman, 2014). Every draw doubles a
+ * trajectory in random directions until it starts to turn back on itself (or until it reaches 2^maxdepth leapfrog
+ * steps) and selects the new state from the states along the trajectory. Every leapfrog step evaluates the posterior
+ * and its full gradient in a single pass over the blocks (PsiPsychometric::neglpost_derivatives()).
+ *
+ * Hamiltonian dynamics can not cross the edges of a prior (like the bounds of a uniform prior on the lapse rate).
+ * Therefore, parameters with a bounded prior (PsiPsychometric::getSupport()) are sampled on an unconstrained scale:
+ * the logarithm of the distance to a single bound or the logit of the relative position between two bounds. The
+ * posterior on this scale includes the jacobian of the transformation. Samples are returned on the original scale.
+ *
+ * The first nadapt draws are an adaptation phase. During the whole phase, the stepsize is adapted by dual averaging,
+ * such that the mean acceptance statistic of the trajectories approaches targetacceptance. The states visited between
+ * 15% and 75% of the phase are used to estimate the variance of every (unconstrained) parameter. This variance becomes
+ * the diagonal inverse mass matrix, after which the stepsize is searched again. After the adaptation phase, stepsize
+ * and mass matrix are frozen. sample() runs the remaining adaptation steps first and discards them.
+ *
+ * Trajectories that run into regions of vanishing posterior are stopped and counted as divergent.
+ */
+class NoUTurnSampler : public PsiSampler
+{
+	private:
+		struct Tree;
+		PsiRandom* proposal;
+		std::vector<double> lower;              // lower bounds of the parameters
+		std::vector<double> upper;              // upper bounds of the parameters
+		std::vector<double> currenttheta;
+		std::vector<double> currentposition;    // currenttheta on the unconstrained scale
+		std::vector<double> currentgradient;    // gradient of the potential at currentposition
+		double energy;                          // potential (negative log posterior on the unconstrained scale) at currentposition
+		std::vector<double> invmass;            // diagonal of the inverse mass matrix
+		double stepsize;
+		unsigned int maxdepth;
+		unsigned int nadapt;                    // number of adaptation steps
+		unsigned int nadapted;                  // adaptation steps done so far
+		double targetrate;
+		double mu;                              // dual averaging: log stepsize the iterates are shrunk towards
+		double Hbar;                            // dual averaging: running mean of targetrate minus acceptance statistic
+		double logstepsizebar;                  // dual averaging: averaged log stepsize
+		unsigned int ndual;                     // dual averaging: iterations since the last restart
+		unsigned int nwindow;                   // number of states in the variance window
+		std::vector<double> mean;               // running mean of the states in the variance window
+		std::vector<double> M2;                 // running sum of squared deviations of the states in the variance window
+		double acceptstat;                      // mean acceptance probability of the states of the last trajectory
+		unsigned long ngradients;
+		unsigned long ndivergent;
+		double potential ( const std::vector<double>& position, std::vector<double>& theta, std::vector<double>& gradient );
+		double leapfrog ( std::vector<double>& position, std::vector<double>& p, std::vector<double>& gradient, std::vector<double>& theta, double eps );
+		double kinetic ( const std::vector<double>& p ) const;
+		bool noturn ( const Tree& tree ) const;
+		void buildtree ( const std::vector<double>& position, const std::vector<double>& p, const std::vector<double>& gradient,
+				double logu, int direction, unsigned int depth, double H0, Tree& out );
+		void findStepSize ( void );
+		void restartDualAveraging ( void );
+		void updateAdaptation ( double acceptstat );
+		NoUTurnSampler& operator= ( const NoUTurnSampler& );                             // not implemented, the sampler owns proposal
+	public:
+		NoUTurnSampler (
+			const PsiPsychometric * Model,                                                  ///< psychometric function model to sample from
+			const PsiData * Data,                                                           ///< data to base inference on
+			unsigned int nadaptationsteps=1000,                                             ///< length of the adaptation phase
+			double targetacceptance=0.8,                                                    ///< mean acceptance statistic aimed at during adaptation
+			unsigned int maximumdepth=10                                                    ///< maximum number of trajectory doublings per draw
+			);                                                             ///< initialize the sampler at the starting value of the model
+		NoUTurnSampler ( const NoUTurnSampler& original );                                ///< copy constructor (copies the state of the chain and of the adaptation)
+		~NoUTurnSampler ( void ) { delete proposal; }
+		PsiSampler * clone ( void ) const { return new NoUTurnSampler ( *this ); }       ///< clone the sampler
+		void setEngine ( PsiRandomEngine * rngengine );                                  ///< draw momenta and selections from rngengine
+		std::vector<double> draw ( void );                                                ///< draw a sample from the posterior (and perform an adaptation step during the adaptation phase)
+		void setTheta ( const std::vector<double>& prm );                                 ///< set the current state of the sampler (has to be inside the support of the priors)
+		std::vector<double> getTheta ( void ) { return currenttheta; }                    ///< get the current state of the sampler
+		void setStepSize ( double size, unsigned int param );                             ///< set the scale of parameter param on the unconstrained scale (the inverse mass becomes size^2 and the leapfrog stepsize is searched again)
+		void setStepSize ( const std::vector<double>& sizes );                            ///< set the scales of all parameters at once
+		double getDeviance ( void );                                                      ///< get the current deviance
+		void adapt ( void );                                                              ///< run the remaining steps of the adaptation phase
+		MCMCList sample ( unsigned int N );                                              ///< finish the adaptation phase and draw N samples with frozen stepsize and mass matrix
+		bool adapting ( void ) const { return nadapted<nadapt; }                        ///< is the sampler still in the adaptation phase?
+		double getLeapfrogStepSize ( void ) const { return stepsize; }                  ///< stepsize of the leapfrog integration
+		double getInverseMass ( unsigned int prm ) const;                                ///< diagonal element prm of the inverse mass matrix
+		unsigned long getNgradients ( void ) const { return ngradients; }               ///< number of posterior and gradient evaluations so far
+		unsigned long getNdivergent ( void ) const { return ndivergent; }               ///< number of divergent trajectories so far
+};
+
+/** \brief replica exchange (parallel tempering) sampler for multimodal posteriors
+ *
+ * K replicas run random walk metropolis chains on the tempered posteriors exp(-neglpost/T_k) with temperatures
+ * 1=T_0<T_1<...<T_{K-1}=maxtemperature. The hot replicas move freely between the modes of the posterior. Every
+ * swapinterval steps, neighbouring replicas propose to exchange their states (even and odd pairs in turn), so that
+ * states travel down the temperature ladder and the cold replica visits all modes. Only the cold replica is returned.
+ *
+ * During the first nadapt steps, the proposal scale of every replica is adapted towards an acceptance rate of 0.234
+ * and the temperatures between T_0 and T_{K-1} are moved such that all neighbouring pairs exchange equally often
+ * (similar to Vousden, Farr & Mandel, 2016). After the adaptation phase, scales and temperatures are frozen. sample()
+ * runs the remaining adaptation steps first and discards them.
+ *
+ * The replicas are distributed over nthreads threads that synchronize for every exchange. Every replica draws its
+ * random numbers from its own stream, split off from the engine of the sampler (or from a seed drawn from the global
+ * generator), and the exchanges draw from a separate stream. Thus, the samples do not depend on the number of threads.
+ */
+class ParallelTempering : public PsiSampler
+{
+	private:
+		struct Replica {
+			std::vector<double> theta;
+			double energy;                      // neglpost at theta
+			double logscale;                    // log of the scale factor of the proposal at this temperature
+			GaussRandom normal;
+		};
+		std::vector<Replica> replicas;          // replicas[k] runs at temperature temperatures[k], exchanges swap theta and energy
+		std::vector<double> temperatures;
+		std::vector<double> stepwidths;         // standard deviations of the proposals at temperature 1 before scaling
+		std::vector<PsiRandomEngine> engines;   // one random number stream per replica, the last one decides about exchanges
+		unsigned int swapinterval;
+		unsigned int nthreads;
+		unsigned int nadapt;                    // number of adaptation steps
+		unsigned long nsteps;                   // steps of every replica so far
+		std::vector<double> swapsum;            // summed exchange acceptance probabilities of the neighbouring pairs
+		unsigned long nswaps;                   // number of exchange rounds in swapsum
+		unsigned long naccepted;                // accepted steps of the cold replica in the current call to sample()
+		void seedStreams ( void );
+		bool step ( unsigned int k, unsigned long t );
+		void exchange ( void );
+		void run ( unsigned int N, MCMCList * out );
+		ParallelTempering& operator= ( const ParallelTempering& );                       // not implemented, the replicas point to their own engines
+		friend class ParallelTemperingRound;
+	public:
+		ParallelTempering (
+			const PsiPsychometric * Model,                                                  ///< psychometric function model to sample from
+			const PsiData * Data,                                                           ///< data to base inference on
+			unsigned int nreplicas=4,                                                       ///< number of replicas (temperatures)
+			double maxtemperature=10,                                                       ///< temperature of the hottest replica
+			unsigned int swapinterval=10,                                                   ///< number of steps between two exchange rounds
+			unsigned int nadaptationsteps=2000,                                             ///< length of the adaptation phase
+			unsigned int nthreads=1                                                         ///< number of threads that run the replicas
+			);                                                             ///< initialize all replicas at the starting value of the model
+		ParallelTempering ( const ParallelTempering& original );                          ///< copy constructor (copies the states of all replicas and the adaptation)
+		PsiSampler * clone ( void ) const { return new ParallelTempering ( *this ); }    ///< clone the sampler
+		void setEngine ( PsiRandomEngine * rngengine );                                  ///< split the random number streams of the replicas from rngengine
+		std::vector<double> draw ( void );                                                ///< perform one step of every replica (and an exchange round every swapinterval steps) and return the state of the cold replica
+		void setTheta ( const std::vector<double>& prm );                                 ///< set the states of all replicas
+		std::vector<double> getTheta ( void ) { return replicas[0].theta; }              ///< get the state of the cold replica
+		void setStepSize ( double size, unsigned int param );                             ///< set the standard deviation of the proposal for parameter param at temperature 1 (before adaptation of the scale)
+		void setStepSize ( const std::vector<double>& sizes );                            ///< set the standard deviations of the proposals for all parameters
+		double getDeviance ( void );                                                      ///< get the deviance of the cold replica
+		void adapt ( void );                                                              ///< run the remaining steps of the adaptation phase
+		MCMCList sample ( unsigned int N );                                              ///< finish the adaptation phase and draw N samples of the cold replica
+		bool adapting ( void ) const { return nsteps<nadapt; }                          ///< is the sampler still in the adaptation phase?
+		unsigned int getNreplicas ( void ) const { return replicas.size(); }            ///< number of replicas
+		double getTemperature ( unsigned int k ) const;                                  ///< temperature of replica k
+		double getScale ( unsigned int k ) const;                                        ///< scale factor of the proposal of replica k
+		double getSwapRate ( unsigned int k ) const;                                     ///< mean exchange acceptance probability of replicas k and k+1 during the last call to sample()
+};
+
+/** \brief run several independent markov chains in parallel
+ *
+ * Convergence of a markov chain can only be judged reliably from several chains that were started at
+ * different points. MultiChainMCMC clones a sampler K times, starts every clone at a point drawn from the priors
+ * of the model and runs the chains on separate threads. Every chain draws its random numbers from its own
+ * PsiRandomEngine stream. Thus, the chains are independent and the samples only depend on the seed and not on the
+ * number of threads.
+ *
+ * After sampling, the chains are available individually (getChain()) and as one combined MCMCList. Convergence
+ * is summarized by the split-Rhat statistic and the effective sample size of each parameter (Gelman et al, 2013).
+ * These are computed once all chains finished a call to sample(). Calling sample() again continues all chains from
+ * their current states and recomputes them from the new samples, so convergence can be monitored by sampling in
+ * several calls.
+ */
+class MultiChainMCMC
+{
+	private:
+		std::vector<PsiSampler*> samplers;
+		std::vector<PsiRandomEngine> engines;
+		std::vector<MCMCList*> chains;
+		std::vector<double> Rhat;
+		std::vector<double> Neff;
+		void clearchains ( void );
+		MultiChainMCMC ( const MultiChainMCMC& original );                               ///< not copyable (the samplers point into engines)
+		MultiChainMCMC& operator= ( const MultiChainMCMC& original );                    ///< not assignable (the samplers point into engines)
+	public:
+		MultiChainMCMC (
+			const PsiSampler * sampler,                                                   ///< template sampler (stepsizes, proposals, ...). Every chain gets a copy of this sampler.
+			unsigned int nchains,                                                         ///< number of chains
+			unsigned long seed=0,                                                         ///< seed of the random number streams of the chains
+			bool startfromprior=true                                                      ///< draw starting values from the priors? (otherwise all chains start at the state of the template sampler)
+			);                                                             ///< set up the chains
+		~MultiChainMCMC ( void );
+		MCMCList sample (
+			unsigned int N,                                                               ///< number of samples per chain
+			unsigned int nthreads=1                                                       ///< number of threads to run the chains on
+			);                                                             ///< draw N samples from every chain and return all chains combined in a single MCMCList
+		unsigned int getNchains ( void ) const { return samplers.size(); }               ///< number of chains
+		const MCMCList& getChain ( unsigned int i ) const;                               ///< samples of chain i from the last call to sample()
+		PsiSampler * getSampler ( unsigned int i );                                      ///< sampler of chain i
+		double getRhat ( unsigned int prm ) const;                                       ///< split-Rhat of parameter prm (values close to 1 indicate convergence)
+		double getNeff ( unsigned int prm ) const;                                       ///< effective sample size of parameter prm over all chains
+};
+
+/** \brief posterior predictive data and goodness of fit diagnostics for parameter samples
+ *
+ * For every sample, this determines a posterior predictive data set and its deviance, Rpd and Rkd for the data and for
+ * the posterior predictive data, and the log posterior ratios for the data sets with one block omitted. All of this
+ * only depends on the parameters of the sample, so the samples are processed in blocks on nthreads threads. Every
+ * block draws its posterior predictive data from its own random number stream, split off from engine (or from a seed
+ * drawn from the global generator if engine is NULL). Thus, the diagnostics do not depend on the number of threads.
+ *
+ * Samplers compute the diagnostics at the end of sample() unless this is switched off with
+ * PsiSampler::setDiagnostics(false). Users that only need the parameter samples can skip them, or call this function
+ * later with more threads.
+ */
+void sample_diagnostics (
+		const PsiPsychometric *pmf,   ///< psychometric function model
+		const PsiData *data,          ///< dataset
+		MCMCList *samples,            ///< parameter samples
+		unsigned int nthreads=1,      ///< number of threads that process the samples
+		PsiRandomEngine * engine=NULL ///< engine from which the random number streams are split (NULL for the global generator)
+		);
+
 /**
  * Model evidence (or marginal likelihood) is given by the following integral
  *
@@ -19,13 +19,20 @@ const double maxstep (1e-7);
 const double maxfstep(1e-7);
 const int    maxiter (80);
 
-PsiOptimizer::PsiOptimizer ( const PsiPsychometric * model, const PsiData * data)
+const double newtonrate  (1e-8);   // rates are kept in [newtonrate,1-newtonrate] by the Newton method
+const double newtongrad  (1e-6);   // Newton method terminates if the largest free gradient component is below this
+const int    newtoniter  (100);
+const int    newtontrials(30);     // maximum number of damping increases per Newton iteration
+
+PsiOptimizer::PsiOptimizer ( const PsiPsychometric * model, const PsiData * data, PsiOptimizerMethod optmethod )
 	: nparameters ( model->getNparams() ),
 	simplex ( nparameters+1, std::vector<double> (nparameters) ),fx ( nparameters+1 ),
 	x  ( nparameters ),
 	xx ( nparameters ),
 	start ( nparameters ),
-	modified ( nparameters+1, true )
+	modified ( nparameters+1, true ),
+	method ( optmethod ),
+	nevaluations ( 0 )
 {}
 
 PsiOptimizer::~PsiOptimizer ( void ) {}
@@ -89,6 +96,194 @@ void copy_lgst(const std::vector<double>& in, std::vector<double>& out, int npar
 }
 
 
+bool isfinite_ ( double x ) {
+	return x==x && x!=std::numeric_limits<double>::infinity() && x!=-std::numeric_limits<double>::infinity();
+}
+
+/* Is parameter i of model a rate in [0,1]? These are the lapse rate and the
+ * guessing rate of a yes/no task, but not parameters that derived models
+ * append (e.g. nu of a BetaPsychometric).
+ */
+bool israte ( const PsiPsychometric * model, unsigned int i ) {
+	return i==2 || ( i==3 && i<model->PsiPsychometric::getNparams() );
+}
+
+/* Solve (A+mu*I) d = b restricted to the variables marked in free by a
+ * Cholesky decomposition. Returns false if the damped matrix is not positive
+ * definite. Fixed variables get d=0.
+ */
+bool damped_solve ( const Matrix& A, double mu, const std::vector<bool>& free, const std::vector<double>& b, std::vector<double>* d ) {
+	unsigned int n ( b.size() ), i, j, k;
+	std::vector<unsigned int> ind;
+	for ( i=0; i<n; i++ ) {
+		(*d)[i] = 0;
+		if ( free[i] ) ind.push_back ( i );
+	}
+	unsigned int m ( ind.size() );
+	std::vector< std::vector<double> > L ( m, std::vector<double> ( m, 0 ) );
+	std::vector<double> y ( m );
+	double s;
+
+	for ( k=0; k<m; k++ ) {
+		s = A(ind[k],ind[k]) + mu;
+		for ( j=0; j<k; j++ )
+			s -= L[k][j]*L[k][j];
+		if ( !(s>0) ) return false;
+		L[k][k] = sqrt ( s );
+		for ( i=k+1; i<m; i++ ) {
+			s = A(ind[i],ind[k]);
+			for ( j=0; j<k; j++ )
+				s -= L[i][j]*L[k][j];
+			L[i][k] = s/L[k][k];
+		}
+	}
+
+	for ( i=0; i<m; i++ ) {
+		s = b[ind[i]];
+		for ( j=0; j<i; j++ )
+			s -= L[i][j]*y[j];
+		y[i] = s/L[i][i];
+	}
+	for ( i=m; i>0; i-- ) {
+		s = y[i-1];
+		for ( j=i; j<m; j++ )
+			s -= L[j][i-1]*(*d)[ind[j]];
+		(*d)[ind[i-1]] = s/L[i-1][i-1];
+	}
+	return true;
+}
+
+double PsiOptimizer::derivatives ( const PsiPsychometric * model, const PsiData * data, const std::vector<double>& prm, std::vector<double> * gradient, Matrix * hessian )
+{
+	unsigned int i, j;
+	double f, fp, fm, f0, h, g, hh, lower, upper;
+	std::vector<double> y ( prm );
+
+	f = model->negllikeli_derivatives ( prm, data, gradient, hessian );
+	nevaluations++;
+	if ( gradient->size()!=unsigned(nparameters) )
+		throw NotImplementedError ();   // the model gives derivatives for a different parameter vector
+
+	// negllikeli_derivatives returns the second derivative of the log likelihood
+	for ( i=0; i<unsigned(nparameters); i++ )
+		for ( j=0; j<unsigned(nparameters); j++ )
+			(*hessian)(i,j) = -(*hessian)(i,j);
+
+	// The priors contribute only to the diagonal. Their derivatives are determined numerically
+	// to be valid for every prior that implements a density.
+	for ( i=0; i<unsigned(nparameters); i++ ) {
+		h = 1e-5 * ( fabs(prm[i])>1 ? fabs(prm[i]) : 1 );
+		if ( israte ( model, i ) ) {
+			if ( h>0.5*prm[i] ) h = 0.5*prm[i];
+			if ( h>0.5*(1-prm[i]) ) h = 0.5*(1-prm[i]);
+		}
+		model->getSupport ( i, &lower, &upper );     // both points have to be inside the support
+		if ( h>0.5*(prm[i]-lower) ) h = 0.5*(prm[i]-lower);
+		if ( h>0.5*(upper-prm[i]) ) h = 0.5*(upper-prm[i]);
+		f0 = -log ( model->evalPrior ( i, prm[i] ) );
+		fp = -log ( model->evalPrior ( i, prm[i]+h ) );
+		fm = -log ( model->evalPrior ( i, prm[i]-h ) );
+		f += f0;
+		g  = (fp-fm)/(2*h);
+		hh = (fp-2*f0+fm)/(h*h);
+		if ( isfinite_ ( g ) )  (*gradient)[i] += g;
+		if ( isfinite_ ( hh ) ) (*hessian)(i,i) += hh;
+	}
+
+	return f;
+}
+
+bool PsiOptimizer::newton ( const PsiPsychometric * model, const PsiData * data, std::vector<double> * output )
+{
+	unsigned int i;
+	int iter, trial;
+	double f, fnew, gmax, dmax, mu(0), mumin;
+	bool accepted;
+	std::vector<double> prm ( start ), prmnew ( nparameters ), gradient ( nparameters ), step ( nparameters ), b ( nparameters );
+	std::vector<double> lower ( nparameters ), upper ( nparameters );
+	std::vector<bool> free ( nparameters, true );
+	Matrix hessian ( nparameters, nparameters );
+
+	// Trial points are projected on the support of the priors. They stay slightly inside, as the density may vanish
+	// on the boundary. Rates stay away from 0 and 1, where the likelihood is not defined.
+	for ( i=0; i<unsigned(nparameters); i++ ) {
+		model->getSupport ( i, &(lower[i]), &(upper[i]) );
+		if ( isfinite_ ( lower[i] ) ) lower[i] += newtonrate * ( fabs(lower[i])>1 ? fabs(lower[i]) : 1 );
+		if ( isfinite_ ( upper[i] ) ) upper[i] -= newtonrate * ( fabs(upper[i])>1 ? fabs(upper[i]) : 1 );
+		if ( israte ( model, i ) ) {
+			if ( lower[i]<newtonrate ) lower[i] = newtonrate;
+			if ( upper[i]>1-newtonrate ) upper[i] = 1-newtonrate;
+		}
+		if ( prm[i]<lower[i] ) prm[i] = lower[i];
+		if ( prm[i]>upper[i] ) prm[i] = upper[i];
+	}
+
+	try {
+		f = derivatives ( model, data, prm, &gradient, &hessian );
+	} catch ( NotImplementedError& ) {
+		return false;
+	}
+	if ( !isfinite_ ( f ) )
+		return false;
+
+	for ( iter=0; iter<newtoniter; iter++ ) {
+		// parameters at a bound are kept fixed if the gradient points outward
+		gmax = 0;
+		mumin = 0;
+		for ( i=0; i<unsigned(nparameters); i++ ) {
+			if ( 1e-6*fabs(hessian(i,i))>mumin ) mumin = 1e-6*fabs(hessian(i,i));
+			free[i] = true;
+			if ( prm[i]<=lower[i] && gradient[i]>0 ) free[i] = false;
+			if ( prm[i]>=upper[i] && gradient[i]<0 ) free[i] = false;
+			if ( free[i] && fabs(gradient[i])>gmax ) gmax = fabs(gradient[i]);
+			b[i] = -gradient[i];
+		}
+		if ( gmax<newtongrad )
+			break;
+
+		accepted = false;
+		for ( trial=0; trial<newtontrials; trial++ ) {
+			if ( !damped_solve ( hessian, mu, free, b, &step ) ) {
+				mu = ( mu>=mumin ? 10*mu : mumin );
+				continue;
+			}
+			for ( i=0; i<unsigned(nparameters); i++ ) {
+				prmnew[i] = prm[i] + step[i];
+				if ( prmnew[i]<lower[i] ) prmnew[i] = lower[i];
+				if ( prmnew[i]>upper[i] ) prmnew[i] = upper[i];
+			}
+			fnew = model->neglpost ( prmnew, data );
+			nevaluations++;
+			if ( isfinite_ ( fnew ) && fnew<=f ) {
+				accepted = true;
+				mu = ( mu>mumin ? 0.1*mu : 0 );
+				break;
+			}
+			mu = ( mu>=mumin ? 10*mu : mumin );
+		}
+#ifdef DEBUG_OPTIMIZER
+		std::cerr << "newton " << iter << " f=" << f << " gmax=" << gmax << " mu=" << mu << " accepted=" << accepted << " prm=" << prm[0] << " " << prm[1] << " " << prm[2] << "\n";
+#endif
+		if ( !accepted )
+			return false;   // even tiny steps do not descend ~> the derivatives are not reliable, let the simplex take over
+
+		dmax = 0;
+		for ( i=0; i<unsigned(nparameters); i++ )
+			if ( fabs(prmnew[i]-prm[i])>dmax ) dmax = fabs(prmnew[i]-prm[i]);
+		prm = prmnew;
+		// small steps only indicate convergence if they are not small because of the damping
+		if ( mu==0 && f-fnew<maxfstep*1e-3 && dmax<maxstep*1e-2 )
+			break;
+
+		f = derivatives ( model, data, prm, &gradient, &hessian );
+	}
+	if ( iter==newtoniter )
+		return false;
+
+	*output = prm;
+	return true;
+}
+
 std::vector<double> PsiOptimizer::optimize ( const PsiPsychometric * model, const PsiData * data, const std::vector<double>* startingvalue )
 {
 	int k, l;
@@ -109,6 +304,15 @@ std::vector<double> PsiOptimizer::optimize ( const PsiPsychometric * model, cons
 		}
 	}
 
+	nevaluations = 0;
+	std::vector<double> output ( start );
+	if ( method==OPTIMIZER_NEWTON && dynamic_cast<const PMF_with_JeffreysPrior*> ( model )==NULL ) {
+		// The Jeffreys prior depends on the data and has no cheap derivatives ~> use the simplex in that case.
+		// newton also gives up if the model has no derivatives for its full parameter vector
+		if ( newton ( model, data, &output ) )
+			return output;
+	}
+
 	for ( k=0; k<nparameters+1; k++ ) {
 		for ( l=0; l<nparameters; l++)
 			simplex[k][l] = start[l];
@@ -131,7 +335,6 @@ std::vector<double> PsiOptimizer::optimize ( const PsiPsychometric * model, cons
 	int iter(0);        // Number of simplex iterations
 	int run;            // the model should be rerun after convergence
 	double d;
-	std::vector<double> output ( start );
 	std::vector<double> prm ( start );
 
 
@@ -176,6 +379,7 @@ std::vector<double> PsiOptimizer::optimize ( const PsiPsychometric * model, cons
 				if (modified[k]) {
 					copy_lgst(simplex[k], prm, nparameters);
 					fx[k] = model->neglpost(prm, data );
+					nevaluations++;
 					modified[k] = false;
 				}
 				// fx[k] = testfunction(simplex[k]);
@@ -197,6 +401,7 @@ std::vector<double> PsiOptimizer::optimize ( const PsiPsychometric * model, cons
 					}
 					copy_lgst(simplex[k], prm, nparameters);
 					fx[k] = model->neglpost(prm, data );
+					nevaluations++;
 				}
 			}
 
@@ -241,6 +446,7 @@ std::vector<double> PsiOptimizer::optimize ( const PsiPsychometric * model, cons
 			// Now check what to do
 			copy_lgst(xx, prm, nparameters);
 			ffx = model->neglpost(prm,data);
+			nevaluations++;
 			// ffx = testfunction(xx);
 			if (ffx<fx[minind]) {
 				// The reflected point is better than the previous worst point ~> Expand
@@ -280,6 +486,7 @@ std::vector<double> PsiOptimizer::optimize ( const PsiPsychometric * model, cons
 					}
 				}
 				fx[k] = model->neglpost( prm, data );
+				nevaluations++;
 				modified[k] = false;
 			}
 			// fx[k] = testfunction(simplex[k]);
@@ -346,3 +553,79 @@ std::vector<double> PsiOptimizer::optimize ( const PsiPsychometric * model, cons
 
 	return output;
 }
+
+/************************************************************
+ * PsiRefitContext methods
+ */
+
+PsiRefitContext::PsiRefitContext ( const PsiPsychometric * pmf, const PsiData * refdata, const std::vector<double>* reference, PsiOptimizerMethod method )
+	: model ( pmf ), data ( refdata ), opt ( pmf, refdata, method ),
+	start ( 2*pmf->getNparams() ),
+	resampled ( refdata->getIntensities(), refdata->getNtrials(), refdata->getNcorrect(), refdata->getNalternatives() ),
+	reduced ( refdata->getIntensities(), refdata->getNtrials(), refdata->getNcorrect(), refdata->getNalternatives() ),
+	last ( refdata )
+{
+	unsigned int i, nprm ( model->getNparams() );
+	std::vector<double> fit;
+	double h;
+
+	if ( reference==NULL )
+		fit = opt.optimize ( model, data );
+	else if ( reference->size()<nprm )
+		throw BadArgumentError ( "PsiRefitContext: the reference solution needs a value for every parameter" );
+	else
+		fit = std::vector<double> ( reference->begin(), reference->begin()+nprm );
+
+	for ( i=0; i<nprm; i++ )
+		start[i] = fit[i];
+
+	if ( reference!=NULL && reference->size()>=2*nprm ) {
+		for ( i=0; i<nprm; i++ )
+			start[i+nprm] = reference->at(i+nprm);
+		return;
+	}
+
+	// Step sizes from the curvature of the likelihood, models without derivatives use the steps of the starting value search
+	Matrix hessian ( nprm, nprm );
+	try {
+		model->negllikeli_derivatives ( fit, data, NULL, &hessian );
+	} catch ( NotImplementedError& ) {
+		std::vector<double> incr ( nprm );
+		getstart ( model, data, 8, 3, 3, &incr );
+		for ( i=0; i<nprm; i++ )
+			hessian(i,i) = ( incr[i]>0 ? -1./(incr[i]*incr[i]) : 0 );
+	}
+	for ( i=0; i<nprm; i++ ) {
+		h = -hessian(i,i);             // hessian holds the second derivative of the log likelihood
+		if ( h>0 && h==h )
+			start[i+nprm] = 1./sqrt ( h );
+		else
+			start[i+nprm] = 0.1 * ( fabs(fit[i])>1 ? fabs(fit[i]) : 1 );
+		if ( israte ( model, i ) ) {
+			// the simplex needs some extent in the rates even if they are at the boundary
+			if ( start[i+nprm]<0.01 )
+				start[i+nprm] = 0.01;
+			if ( start[i+nprm]>0.5*(1-fit[i]) )
+				start[i+nprm] = 0.5*(1-fit[i]);
+		}
+	}
+}
+
+std::vector<double> PsiRefitContext::refit ( const std::vector<int>& newNcorrect )
+{
+	if ( newNcorrect.size()!=data->getNblocks() )
+		throw BadArgumentError ( "PsiRefitContext::refit: number of blocks does not match the reference data" );
+	resampled.setNcorrect ( newNcorrect );
+	last = &resampled;
+	return opt.optimize ( model, &resampled, &start );
+}
+
+std::vector<double> PsiRefitContext::refit ( unsigned int excludeblock )
+{
+	if ( excludeblock>=data->getNblocks() )
+		throw BadArgumentError ( "PsiRefitContext::refit: excluded block does not exist" );
+
+	reduced.setLeaveOneOut ( *data, excludeblock );
+	last = &reduced;
+	return opt.optimize ( model, &reduced, &start );
+}
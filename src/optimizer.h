@@ -9,7 +9,23 @@
 #include "psychometric.h"
 #include "data.h"
 
-/** \brief Simplex optimization */
+/** \brief optimization methods of PsiOptimizer */
+enum PsiOptimizerMethod {
+	OPTIMIZER_SIMPLEX,    ///< Nelder-Mead simplex on logit transformed rates (derivative free)
+	OPTIMIZER_NEWTON      ///< damped Newton method with box constraints from the rates and the priors (uses analytic derivatives of the likelihood)
+};
+
+/** \brief Simplex optimization
+ *
+ * By default, the posterior is minimized using a simplex algorithm. Alternatively, a damped Newton method can be
+ * selected. This method uses the analytic gradient and Hessian of the likelihood from PsiPsychometric::negllikeli_derivatives
+ * together with numerical derivatives of the priors. The rates (lambda and gamma) are kept in the interval (0,1) and all
+ * parameters in the support of their priors by projecting the steps onto the box, instead of the logit transform used by
+ * the simplex. Parameters at a bound stay fixed while the gradient points outward. Steps are accepted only if they
+ * decrease the posterior; otherwise the damping (the inverse trust region radius) is increased. Typically, the Newton
+ * method needs far fewer posterior evaluations than the simplex. For models with Jeffreys prior and for models that
+ * do not provide derivatives for all of their parameters, the simplex is used.
+ */
 class PsiOptimizer
 {
 	private:
@@ -21,10 +37,15 @@ class PsiOptimizer
 		std::vector<double> xx;                      // another single simplex node
 		std::vector<double> start;                   // starting values
 		std::vector<bool>   modified;                // bookkeeping vector to indicate which simplex nodes have changed, i.e. which function values need to be updated
+		PsiOptimizerMethod method;                   // optimization method
+		unsigned int nevaluations;                   // number of posterior evaluations in the last call to optimize
+		double derivatives ( const PsiPsychometric * model, const PsiData * data, const std::vector<double>& prm, std::vector<double> * gradient, Matrix * hessian );   // negative log posterior with gradient and hessian
+		bool newton ( const PsiPsychometric * model, const PsiData * data, std::vector<double> * output );   // Newton optimization from start, false if it did not converge (the simplex is used then)
 	public:
 		PsiOptimizer (
 			const PsiPsychometric * model,           ///< model to be fitted (this is needed at this point only to determine the amount of internal memory that is required)
-			const PsiData * data                     ///< data to be fitted (this is needed at this point only to determine the amount of internal memory that is required)
+			const PsiData * data,                    ///< data to be fitted (this is needed at this point only to determine the amount of internal memory that is required)
+			PsiOptimizerMethod optmethod=OPTIMIZER_SIMPLEX   ///< optimization method
 			); ///< set up everything
 		~PsiOptimizer ( void );                                   ///< clean up everything
 		std::vector<double> optimize (
@@ -32,6 +53,46 @@ class PsiOptimizer
 			const PsiData * data,                    ///< data to be fitted
 			const std::vector<double>* startingvalue=NULL    ///< starting value for optimization --- if this is longer the the number of parameters in the model, the additional values are used to span the simplex
 			); ///< Start the optimization process
+		PsiOptimizerMethod getMethod ( void ) const { return method; }               ///< optimization method
+		unsigned int getNevaluations ( void ) const { return nevaluations; }         ///< number of evaluations of the posterior (or its derivatives) in the last optimization
+};
+
+/** \brief repeated fits of closely related data sets
+ *
+ * Bootstrap and jackknife fit many data sets that differ only slightly from a reference data set. A refit context fits (or
+ * receives) the reference solution once and keeps the optimizer workspace, the reference solution and the initial step sizes
+ * of the simplex. Every refit starts from the reference solution. If no step sizes are given, they are derived from the
+ * curvature of the likelihood at the reference solution, such that the initial simplex spans roughly one standard error
+ * in every direction. The data sets for the refits are stored in the context and are not reallocated between refits of the
+ * same kind.
+ */
+class PsiRefitContext
+{
+	private:
+		const PsiPsychometric * model;
+		const PsiData * data;
+		PsiOptimizer opt;
+		std::vector<double> start;                   // reference solution followed by initial step sizes
+		PsiData resampled;                           // data with modified numbers of correct responses
+		PsiData reduced;                             // data with one block removed
+		const PsiData * last;                        // data that were fitted last
+	public:
+		PsiRefitContext (
+			const PsiPsychometric * model,           ///< model to be fitted
+			const PsiData * data,                    ///< reference data set
+			const std::vector<double>* reference=NULL,   ///< reference solution (optionally followed by initial step sizes as for PsiOptimizer::optimize), NULL to fit the reference data
+			PsiOptimizerMethod method=OPTIMIZER_SIMPLEX   ///< optimization method
+			); ///< set up the context
+		std::vector<double> getReference ( void ) const { return std::vector<double> ( start.begin(), start.begin()+model->getNparams() ); } ///< reference solution
+		const std::vector<double>& getStart ( void ) const { return start; }  ///< reference solution followed by the initial step sizes
+		std::vector<double> refit (
+			const std::vector<int>& newNcorrect      ///< numbers of correct responses in every block of the reference data set
+			); ///< fit the reference data set with new numbers of correct responses (e.g. a bootstrap sample)
+		std::vector<double> refit (
+			unsigned int excludeblock                ///< index of the block to be left out
+			); ///< fit the reference data set without one block (e.g. for jackknife)
+		const PsiData * getData ( void ) const { return last; }            ///< data set that was fitted in the last refit
+		const PsiOptimizer& getOptimizer ( void ) const { return opt; }    ///< optimizer (e.g. to query the number of evaluations of the last refit)
 };
 
 #endif
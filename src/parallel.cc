@@ -0,0 +1,160 @@
+/*
+ *   See COPYING file distributed along with the psignifit package for
+ *   the copyright and license terms
+ */
+#include "parallel.h"
+#include <pthread.h>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** \brief kinds of errors that are transported from the workers to the calling thread */
+enum PsiParallelError {
+	PARALLEL_NOERROR,
+	PARALLEL_PSIERROR,
+	PARALLEL_NOTIMPLEMENTED,
+	PARALLEL_BADARGUMENT,
+	PARALLEL_BADINDEX,
+	PARALLEL_BADALLOC,
+	PARALLEL_STDEXCEPTION
+};
+
+/** \brief state of a run shared by all threads */
+struct PsiParallelRun {
+	PsiParallelJob * job;
+	unsigned int nitems;
+	unsigned int next;
+	PsiParallelError error;
+	const char * message;        // message of a PsiError (these are not owned by the error)
+	std::string what;            // message of a std::exception (copied, the exception object does not survive the catch)
+	pthread_mutex_t lock;
+};
+
+struct PsiParallelWorker {
+	PsiParallelRun * run;
+	unsigned int thread;
+};
+
+static void capture_error ( PsiParallelRun * run )
+{
+	/* Must be called from a catch block, rethrows the current exception to determine its type */
+	PsiParallelError error;
+	const char * message ( NULL );
+	std::string what;
+	try {
+		throw;
+	} catch ( NotImplementedError& e ) {
+		error = PARALLEL_NOTIMPLEMENTED; message = e.message;
+	} catch ( BadArgumentError& e ) {
+		error = PARALLEL_BADARGUMENT; message = e.message;
+	} catch ( BadIndexError& e ) {
+		error = PARALLEL_BADINDEX; message = e.message;
+	} catch ( PsiError& e ) {
+		error = PARALLEL_PSIERROR; message = e.message;
+	} catch ( std::bad_alloc& ) {
+		error = PARALLEL_BADALLOC;
+	} catch ( std::exception& e ) {
+		error = PARALLEL_STDEXCEPTION; what = e.what();
+	} catch ( ... ) {
+		error = PARALLEL_PSIERROR; message = "Unknown error in worker thread";
+	}
+
+	pthread_mutex_lock ( &(run->lock) );
+	if ( run->error==PARALLEL_NOERROR ) {
+		run->error = error;
+		run->message = message;
+		run->what = what;
+	}
+	pthread_mutex_unlock ( &(run->lock) );
+}
+
+static void rethrow_error ( const PsiParallelRun& run )
+{
+	switch ( run.error ) {
+		case PARALLEL_NOERROR:
+			return;
+		case PARALLEL_NOTIMPLEMENTED: {
+			NotImplementedError e;
+			e.message = run.message;
+			throw e;
+		}
+		case PARALLEL_BADARGUMENT:
+			throw BadArgumentError ( run.message );
+		case PARALLEL_BADINDEX: {
+			BadIndexError e;
+			e.message = run.message;
+			throw e;
+		}
+		case PARALLEL_BADALLOC:
+			throw std::bad_alloc ();
+		case PARALLEL_STDEXCEPTION:
+			throw std::runtime_error ( run.what );
+		default:
+			throw PsiError ( run.message );
+	}
+}
+
+static void * parallel_worker ( void * arg )
+{
+	PsiParallelWorker * worker = (PsiParallelWorker*) arg;
+	PsiParallelRun * run ( worker->run );
+	unsigned int item;
+
+	while ( true ) {
+		pthread_mutex_lock ( &(run->lock) );
+		item = ( run->error==PARALLEL_NOERROR && run->next<run->nitems ? run->next++ : run->nitems );
+		pthread_mutex_unlock ( &(run->lock) );
+		if ( item>=run->nitems )
+			break;
+
+		try {
+			run->job->process ( item, worker->thread );
+		} catch ( ... ) {
+			capture_error ( run );
+		}
+	}
+
+	return NULL;
+}
+
+void run_parallel ( PsiParallelJob * job, unsigned int nitems, unsigned int nthreads )
+{
+	unsigned int i, nstarted;
+	if ( nthreads<1 )
+		nthreads = 1;
+	if ( nthreads>nitems )
+		nthreads = nitems;
+
+	if ( nthreads<=1 ) {
+		// Nothing to hand out, errors propagate directly
+		for ( i=0; i<nitems; i++ )
+			job->process ( i, 0 );
+		return;
+	}
+
+	PsiParallelRun run;
+	run.job = job;
+	run.nitems = nitems;
+	run.next = 0;
+	run.error = PARALLEL_NOERROR;
+	run.message = NULL;
+	pthread_mutex_init ( &(run.lock), NULL );
+
+	std::vector<PsiParallelWorker> workers ( nthreads );
+	std::vector<pthread_t> threads ( nthreads-1 );
+	for ( i=0; i<nthreads; i++ ) {
+		workers[i].run = &run;
+		workers[i].thread = i;
+	}
+
+	for ( nstarted=0; nstarted<nthreads-1; nstarted++ )          // the calling thread is the last worker
+		if ( pthread_create ( &(threads[nstarted]), NULL, &parallel_worker, &(workers[nstarted]) ) )
+			break;
+	parallel_worker ( &(workers[nthreads-1]) );
+	for ( i=0; i<nstarted; i++ )
+		pthread_join ( threads[i], NULL );
+	pthread_mutex_destroy ( &(run.lock) );
+
+	rethrow_error ( run );
+}
@@ -0,0 +1,40 @@
+/*
+ *   See COPYING file distributed along with the psignifit package for
+ *   the copyright and license terms
+ */
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "errors.h"
+
+/** \brief work that consists of independent items
+ *
+ * Derived classes hold everything that is needed to process a single item and write the result of item i to a slot that
+ * belongs to item i only. Items are processed in arbitrary order by several threads at a time, so process() must not
+ * modify shared state without protection. Per thread workspace can be kept in slots indexed by the thread.
+ */
+class PsiParallelJob
+{
+	public:
+		virtual ~PsiParallelJob ( void ) {}
+		virtual void process (
+			unsigned int item,                   ///< index of the item to be processed
+			unsigned int thread                  ///< index of the processing thread (in 0..nthreads-1)
+			) = 0;                               ///< process a single item
+};
+
+/** \brief process nitems items of a job on nthreads threads
+ *
+ * Items are handed out one at a time in increasing order. The calling thread is one of the workers, with nthreads<=1
+ * all items are processed in the calling thread. Errors can not cross thread boundaries: the first error that occurs
+ * in any thread stops the handout of further items and is rethrown in the calling thread after all threads finished.
+ * PsiError and its derived classes as well as std::bad_alloc keep their type, other std::exceptions are rethrown as
+ * std::runtime_error with the same message.
+ */
+void run_parallel (
+		PsiParallelJob * job,                    ///< job to be processed
+		unsigned int nitems,                     ///< number of items in the job
+		unsigned int nthreads                    ///< number of threads (at most nitems threads are used)
+		);
+
+#endif
@@ -13,7 +13,9 @@ void GaussPrior::shrink ( double xmin, double xmax ) {
 		sg = s;
 		var = sg*sg;
 		twovar = 2*var;
+		PsiRandomEngine * engine ( rng.getEngine() );  // keep the engine of the old generator
 		rng = GaussRandom ( mu, sg );
+		rng.setEngine ( engine );
 		normalization = 1./(sqrt(2*M_PI)*sg);
 	}
 }
@@ -44,7 +46,9 @@ void BetaPrior::shrink ( double xmin, double xmax ) {
 		beta = m*(1-m)*(1-m)/(s*s) - 1 + m;
 		alpha = m*beta/(1-m);
 		normalization = betaf(alpha,beta);
+		PsiRandomEngine * engine ( rng.getEngine() );  // keep the engine of the old generator
 		rng = BetaRandom ( alpha, beta );
+		rng.setEngine ( engine );
 	}
 }
 
@@ -78,7 +82,9 @@ void GammaPrior::shrink ( double xmin, double xmax ) {
 	k *= k;
 	theta = xmax / (k+sqrt(k));
 	normalization = pow(theta,k)*exp(gammaln(k));
+	PsiRandomEngine * engine ( rng.getEngine() );  // keep the engine of the old generator
 	rng = GammaRandom ( k, theta );
+	rng.setEngine ( engine );
 }
 
 double GammaPrior::ppf ( double p, double start ) const {
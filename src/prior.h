@@ -23,6 +23,7 @@ class PsiPrior
 		virtual double pdf ( double x ) const { return 1.;}    ///< evaluate the pdf of the prior at position x (in this default form, the parameter is completely unconstrained)
 		virtual double dpdf ( double x ) { return 0.; }  ///< evaluate the derivative of the pdf of the prior at position x (in this default form, the parameter is completely unconstrained)
 		virtual double rand ( void ) { return rng.draw(); } ///< draw a random number
+		virtual void setEngine ( PsiRandomEngine * engine ) { rng.setEngine ( engine ); } ///< draw random numbers from engine instead of the global generator (the engine is borrowed)
 		virtual PsiPrior * clone ( void ) const { throw NotImplementedError(); }///< clone by value
 		virtual double mean ( void ) const { return 0; } ///< return the mean
 		virtual double std  ( void ) const { return 1e5; } ///< return the standard deviation
@@ -31,6 +32,8 @@ class PsiPrior
 		virtual double cdf ( double x ) const { throw NotImplementedError(); } ///< cdf of the prior
 		virtual double getprm ( unsigned int prm ) const { throw NotImplementedError(); }
 		virtual double ppf ( double p, double start=NULL ) const { throw NotImplementedError(); }
+		virtual double lowerbound ( void ) const { return -HUGE_VAL; } ///< lower end of the support of the prior
+		virtual double upperbound ( void ) const { return HUGE_VAL; }  ///< upper end of the support of the prior
 };
 
 /** \brief Uniform prior on an interval
@@ -55,6 +58,7 @@ class UniformPrior : public PsiPrior
 		double dpdf ( double x ) { return ( x!=lower && x!=upper ? 0 : (x==lower ? 1e20 : -1e20 ));} ///< derivative of the pdf of the prior at position x (jumps at lower and upper are replaced by large numbers)
 		double rand ( void ) { return rng.draw(); }                                                 ///< draw a random number
         PsiPrior * clone ( void ) const { return new UniformPrior(*this); }
+        void setEngine ( PsiRandomEngine * engine ) { rng.setEngine ( engine ); }
 		double mean ( void ) const { return 0.5*(lower+upper); }  ///< return the mean
 		double std  ( void ) const { return sqrt((upper-lower)*(upper-lower)/12); }
 		void shrink ( double xmin, double xmax ) {}         ////< shrinking is not really defined in this case ~> do not shrink
@@ -62,6 +66,8 @@ class UniformPrior : public PsiPrior
 		double cdf ( double x ) const { return ( x<lower ? 0 : (x>upper ? 1 : (x-lower)/(upper-lower) ) ); }
 		double getprm ( unsigned int prm ) const { return (prm==0 ? lower : upper ); }
 		double ppf ( double p, double start=NULL ) const { return ( p>1 ? upper : (p<0 ? lower : p*(upper-lower)+lower)); }
+		double lowerbound ( void ) const { return lower; }
+		double upperbound ( void ) const { return upper; }
 };
 
 /** \brief gaussian (normal) prior
@@ -90,9 +96,10 @@ class GaussPrior : public PsiPrior
                                                     twovar(original.twovar),
                                                     rng(original.rng) {} ///< copy contructor
 		double pdf ( double x ) const { return normalization * exp ( - (x-mu)*(x-mu)/twovar ); }                                              ///< return pdf of the prior at position x
-		double dpdf ( double x ) { return - x * pdf ( x ) / var; }                                                                      ///< return derivative of the prior at position x
+		double dpdf ( double x ) { return - (x-mu) * pdf ( x ) / var; }                                                                 ///< return derivative of the prior at position x
 		double rand ( void ) {return rng.draw(); }
         PsiPrior * clone ( void ) const { return new GaussPrior(*this); }
+        void setEngine ( PsiRandomEngine * engine ) { rng.setEngine ( engine ); }
 		double mean ( void ) const { return mu; } ///< mean
 		double std  ( void ) const { return sg; } ///< return standard deviation
 		void shrink ( double xmin, double xmax );
@@ -130,9 +137,10 @@ class BetaPrior : public PsiPrior
                                                  rng(original.rng),
                                                  mode(original.mode) {} ///< copy constructor
 		double pdf ( double x ) const { return (x<1e-15||x>1.-1e-15 ? 0 : pow(x,alpha-1)*pow(1-x,beta-1)/normalization); }             ///< return beta pdf
-		double dpdf ( double x ) { return (x<1e-15||x>1.-1e-15 ? 0 : ((alpha-1)*pow(x,alpha-2)*pow(1-x,beta-1) + (beta-1)*pow(1-x,beta-2)*pow(x,alpha-1))/normalization); }      ///< return derivative of beta pdf
+		double dpdf ( double x ) { return (x<1e-15||x>1.-1e-15 ? 0 : ((alpha-1)*pow(x,alpha-2)*pow(1-x,beta-1) - (beta-1)*pow(1-x,beta-2)*pow(x,alpha-1))/normalization); }      ///< return derivative of beta pdf
 		double rand ( void ) {return rng.draw();};                                                                                         ///< draw a random number using rejection sampling
         PsiPrior * clone ( void ) const { return new BetaPrior(*this); }
+        void setEngine ( PsiRandomEngine * engine ) { rng.setEngine ( engine ); }
 		double mean ( void ) const { return alpha/(alpha+beta); }
 		double std  ( void ) const { return sqrt ( alpha*beta/((alpha+beta)*(alpha+beta)*(alpha+beta+1)) ); }
 		void shrink ( double xmin, double xmax );
@@ -140,6 +148,8 @@ class BetaPrior : public PsiPrior
 		double cdf ( double x ) const { return (x<0 ? 0 : (x>1 ? 1 : betainc ( x, alpha, beta ))); }
 		double getprm ( unsigned int prm ) const { return ( prm==0 ? alpha : beta ); }
 		double ppf ( double p, double start=NULL ) const;
+		double lowerbound ( void ) const { return 0; }
+		double upperbound ( void ) const { return 1; }
 };
 
 /** \brief gamma prior
@@ -168,6 +178,7 @@ class GammaPrior : public PsiPrior
 		virtual double dpdf ( double x ) { return (x>1e-15 ? ( (k-1)*pow(x,k-2)*exp(-x/theta)-pow(x,k-1)*exp(-x/theta)/theta)/normalization : 0 ); }                   ///< return derivative of pdf
 		virtual double rand ( void ) {return rng.draw(); };
         PsiPrior * clone ( void ) const { return new GammaPrior(*this); }
+        void setEngine ( PsiRandomEngine * engine ) { rng.setEngine ( engine ); }
 		virtual double mean ( void ) const { return k*theta; }
 		double std  ( void ) const { return sqrt ( k*theta*theta ); }
 		void shrink ( double xmin, double xmax );
@@ -175,6 +186,8 @@ class GammaPrior : public PsiPrior
 		virtual double cdf ( double x ) const { return ( x<0 ? 0 : gammainc ( k, x/theta ) / exp ( gammaln ( k ) ) ); }
 		double getprm ( unsigned int prm ) const { return ( prm==0 ? k : theta ); }
 		virtual double ppf ( double p, double start=NULL ) const;
+		virtual double lowerbound ( void ) const { return 0; }
+		virtual double upperbound ( void ) const { return HUGE_VAL; }
 };
 
 /** \brief negative gamma prior
@@ -200,6 +213,8 @@ class nGammaPrior : public GammaPrior
 		int get_code(void) const { return 4; } /// return the typcode of this prior
 		double cdf ( double x ) const { return ( x>0 ? 1 : 1-GammaPrior::cdf ( -x ) ); }
 		double ppf ( double p, double start=NULL ) const { return - GammaPrior::ppf ( 1-p ); }
+		double lowerbound ( void ) const { return -HUGE_VAL; }
+		double upperbound ( void ) const { return 0; }
 };
 
 /** \brief inverse gamma prior
@@ -229,10 +244,13 @@ class invGammaPrior : public PsiPrior
 		virtual double dpdf ( double x ) { return (x>0 ? ( (-alpha-1)*pow(x,-alpha-2) * exp ( -beta/x ) + pow(x,-alpha-1) * exp ( -beta/x ) * beta / (x*x) ) * normalization : 0 ); }
 		virtual double rand ( void ) { return 1./rng.draw(); }
 		PsiPrior * clone ( void ) const { return new invGammaPrior(*this); }
+		void setEngine ( PsiRandomEngine * engine ) { rng.setEngine ( engine ); }
 		virtual double mean ( void ) const { return beta/(alpha-1); }
 		double std ( void ) const { return ( alpha>2 ? beta / ( (alpha-1)*sqrt(alpha-2) ) : 1e5 ); }
 		virtual void shrink ( double xmin, double xmax ) {} /// Doesn't shrink!!
 		virtual int get_code ( void ) const { return 5; } /// return the typecode of this prior
+		virtual double lowerbound ( void ) const { return 0; }
+		virtual double upperbound ( void ) const { return HUGE_VAL; }
 };
 
 /** \brief negative inverse gamma prior
@@ -257,5 +275,7 @@ class ninvGammaPrior : public invGammaPrior
 		double mean ( void ) const { return -invGammaPrior::mean(); }
 		void shrink ( double xmin, double xmax ) { invGammaPrior::shrink ( -xmax, -xmin ); }
 		int get_code ( void ) const { return 6; } /// return the typecode of this prior
+		double lowerbound ( void ) const { return -HUGE_VAL; }
+		double upperbound ( void ) const { return 0; }
 };
 #endif
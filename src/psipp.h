@@ -19,5 +19,7 @@
 #include "special.h"
 #include "getstart.h"
 #include "integrate.h"
+#include "mcfile.h"
+#include "convergence.h"
 
 #endif
@@ -69,20 +69,47 @@ double PsiPsychometric::evaluate ( double x, const std::vector<double>& prm ) co
 	return gamma + (1-gamma-prm[2]) * Sigmoid->f(Core->g(x,prm));
 }
 
+void PsiPsychometric::evaluate_batch ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * out ) const
+{
+	unsigned int i, n ( data->getNblocks() );
+	double gamma(guessingrate), scale;
+	double * p;
+	if (Nalternatives==1) {
+		if (gammaislambda)
+			gamma = prm[2];
+		else
+			gamma = prm[3];
+	}
+	scale = 1-gamma-prm[2];
+
+	out->resize ( n );
+	if ( n==0 )
+		return;
+
+	// one virtual call to core and sigmoid for all blocks
+	p = &((*out)[0]);
+	Core->g_batch ( &(data->getIntensities()[0]), n, prm, p );
+	Sigmoid->f_batch ( p, n, p );
+	for ( i=0; i<n; i++ )
+		p[i] = gamma + scale * p[i];
+}
+
 double PsiPsychometric::negllikeli ( const std::vector<double>& prm, const PsiData* data ) const
 {
 	unsigned int i;
 	int n,k;
 	double l(0);
-	double x,p,lognoverk;
+	double p,lognoverk;
+	std::vector<double> pred;
+
+	evaluate_batch ( prm, data, &pred );
 
 	for (i=0; i<data->getNblocks(); i++)
 	{
 		n = data->getNtrials(i);
 		k = data->getNcorrect(i);
-		x = data->getIntensity(i);
 		lognoverk = data->getNoverK(i);
-		p = evaluate(x, prm);
+		p = pred[i];
 		l -= lognoverk;
 		if (p>0)
 			l -= k*log(p);
@@ -97,6 +124,39 @@ double PsiPsychometric::negllikeli ( const std::vector<double>& prm, const PsiDa
 	return l;
 }
 
+void PsiPsychometric::negllikeli_blocks ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * out ) const
+{
+	unsigned int i;
+	int n,k;
+	double l;
+	double p;
+
+	evaluate_batch ( prm, data, out );
+
+	for (i=0; i<data->getNblocks(); i++)
+	{
+		n = data->getNtrials(i);
+		k = data->getNcorrect(i);
+		p = (*out)[i];
+		l = -data->getNoverK(i);
+		if (p>0)
+			l -= k*log(p);
+		else
+			l += 1e10;
+		if (p<1)
+			l -= (n-k)*log(1-p);
+		else
+			l += 1e10;
+		(*out)[i] = l;
+	}
+}
+
+void PsiPsychometric::leaveoneout_logratios ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * out ) const
+{
+	// The priors cancel, what remains is the likelihood contribution of the left out block
+	negllikeli_blocks ( prm, data, out );
+}
+
 double expected_ll ( const std::vector<double>& x,
 		const std::vector<double>& p,
 		const std::vector<int>&n,
@@ -124,7 +184,7 @@ double PsiPsychometric::leastfavourable ( const std::vector<double>& prm, const
 	std::vector<double> delta (prm.size(),0), du(prm.size(),0);
 	Matrix * I = new Matrix (prm.size(),prm.size());
 	double ythres,dthres;
-	double rz,nz,xz,pz,fac1;
+	double rz,nz,xz,pz,fac1,dfz;
 	double l_LF(0),ll;
 	double s, h(1e-5),u;
 	unsigned int i,j,z;
@@ -132,6 +192,7 @@ double PsiPsychometric::leastfavourable ( const std::vector<double>& prm, const
 	std::vector<double> x (data->getIntensities());
 	std::vector<double> p (x.size());
 	std::vector<double> pr (x.size());
+	std::vector<double> gz (x.size()), fz (x.size());
 	std::vector<int> n (data->getNtrials());
 	PsiData*localdata;
 
@@ -144,14 +205,10 @@ double PsiPsychometric::leastfavourable ( const std::vector<double>& prm, const
 		th[i] -= h;
 		du[i] /= h;
 	}
-	for ( i=0; i<x.size(); i++ ) {
-		p[i] = evaluate ( x[i], th );
-	}
+	evaluate_batch ( th, data, &p );
 	for ( j=0; j<th.size(); j++ ) {
 		th[j] += h;
-		for ( i=0; i<x.size(); i++ ) {
-			pr[i] = evaluate ( x[i], th );
-		}
+		evaluate_batch ( th, data, &pr );
 		th[j] -= h;
 
 		ll = expected_ll ( x, p, n, pr );
@@ -207,17 +264,21 @@ double PsiPsychometric::leastfavourable ( const std::vector<double>& prm, const
 	    delta[i] /= s;
 
 	// The result has to be multiplied by the gradient of the likelihood
+	Core->g_batch ( &(x[0]), x.size(), prm, &(gz[0]) );
+	Sigmoid->f_batch ( &(gz[0]), x.size(), &(fz[0]) );
+	evaluate_batch ( prm, data, &p );
 	for (z=0; z<data->getNblocks(); z++) {
 		rz = data->getNcorrect(z);
 		nz = data->getNtrials(z);
-		xz = data->getIntensity(z);
-		pz = evaluate(xz,prm);
+		xz = x[z];
+		pz = p[z];
 		fac1 = rz/pz - (nz-rz)/(1-pz);
+		dfz = Sigmoid->df(gz[z]);
 		for (i=0; i<2; i++)
-			l_LF += delta[i] * fac1 * Sigmoid->df(Core->g(xz,prm)) * Core->dg(xz,prm,i);
+			l_LF += delta[i] * fac1 * dfz * Core->dg(xz,prm,i);
 	
 		for (i=2; i<prm.size(); i++)
-			l_LF += delta[i] * fac1 * ( (i==2 ? 1 : 0) - Sigmoid->f(Core->g(xz,prm)) );
+			l_LF += delta[i] * fac1 * ( (i==2 ? 1 : 0) - fz[z] );
 	}
 
 	// If l_LF is nan, return 0
@@ -230,91 +291,206 @@ double PsiPsychometric::leastfavourable ( const std::vector<double>& prm, const
 Matrix * PsiPsychometric::ddnegllikeli ( const std::vector<double>& prm, const PsiData* data ) const
 {
 	Matrix * I = new Matrix ( prm.size(), prm.size() );
+	PsiPsychometric::negllikeli_derivatives ( prm, data, NULL, I );
+	return I;
+}
 
-	double rz,nz,pz,xz,dldf,ddlddf;
-	unsigned int z,i,j;
+std::vector<double> PsiPsychometric::dnegllikeli ( const std::vector<double>& prm, const PsiData* data ) const
+{
+	std::vector<double> gradient;
+	PsiPsychometric::negllikeli_derivatives ( prm, data, &gradient, NULL );
+	return gradient;
+}
 
-	// Fill I
-	for (z=0; z<data->getNblocks(); z++) {
+double PsiPsychometric::negllikeli_derivatives ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * gradient, Matrix * hessian ) const
+{
+	unsigned int z,i,j, nprm ( prm.size() ), nblocks ( data->getNblocks() ), nderiv ( prm.size()<2 ? prm.size() : 2 );
+	double l(0);
+	double rz,nz,pz,lognoverk,dldf,ddlddf,df,ddf,ddp;
+	double gamma(guessingrate), guess ( getGuess(prm) ), scale ( 1-guess-prm[2] );
+	std::vector<double> g ( nblocks ), f ( nblocks ), dp ( nprm ), dg ( 2 );
+
+	if (Nalternatives==1) {
+		if (gammaislambda)
+			gamma = prm[2];
+		else
+			gamma = prm[3];
+	}
+
+	if ( gradient!=NULL )
+		gradient->assign ( nprm, 0 );
+	if ( hessian!=NULL ) {
+		if ( hessian->getnrows()!=nprm || hessian->getncols()!=nprm )
+			throw BadArgumentError ( "Hessian matrix has wrong size" );
+		for (i=0; i<nprm; i++)
+			for (j=0; j<nprm; j++)
+				(*hessian)(i,j) = 0;
+	}
+	if ( nblocks==0 )
+		return l;
+
+	// Core and sigmoid are evaluated only once per block, everything else is derived from g and f
+	Core->g_batch ( &(data->getIntensities()[0]), nblocks, prm, &(g[0]) );
+	Sigmoid->f_batch ( &(g[0]), nblocks, &(f[0]) );
+
+	for (z=0; z<nblocks; z++) {
 		nz = data->getNtrials(z);
-		xz = data->getIntensity(z);
-		pz = evaluate(xz,prm);
 		rz = data->getNcorrect(z);
-		// rz = pz*nz;     // expected Fisher Information matrix
-		dldf   = (nz-rz)/(1-pz) - rz/pz;
-		ddlddf = rz/(pz*pz) + (nz-rz)/((1-pz)*(1-pz));
-
-		// These parts must be determined
-		/*
-		for (i=0; i<2; i++) {
-			for (j=i; j<2; j++) {
-				(*I)(i,j) += fac1 * (1-guessingrate-prm[2]) * (Sigmoid->ddf(Core->g(xz,prm)) * Core->dg(xz,prm,i) * Core->dg(xz,prm,j) + Sigmoid->df(Core->g(xz,prm)) * Core->ddg(xz,prm,i,j));
-				(*I)(i,j) -= fac2 * (1-guessingrate-prm[2]) * (1-guessingrate-prm[2]) * pow(Sigmoid->df(Core->g(xz,prm)),2) * Core->dg(xz,prm,i) * Core->dg(xz,prm,j);
-			}
-			for (j=2; j<prm.size(); j++) {
-				(*I)(i,j) -= fac1 * Sigmoid->df(Core->g(xz,prm)) * Core->dg(xz,prm,i);
-				(*I)(i,j) -= fac2 * (1-guessingrate-prm[2]) * Sigmoid->df(Core->g(xz,prm)) * Core->dg(xz,prm,i) * ( (j==2 ? 0 : 1) - Sigmoid->f(Core->g(xz,prm)) );
-			}
+		lognoverk = data->getNoverK(z);
+		pz = gamma + (1-gamma-prm[2]) * f[z];
+
+		l -= lognoverk;
+		if (pz>0)
+			l -= rz*log(pz);
+		else
+			l += 1e10;
+		if (pz<1)
+			l -= (nz-rz)*log(1-pz);
+		else
+			l += 1e10;
+
+		if ( gradient==NULL && hessian==NULL )
+			continue;
+
+		// derivatives of the prediction (see dpredict)
+		df = Sigmoid->df ( g[z] );
+		for ( i=0; i<nderiv; i++ )
+			dg[i] = Core->dg ( data->getIntensity(z), prm, i );
+		for ( i=0; i<nprm; i++ ) {
+			if ( i<2 )
+				dp[i] = scale * df * dg[i];
+			else if ( i==2 )
+				dp[i] = -f[z];
+			else if ( i==3 && Nalternatives<2 )
+				dp[i] = 1-f[z];
+			else
+				dp[i] = 0;
 		}
-		for ( i=2; i<prm.size(); i++ ) {
-			for ( j=2; j<prm.size(); j++ ) {
-				(*I)(i,j) -= fac2 * ( (j==2 ? 0 : 1) - Sigmoid->f(Core->g(xz,prm)) ) * ( (i==2 ? 0 : 1 ) - Sigmoid->f(Core->g(xz,prm)) );
-			}
+		dldf = rz/pz - (nz-rz)/(1-pz);
+
+		if ( gradient!=NULL ) {
+			for ( i=0; i<nprm; i++ )
+				(*gradient)[i] -= dldf * dp[i];
 		}
-		*/
-		for ( i=0; i<prm.size(); i++ ) {
-			for ( j=i; j<prm.size(); j++ ) {
-				(*I)(i,j) -= ddlddf * dpredict(prm,xz,i) * dpredict(prm,xz,j);
-				(*I)(i,j) -= dldf   * ddpredict ( prm, xz, i, j );
+
+		if ( hessian!=NULL ) {
+			// 2nd derivatives of the prediction (see ddpredict)
+			ddf = Sigmoid->ddf ( g[z] );
+			ddlddf = rz/(pz*pz) + (nz-rz)/((1-pz)*(1-pz));
+			for ( i=0; i<nprm; i++ ) {
+				for ( j=i; j<nprm; j++ ) {
+					if ( j<2 ) {
+						ddp  = ddf * dg[i] * dg[j];
+						ddp += df  * Core->ddg ( data->getIntensity(z), prm, i, j );
+						ddp *= scale;
+					} else if ( i<2 && ( j==2 || ( j==3 && Nalternatives<2 ) ) ) {
+						ddp = - df * dg[i];
+					} else {
+						ddp = 0;
+					}
+					(*hessian)(i,j) -= ddlddf * dp[i] * dp[j];
+					(*hessian)(i,j) += dldf   * ddp;
+				}
 			}
 		}
 	}
 
-	// The remaining parts of I can be copied
-	for (i=1; i<prm.size(); i++)
-		for (j=0; j<i; j++)
-			(*I)(i,j) = (*I)(j,i);
+	// The remaining parts of the hessian can be copied
+	if ( hessian!=NULL ) {
+		for (i=1; i<nprm; i++)
+			for (j=0; j<i; j++)
+				(*hessian)(i,j) = (*hessian)(j,i);
+	}
 
-	return I;
+	return l;
 }
 
-std::vector<double> PsiPsychometric::dnegllikeli ( const std::vector<double>& prm, const PsiData* data ) const
+std::vector<double> PsiPsychometric::dlposterior ( const std::vector<double>& prm, const PsiData* data ) const
 {
-	std::vector<double> gradient (prm.size());
-	double rz,xz,pz,nz,dldf;
-	unsigned int z,i;
-	double guess (guessingrate);
-	if ( Nalternatives < 2 ) guess = prm[3];
+	unsigned int i;
+	std::vector<double> gradient;
 
-	for (z=0; z<data->getNblocks(); z++) {
-		rz = data->getNcorrect(z);
-		nz = data->getNtrials(z);
-		xz = data->getIntensity(z);
-		pz = evaluate(xz,prm);
-		dldf = rz/pz - (nz-rz)/(1-pz);
+	negllikeli_derivatives ( prm, data, &gradient, NULL );
 
-		// fill gradient vector
-		for ( i=0; i<prm.size(); i++ ) {
-			gradient[i] -= dldf * dpredict ( prm, xz, i );
-		}
-	}
+	gradient.resize ( getNparams() );
+	for ( i=0; i<getNparams(); i++ )
+		gradient[i] = priors[i]->dpdf(prm[i]) - gradient[i];
 
 	return gradient;
 }
 
+void PsiPsychometric::getSupport ( unsigned int index, double * lower, double * upper ) const
+{
+	if ( index>=priors.size() )
+		throw BadIndexError ();
+	*lower = priors[index]->lowerbound ();
+	*upper = priors[index]->upperbound ();
+}
+
+double PsiPsychometric::neglpost_derivatives ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * gradient ) const
+{
+	unsigned int i;
+	double l, p;
+
+	l = negllikeli_derivatives ( prm, data, gradient, NULL );
+	if ( gradient!=NULL )
+		gradient->resize ( getNparams() );
+
+	for ( i=0; i<getNparams(); i++ ) {
+		p = priors[i]->pdf ( prm[i] );
+		l -= log ( p );
+		if ( gradient!=NULL && p>0 )
+			(*gradient)[i] -= priors[i]->dpdf ( prm[i] ) / p;
+	}
+
+	return l;
+}
+
+/** \brief negative log posterior and its finite difference gradient
+ *
+ * For models that only evaluate the posterior as a whole. The difference is taken in the direction away from the nearer
+ * bound of the support of the prior, so that both points are inside the support.
+ */
+double numerical_neglpost_derivatives ( const PsiPsychometric * pmf, const std::vector<double>& prm, const PsiData* data, std::vector<double> * gradient )
+{
+	unsigned int i;
+	double l ( pmf->neglpost ( prm, data ) ), h, lower, upper;
+	std::vector<double> prm2 ( prm );
+
+	if ( gradient==NULL )
+		return l;
+
+	gradient->resize ( pmf->getNparams() );
+	for ( i=0; i<pmf->getNparams(); i++ ) {
+		pmf->getSupport ( i, &lower, &upper );
+		h = .001;
+		if ( upper-lower<4*h )
+			h = 0.25*(upper-lower);       // narrow support
+		if ( prm[i]+h>=upper )
+			h = -h;                       // backward difference at the upper bound
+		prm2[i] += h;
+		(*gradient)[i] = ( pmf->neglpost ( prm2, data ) - l ) / h;
+		prm2[i] = prm[i];
+	}
+
+	return l;
+}
+
 double PsiPsychometric::deviance ( const std::vector<double>& prm, const PsiData* data ) const
 {
 	unsigned int i;
 	int n;
 	double D(0);
-	double x,y,p;
+	double y,p;
+	std::vector<double> pred;
+
+	evaluate_batch ( prm, data, &pred );
 
 	for ( i=0; i<data->getNblocks(); i++ )
 	{
 		n = data->getNtrials(i);
 		y = data->getPcorrect(i);
-		x = data->getIntensity(i);
-		p = evaluate( x, prm );
+		p = pred[i];
 		if (y>0)
 			D += n*y*log(y/p);
 		if (y<1)
@@ -350,6 +526,18 @@ double PsiPsychometric::neglpost ( const std::vector<double>& prm, const PsiData
 	return l;
 }
 
+void PsiPsychometric::neglpost_batch ( const double * prm, unsigned int npoints, const PsiData* data, double * out ) const
+{
+	unsigned int i, nprm ( getNparams() );
+	std::vector<double> theta ( nprm );
+
+	// one parameter vector for all points, neglpost is virtual so that derived models are evaluated correctly
+	for ( i=0; i<npoints; i++, prm+=nprm ) {
+		theta.assign ( prm, prm+nprm );
+		out[i] = neglpost ( theta, data );
+	}
+}
+
 std::vector<double> PsiPsychometric::getStart ( const PsiData* data ) const
 {
 	unsigned int i;
@@ -508,15 +696,17 @@ std::vector<double> PsiPsychometric::getDevianceResiduals ( const std::vector<do
 {
 	unsigned int i;
 	int n;
-	double x,y,p;
+	double y,p;
 	std::vector<double> out (data->getNblocks());
+	std::vector<double> pred;
+
+	evaluate_batch ( prm, data, &pred );
 
 	for ( i=0; i<data->getNblocks(); i++ )
 	{
 		n = data->getNtrials(i);
 		y = data->getPcorrect(i);
-		x = data->getIntensity(i);
-		p = evaluate(x,prm);
+		p = pred[i];
 		out[i] = 0;
 		if (y>0)
 			out[i] += n*y*log(y/p);
@@ -531,12 +721,10 @@ std::vector<double> PsiPsychometric::getDevianceResiduals ( const std::vector<do
 double PsiPsychometric::getRpd ( const std::vector<double>& devianceresiduals, const std::vector<double>& prm, const PsiData* data ) const {
 	int k,N(data->getNblocks());
 	double Ed(0),Ep(0),vard(0),varp(0),R(0);
-	std::vector<double> p ( N );
+	std::vector<double> p;
 
 	// Evaluate p values in advance
-	for ( k=0; k<N; k++ ) {
-		p[k] = evaluate(data->getIntensity(k),prm);
-	}
+	evaluate_batch ( prm, data, &p );
 
 	// Calculate averages
 	for ( k=0; k<N; k++ ) {
@@ -668,6 +856,7 @@ double PMF_with_JeffreysPrior::neglpost ( const std::vector<double>& prm, const
 {
 	unsigned int i, j, k;
 	double dd, pk, dpi, dpj;
+	Matrix fisher ( getNparams(), getNparams() );      // local to keep concurrent evaluations independent
 
 	// calculate expected Fisher Information
 	for ( i=0; i<getNparams(); i++ ) {
@@ -730,6 +919,17 @@ double PMF_with_JeffreysPrior::neglpost ( const std::vector<double>& prm, const
 	return negllikeli ( prm, data ) - 0.5*log(dd);
 }
 
+void PMF_with_JeffreysPrior::leaveoneout_logratios ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * out ) const
+{
+	unsigned int k;
+	double full ( neglpost ( prm, data ) );
+	out->resize ( data->getNblocks() );
+	for ( k=0; k<data->getNblocks(); k++ ) {
+		PsiData reduceddata ( *data, k );
+		(*out)[k] = full - neglpost ( prm, &reduceddata );
+	}
+}
+
 double PMF_with_JeffreysPrior::dlposteri ( std::vector<double> prm, const PsiData* data, unsigned int i ) const
 {
 	// numerical approximation
@@ -741,30 +941,60 @@ double PMF_with_JeffreysPrior::dlposteri ( std::vector<double> prm, const PsiDat
 	return df/h;
 }
 
+std::vector<double> PMF_with_JeffreysPrior::dlposterior ( const std::vector<double>& prm, const PsiData* data ) const
+{
+	unsigned int i;
+	std::vector<double> gradient ( getNparams() );
+
+	for ( i=0; i<getNparams(); i++ )
+		gradient[i] = dlposteri ( prm, data, i );
+
+	return gradient;
+}
+
+double PMF_with_JeffreysPrior::neglpost_derivatives ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * gradient ) const
+{
+	return numerical_neglpost_derivatives ( this, prm, data, gradient );
+}
+
 /******************************** BetaPsychometric **************************************/
 
 double BetaPsychometric::negllikeli ( const std::vector<double>& prm, const PsiData* data ) const
+{
+	unsigned int i;
+	double l(0);
+	std::vector<double> blocks;
+
+	negllikeli_blocks ( prm, data, &blocks );
+	for (i=0; i<data->getNblocks(); i++)
+		l += blocks[i];
+
+	return l;
+}
+
+void BetaPsychometric::negllikeli_blocks ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * out ) const
 {
 	unsigned int i;
 	int n;
 	double k;
-	double l(0);
-	double x,p,al,bt;
+	double l;
+	double p,al,bt;
 	unsigned int nupos ( getNparams()-1 );
 	double nu;
 
+	evaluate_batch ( prm, data, out );
+
 	for (i=0; i<data->getNblocks(); i++)
 	{
 		n = data->getNtrials(i);
 		k = data->getPcorrect(i);
 		if ( k==1 || k==0 )
 			k = double (data->getNcorrect(i))/(0.5+n);
-		x = data->getIntensity(i);
-		p = evaluate (x, prm);
+		p = (*out)[i];
 		nu = prm[nupos];
 		al = p*nu*n;
 		bt = (1-p)*nu*n;
-		l -= gammaln ( nu*n ) - gammaln ( al ) - gammaln ( bt );
+		l = -( gammaln ( nu*n ) - gammaln ( al ) - gammaln ( bt ) );
 		if (k>0)
 			l -= (al-1)*log(k);
 		else
@@ -773,10 +1003,9 @@ double BetaPsychometric::negllikeli ( const std::vector<double>& prm, const PsiD
 			l -= (bt-1)*log(1-k);
 		else
 			l += 1e10;
+		(*out)[i] = l;
 	}
-
-	return l;
-};
+}
 
 std::vector<double> BetaPsychometric::dnegllikeli ( const std::vector<double>& prm, const PsiData* data ) const
 {
@@ -869,6 +1098,24 @@ Matrix * BetaPsychometric::ddnegllikeli ( const std::vector<double>& prm, const
 	return I;
 };
 
+double BetaPsychometric::negllikeli_derivatives ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * gradient, Matrix * hessian ) const
+{
+	unsigned int i,j;
+	Matrix * I;
+
+	if ( gradient!=NULL )
+		*gradient = dnegllikeli ( prm, data );
+	if ( hessian!=NULL ) {
+		I = ddnegllikeli ( prm, data );
+		for ( i=0; i<prm.size(); i++ )
+			for ( j=0; j<prm.size(); j++ )
+				(*hessian)(i,j) = (*I)(i,j);
+		delete I;
+	}
+
+	return negllikeli ( prm, data );
+}
+
 double BetaPsychometric::fznull ( unsigned int z, const PsiData * data, double nu ) const {
 	double x ( data->getPcorrect ( z ) );
 	double nunz (nu*data->getNtrials ( z ) );
@@ -964,6 +1211,46 @@ double OutlierModel::negllikeli ( const std::vector<double>& prm, const PsiData*
 	return ll;
 }
 
+double OutlierModel::negllikeli_derivatives ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * gradient, Matrix * hessian ) const
+{
+	if ( getNalternatives() != data->getNalternatives() )
+		throw BadArgumentError();
+	if ( prm.size() != getNparams() )
+		throw BadArgumentError ( "OutlierModel needs the outlier probability as last parameter" );
+
+	PsiData localdata ( *data, jout );
+	unsigned int iout ( getNparams()-1 );
+	double p ( getp ( prm ) ), k ( data->getNcorrect(jout) ), n ( data->getNtrials(jout) );
+	double l;
+
+	// The regular blocks do not depend on the outlier probability, so the
+	// underlying model gives the full sized derivatives with zeros at iout
+	l = PsiPsychometric::negllikeli_derivatives ( prm, &localdata, gradient, hessian );
+
+	// The outlier block depends on nothing but the outlier probability
+	l -= data->getNoverK(jout);
+	if (p>0) l -= k*log(p);
+	if (p<1) l -= (n-k)*log(1-p);
+
+	if ( gradient!=NULL )
+		(*gradient)[iout] = (n-k)/(1-p) - k/p;
+	if ( hessian!=NULL )
+		(*hessian)(iout,iout) = - k/(p*p) - (n-k)/((1-p)*(1-p));
+
+	return l;
+}
+
+void OutlierModel::leaveoneout_logratios ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * out ) const
+{
+	unsigned int k;
+	double full ( neglpost ( prm, data ) );
+	out->resize ( data->getNblocks() );
+	for ( k=0; k<data->getNblocks(); k++ ) {
+		PsiData reduceddata ( *data, k );
+		(*out)[k] = full - neglpost ( prm, &reduceddata );
+	}
+}
+
 double OutlierModel::deviance ( const std::vector<double>& prm, const PsiData* data ) const
 {
 	unsigned int i;
@@ -1008,3 +1295,19 @@ double OutlierModel::neglpost ( const std::vector<double>& prm, const PsiData* d
 
 	return l;
 }
+
+void OutlierModel::getSupport ( unsigned int index, double * lower, double * upper ) const
+{
+	if ( index<PsiPsychometric::getNparams() ) {
+		PsiPsychometric::getSupport ( index, lower, upper );
+	} else if ( index==PsiPsychometric::getNparams() ) {
+		*lower = 0;
+		*upper = 1;
+	} else
+		throw BadIndexError ();
+}
+
+double OutlierModel::neglpost_derivatives ( const std::vector<double>& prm, const PsiData* data, std::vector<double> * gradient ) const
+{
+	return numerical_neglpost_derivatives ( this, prm, data, gradient );
+}
@@ -60,6 +60,11 @@ class PsiPsychometric {
 			double x,                                                                ///< stimulus intensity
 			const std::vector<double>& prm                                           ///< parameters of the psychometric function model
 			) const;  ///< Evaluate the psychometric function at this position
+		virtual void evaluate_batch (
+			const std::vector<double>& prm,                                          ///< parameters of the psychometric function model
+			const PsiData* data,                                                     ///< data set with the stimulus intensities
+			std::vector<double> * out                                                ///< output: psychometric function at every block of data
+			) const;  ///< Evaluate the psychometric function at all stimulus intensities of data (derived classes that change evaluate() should change this as well)
 		virtual double negllikeli (
 			const std::vector<double>& prm,                                          ///< parameters of the psychometric function model
 			const PsiData* data                                                      ///< data for which the likelihood should be evaluated
@@ -68,6 +73,22 @@ class PsiPsychometric {
 			const std::vector<double>& prm,                                          ///< parameters of the psychometric function model
 			const PsiData* data                                                      ///< data for which the posterior should be evaluated
 			) const;     ///< negative log posterior  (unnormalized)
+		virtual void neglpost_batch (
+			const double * prm,                                                      ///< npoints parameter vectors of getNparams() values each, stored one after the other
+			unsigned int npoints,                                                    ///< number of parameter vectors
+			const PsiData* data,                                                     ///< data for which the posterior should be evaluated
+			double * out                                                             ///< output: negative log posterior for every parameter vector
+			) const;     ///< negative log posterior (unnormalized) for many parameter vectors in one call
+		virtual void negllikeli_blocks (
+			const std::vector<double>& prm,                                          ///< parameters of the psychometric function model
+			const PsiData* data,                                                     ///< data for which the likelihood should be evaluated
+			std::vector<double> * out                                                ///< output: contribution of every block to the negative log likelihood (resized to the number of blocks)
+			) const;   ///< negative log likelihood of every single block (negllikeli is the sum of these)
+		virtual void leaveoneout_logratios (
+			const std::vector<double>& prm,                                          ///< parameters of the psychometric function model
+			const PsiData* data,                                                     ///< full data set
+			std::vector<double> * out                                                ///< output: neglpost(prm,data)-neglpost(prm,data without block k) for every block k (resized to the number of blocks)
+			) const;   ///< log posterior ratios of the full and the leave-one-out data sets, computed from the block contributions in a single pass
 		virtual double leastfavourable (
 			const std::vector<double>& prm,                                          ///< parameters of the psychometric function model
 			const PsiData* data,                                                     ///< data for which the likelihood should be evaluated
@@ -86,12 +107,28 @@ class PsiPsychometric {
 				const std::vector<double>& prm,                                      ///< parameters at which the first derivative should be evaluated
 				const PsiData* data                                                  ///< data for which the likelihood should be evaluated
 				) const;                                          ///< 1st derivative of the negative log likelihood
+		virtual double negllikeli_derivatives (
+				const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
+				const PsiData* data,                                                 ///< data for which the likelihood should be evaluated
+				std::vector<double> * gradient,                                      ///< output: 1st derivative as returned by dnegllikeli (NULL to skip)
+				Matrix * hessian                                                     ///< output: 2nd derivative as returned by ddnegllikeli, must have size nprm x nprm (NULL to skip)
+				) const;                                          ///< negative log likelihood and its derivatives in a single pass over the blocks
+		virtual std::vector<double> dlposterior (
+				const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
+				const PsiData* data                                                  ///< data for which the posterior should be evaluated
+				) const;                                          ///< derivatives of the log posterior with respect to all parameters (the same as dlposteri for every parameter)
+		virtual double neglpost_derivatives (
+				const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
+				const PsiData* data,                                                 ///< data for which the posterior should be evaluated
+				std::vector<double> * gradient                                       ///< output: derivatives of the negative log posterior with respect to all parameters (NULL to skip)
+				) const;                                          ///< negative log posterior and its gradient in a single pass over the blocks (as needed for hamiltonian dynamics)
 		const PsiCore* getCore ( void ) const { return Core; }                ///< get the core of the psychometric function
 		const PsiSigmoid* getSigmoid ( void ) const { return Sigmoid; }       ///< get the sigmoid of the psychometric function
 		virtual void setPrior ( unsigned int index, PsiPrior* prior ) throw(BadArgumentError);                   ///< set a Prior for the parameter indicated by index
 		double evalPrior ( unsigned int index, double x ) const {return priors[index]->pdf(x);}              ///< evaluate the respective prior at value x
 		virtual double randPrior ( unsigned int index ) const { return priors[index]->rand(); }                            ///< sample form a prior
 		const PsiPrior* getPrior ( unsigned int index ) const { return priors[index]; } ///< get a prior
+		virtual void getSupport ( unsigned int index, double * lower, double * upper ) const;   ///< range of parameter index in which the prior is positive
 		int getNalternatives ( void ) const { return Nalternatives; }         ///< get the number of alternatives (1 means yes/no)
 		virtual unsigned int getNparams ( void ) const { return (Nalternatives==1 ? (gammaislambda ? 3 : 4 ) : 3 ); } ///< get the number of free parameters of the psychometric function
 		virtual std::vector<double> getStart ( const PsiData* data ) const ;                ///< determine a starting value using logistic regression on a dataset
@@ -143,24 +180,36 @@ class PsiPsychometric {
  */
 class PMF_with_JeffreysPrior : public PsiPsychometric
 {
-	private:
-		Matrix fisher;
 	public:
 		PMF_with_JeffreysPrior (
 			int nAFC,                                                                ///< number of alternatives in the task (1 indicating yes/no)
 			PsiCore * core,                                                          ///< internal part of the nonlinear function (in many cases this is actually a linear function)
 			PsiSigmoid * sigmoid                                                     ///< "external" saturating part of the nonlinear function
-			) : PsiPsychometric ( nAFC, core, sigmoid ), fisher(getNparams(), getNparams()) { }    ///< Set up a psychometric function model for an nAFC task (nAFC=1 ~> yes/no)
+			) : PsiPsychometric ( nAFC, core, sigmoid ) { }    ///< Set up a psychometric function model for an nAFC task (nAFC=1 ~> yes/no)
 		~PMF_with_JeffreysPrior () { }
 
 		double neglpost ( const std::vector<double>& prm,
 				const PsiData* data
 				) const;
+		void leaveoneout_logratios (
+			const std::vector<double>& prm,                                              ///< parameters of the psychometric function model
+			const PsiData* data,                                                         ///< full data set
+			std::vector<double> * out                                                    ///< output: log posterior ratios for every left out block
+			) const;                                                                 ///< log posterior ratios (Jeffrey's prior depends on the data, so the reduced data sets are evaluated explicitly)
 		double dlposteri (
 			std::vector<double> prm,                                                     ///< parameters of the psychometric function model
 			const PsiData* data,                                                         ///< data for which the likelihood should be valuated
 			unsigned int i                                                               ///< index of the parameter for which the derivative should be evaluated
 			) const;                                                                 ///< derivative of the negative log posterior with respect to parameter i
+		std::vector<double> dlposterior (
+			const std::vector<double>& prm,                                              ///< parameters of the psychometric function model
+			const PsiData* data                                                          ///< data for which the posterior should be evaluated
+			) const;                                                                 ///< derivatives of the log posterior with respect to all parameters
+		double neglpost_derivatives (
+			const std::vector<double>& prm,                                              ///< parameters of the psychometric function model
+			const PsiData* data,                                                         ///< data for which the posterior should be evaluated
+			std::vector<double> * gradient                                               ///< output: derivatives of the negative log posterior (NULL to skip)
+			) const;                                                                 ///< negative log posterior and its gradient (numerical approximation, as dlposteri)
 		void setPrior ( unsigned int index, PsiPrior* prior ) throw(BadArgumentError) { throw BadArgumentError ( "With Jeffrey's prior, you can't set independent priors for individual parameters" ); }                   ///< set a Prior for the parameter indicated by index
 };
 
@@ -182,6 +231,11 @@ class BetaPsychometric : public PsiPsychometric {
 			const std::vector<double>& prm,           ///< parameters of the psychometric function model
 			const PsiData* data                       ///< data for which the likelihood should be evaluated
 			) const; ///< negative log likelihood
+		void negllikeli_blocks (
+			const std::vector<double>& prm,           ///< parameters of the psychometric function model
+			const PsiData* data,                      ///< data for which the likelihood should be evaluated
+			std::vector<double> * out                 ///< output: contribution of every block to the negative log likelihood
+			) const; ///< negative log likelihood of every single block
 		std::vector<double> dnegllikeli (
 				const std::vector<double>& prm,       ///< parameters at which the first derivative should be evaluated
 				const PsiData* data                   ///< data for which the likelihood should be evaluated
@@ -190,6 +244,12 @@ class BetaPsychometric : public PsiPsychometric {
 				const std::vector<double>& prm,       ///< parameters at which the second derivative should be evaluated
 				const PsiData* data                   ///< data for which the likelihood should be evaluated
 				) const;                 ///< 2nd derivative of the negative log likelihood (newly allocated matrix)
+		double negllikeli_derivatives (
+				const std::vector<double>& prm,       ///< parameters of the psychometric function model
+				const PsiData* data,                  ///< data for which the likelihood should be evaluated
+				std::vector<double> * gradient,       ///< output: 1st derivative (NULL to skip)
+				Matrix * hessian                      ///< output: 2nd derivative (NULL to skip)
+				) const;                 ///< negative log likelihood and its derivatives (evaluated separately for this model)
 		unsigned int getNparams ( void ) const { return PsiPsychometric::getNparams()+1; }   ///< get the number of free parameters of the psychometric function
 		double deviance (
 			const std::vector<double>& prm,                      ///< parameters of the psychometric function model
@@ -230,16 +290,33 @@ class OutlierModel : public PsiPsychometric {
 			const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
 			const PsiData * data                                                 ///< data for which the likelihood should be evaluated
 			) const;                         ///< negative log likelihood
+		double negllikeli_derivatives (
+			const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
+			const PsiData* data,                                                 ///< data for which the likelihood should be evaluated
+			std::vector<double> * gradient,                                      ///< output: 1st derivative (NULL to skip)
+			Matrix * hessian                                                     ///< output: 2nd derivative (NULL to skip)
+			) const;                         ///< negative log likelihood and its derivatives with respect to all parameters including the outlier probability
 		double neglpost (
 			const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
 			const PsiData * data                                                 ///< data for which the likelihood should be evaluated
 			) const;                         ///< negative log likelihood
+		double neglpost_derivatives (
+			const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
+			const PsiData* data,                                                 ///< data for which the posterior should be evaluated
+			std::vector<double> * gradient                                       ///< output: derivatives of the negative log posterior (NULL to skip)
+			) const;                         ///< negative log posterior and its gradient (numerical approximation, the outlier block is not a regular block)
+		void leaveoneout_logratios (
+			const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
+			const PsiData* data,                                                 ///< full data set
+			std::vector<double> * out                                            ///< output: log posterior ratios for every left out block
+			) const;                         ///< log posterior ratios (the outlier block is not a regular block, so the reduced data sets are evaluated explicitly)
 		double deviance (
 			const std::vector<double>& prm,                                      ///< parameters of the psychometric function model
 			const PsiData* data                                                  ///< data for which the deviance should be evaluated
 			) const;                        ///< deviance
 		unsigned int getNparams ( void ) const { return PsiPsychometric::getNparams()+1; }
 		double randPrior ( unsigned int index ) const { return ( index<PsiPsychometric::getNparams() ? PsiPsychometric::randPrior(index) : PsiRandom().rngcall() ); }                            ///< sample form a prior
+		void getSupport ( unsigned int index, double * lower, double * upper ) const;   ///< range of parameter index in which the prior is positive (the outlier probability is in [0,1])
 };
 
 #endif
@@ -201,8 +201,86 @@ int main(void)
 }
 */
 
+/****** xoshiro256** engine *****/
+
+/* xoshiro256** and splitmix64 are due to David Blackman and Sebastiano Vigna (2018),
+ * http://prng.di.unimi.it/ */
+
+static inline uint64_t rotl ( const uint64_t x, int k ) {
+	return (x << k) | (x >> (64 - k));
+}
+
+PsiRandomEngine::PsiRandomEngine ( unsigned long seedval, unsigned long stream )
+{
+	unsigned long i;
+	seed ( seedval );
+	for ( i=0; i<stream; i++ )
+		jump ();
+}
+
+void PsiRandomEngine::seed ( unsigned long seedval )
+{
+	// The state is filled using splitmix64 to avoid correlated states for neighbouring seeds
+	uint64_t z, x ( seedval );
+	unsigned int i;
+	for ( i=0; i<4; i++ ) {
+		z = ( x += 0x9e3779b97f4a7c15ULL );
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		s[i] = z ^ (z >> 31);
+	}
+}
+
+uint64_t PsiRandomEngine::next ( void )
+{
+	const uint64_t result ( rotl ( s[1] * 5, 7 ) * 9 );
+	const uint64_t t ( s[1] << 17 );
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl ( s[3], 45 );
+
+	return result;
+}
+
+void PsiRandomEngine::jump ( void )
+{
+	static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+	uint64_t s0(0), s1(0), s2(0), s3(0);
+	unsigned int i, b;
+
+	for ( i=0; i<4; i++ ) {
+		for ( b=0; b<64; b++ ) {
+			if ( JUMP[i] & (uint64_t(1) << b) ) {
+				s0 ^= s[0];
+				s1 ^= s[1];
+				s2 ^= s[2];
+				s3 ^= s[3];
+			}
+			next ();
+		}
+	}
+
+	s[0] = s0;
+	s[1] = s1;
+	s[2] = s2;
+	s[3] = s3;
+}
+
+PsiRandomEngine PsiRandomEngine::split ( void )
+{
+	PsiRandomEngine out ( *this );
+	jump ();
+	return out;
+}
+
+/****** END OF xoshiro256** *****/
+
 double PsiRandom::rngcall ( void ) {
-	return genrand_real2();
+	return ( engine==NULL ? genrand_real2() : engine->draw() );
 }
 
 double GaussRandom::draw ( void )
@@ -226,11 +304,133 @@ double GaussRandom::draw ( void )
 
 double BinomialRandom::draw ( void )
 {
-	int k(0),i;
-	for (i=0; i<n; i++)
-		if ( rngcall() < p )
-			k++;
-	return k;
+	/* implementation from numpy: numpy/random/mtrand/distributions.c */
+	if ( n<=0 || p<=0 )
+		return 0;
+	if ( p>=1 )
+		return n;
+
+	if ( p<=0.5 ) {
+		if ( p*n <= 30.0 )
+			return inversion ( n, p );
+		else
+			return btpe ( n, p );
+	} else {
+		if ( (1-p)*n <= 30.0 )
+			return n - inversion ( n, 1-p );
+		else
+			return n - btpe ( n, 1-p );
+	}
+}
+
+int BinomialRandom::inversion ( int n, double p )
+{
+	double q ( 1-p ), qn ( exp ( n*log(q) ) ), np ( n*p ), px, U;
+	int X;
+	double bound ( np + 10.0*sqrt(np*q + 1) );
+	if ( bound > n ) bound = n;
+
+	X = 0;
+	px = qn;
+	U = rngcall();
+	while ( U > px ) {
+		X++;
+		if ( X > bound ) {
+			X = 0;
+			px = qn;
+			U = rngcall();
+		} else {
+			U -= px;
+			px = ((n-X+1) * p * px)/(X*q);
+		}
+	}
+	return X;
+}
+
+int BinomialRandom::btpe ( int n, double r )
+{
+	double q ( 1-r ), fm ( n*r+r ), nrq ( n*r*q );
+	int m ( int ( floor ( fm ) ) );
+	double p1 ( floor ( 2.195*sqrt(nrq) - 4.6*q ) + 0.5 );
+	double xm ( m + 0.5 ), xl ( xm - p1 ), xr ( xm + p1 );
+	double c ( 0.134 + 20.5/(15.3 + m) );
+	double a, laml, lamr, p2, p3, p4;
+	double u, v, s, F, rho, t, A, x, x1, x2, f1, f2, z, z2, w, w2;
+	int y, k, i;
+
+	a = (fm - xl)/(fm - xl*r);
+	laml = a*(1.0 + a/2.0);
+	a = (xr - fm)/(xr*q);
+	lamr = a*(1.0 + a/2.0);
+	p2 = p1*(1.0 + 2.0*c);
+	p3 = p2 + c/laml;
+	p4 = p3 + c/lamr;
+
+	while ( true ) {
+		u = rngcall()*p4;
+		v = rngcall();
+		if ( u <= p1 ) {
+			// triangular region: accept immediately
+			return int ( floor ( xm - p1*v + u ) );
+		} else if ( u <= p2 ) {
+			// parallelograms
+			x = xl + (u - p1)/c;
+			v = v*c + 1.0 - fabs ( m - x + 0.5 )/p1;
+			if ( v > 1.0 ) continue;
+			y = int ( floor ( x ) );
+		} else if ( u <= p3 ) {
+			// left exponential tail
+			if ( v==0.0 ) continue;     // log(0) can not be converted to int
+			y = int ( floor ( xl + log(v)/laml ) );
+			if ( y < 0 ) continue;
+			v = v*(u-p2)*laml;
+		} else {
+			// right exponential tail
+			if ( v==0.0 ) continue;
+			y = int ( floor ( xr - log(v)/lamr ) );
+			if ( y > n ) continue;
+			v = v*(u-p3)*lamr;
+		}
+
+		k = abs ( y - m );
+		if ( k<=20 || k>=nrq/2.0-1 ) {
+			// explicit evaluation of f(y)/f(m)
+			s = r/q;
+			a = s*(n+1);
+			F = 1.0;
+			if ( m < y ) {
+				for ( i=m+1; i<=y; i++ ) F *= (a/i - s);
+			} else if ( m > y ) {
+				for ( i=y+1; i<=m; i++ ) F /= (a/i - s);
+			}
+			if ( v <= F ) return y;
+		} else {
+			// squeeze using upper and lower bounds on log(f(y))
+			rho = (k/nrq)*((k*(k/3.0 + 0.625) + 0.16666666666666666)/nrq + 0.5);
+			t = -double(k)*k/(2*nrq);
+			A = log(v);
+			if ( A < (t - rho) ) return y;
+			if ( A > (t + rho) ) continue;
+
+			// final acceptance test using Stirling's formula
+			x1 = y+1;
+			f1 = m+1;
+			z = n+1-m;
+			w = n-y+1;
+			x2 = x1*x1;
+			f2 = f1*f1;
+			z2 = z*z;
+			w2 = w*w;
+			if ( A <= (xm*log(f1/x1)
+						+ (n-m+0.5)*log(z/w)
+						+ (y-m)*log(w*r/(x1*q))
+						+ (13680.-(462.-(132.-(99.-140./f2)/f2)/f2)/f2)/f1/166320.
+						+ (13680.-(462.-(132.-(99.-140./z2)/z2)/z2)/z2)/z/166320.
+						+ (13680.-(462.-(132.-(99.-140./x2)/x2)/x2)/x2)/x1/166320.
+						+ (13680.-(462.-(132.-(99.-140./w2)/w2)/w2)/w2)/w/166320.) )
+				return y;
+		}
+	}
 }
 
 double GammaRandom::draw ( void )
@@ -333,10 +533,18 @@ double BetaRandom::draw ( void )
 */
 }
 
-void setSeed(long int seedval){
-    unsigned long init[4]={0x123, 0x234, 0x345, 0x456}, length=4;
+void setSeed(long int seedval, PsiSeedMode mode){
+    unsigned long init[6]={0x123, 0x234, 0x345, 0x456, 0, 0}, length=4;
     unsigned long k;
 
+	if ( mode==SEED_HASH ) {
+		// init_by_array mixes every word of the key into the whole state
+		init[4] = uint64_t(seedval) & 0xffffffffUL;
+		init[5] = (uint64_t(seedval) >> 32) & 0xffffffffUL;
+		init_by_array(init, 6);
+		return;
+	}
+
     init_by_array(init, length);
 
 	for ( k = 0; k<seedval; k++ ) genrand_int32();
@@ -7,16 +7,53 @@
 
 #include <cstdlib>
 #include <cmath>
+#include <stdint.h>
 #include "errors.h"
 
+/** \brief random number engine with its own state
+ *
+ * All random numbers in psignifit are by default drawn from a single global Mersenne Twister. This is
+ * fine for serial code but makes it impossible to draw random numbers reproducibly from multiple threads.
+ * A PsiRandomEngine holds the complete state of a xoshiro256** generator. The period of the generator is
+ * 2^256-1 and jump() advances the state by 2^128 draws in constant time. Engines for different threads
+ * are therefore obtained by jumping: streams with different stream indices never overlap.
+ *
+ * An engine is not locked. Every thread needs an engine of its own.
+ */
+class PsiRandomEngine
+{
+	private:
+		uint64_t s[4];
+		uint64_t next ( void );
+	public:
+		PsiRandomEngine (
+			unsigned long seedval=0,              ///< seed of the generator
+			unsigned long stream=0                ///< index of the stream (the engine is jumped stream times after seeding)
+			);  ///< set up a generator
+		void seed ( unsigned long seedval );      ///< reset the state of the engine from a single number
+		void jump ( void );                       ///< advance the state by 2^128 draws
+		PsiRandomEngine split ( void );           ///< return an engine that continues the current stream and jump this engine to the next stream
+		uint32_t int32 ( void ) { return uint32_t ( next() >> 32 ); }  ///< draw a random integer on [0,0xffffffff]
+		double draw ( void ) { return ( next() >> 11 ) * (1.0/9007199254740992.0); } ///< draw a random number on [0,1) with 53 bit resolution
+};
 
+/** \brief base class for random number generators
+ *
+ * Random numbers are drawn from the global generator (see setSeed()) unless an engine is set using setEngine().
+ * The engine is borrowed: it is not copied or deleted by the random number generator and copies made
+ * by clone() draw from the same engine.
+ */
 class PsiRandom
 {
+	private:
+		PsiRandomEngine * engine;
 	public:
-		PsiRandom ( void ) {}
-		double rngcall ( void );
+		PsiRandom ( void ) : engine ( NULL ) {}
+		double rngcall ( void );                                                   ///< draw a uniform random number on [0,1)
 		virtual double draw ( void ) { throw NotImplementedError(); }
 		virtual PsiRandom * clone ( void ) const {throw NotImplementedError(); }
+		virtual void setEngine ( PsiRandomEngine * rngengine ) { engine = rngengine; } ///< draw from rngengine instead of the global generator (NULL restores the global generator)
+		PsiRandomEngine * getEngine ( void ) const { return engine; }            ///< engine that is used to draw random numbers (NULL means global generator)
 };
 
 class GaussRandom : public PsiRandom
@@ -30,9 +67,10 @@ class GaussRandom : public PsiRandom
 		double w;
 		double y;
 	public:
-		GaussRandom ( double mean=0, double standarddeviation=1 ) : mu ( mean ), sigma ( standarddeviation ), good ( false ) {}
+		GaussRandom ( double mean=0, double standarddeviation=1 ) : mu ( mean ), sigma ( standarddeviation ), good ( false ), x1 ( 0 ), x2 ( 0 ), w ( 0 ), y ( 0 ) {}
 		double draw ( void );              ///< draw a random number using box muller transform
 		PsiRandom * clone ( void ) const { return new GaussRandom(*this); }
+		void setEngine ( PsiRandomEngine * rngengine ) { PsiRandom::setEngine ( rngengine ); good = false; } ///< draw from rngengine (a number cached from the previous engine is discarded)
 };
 
 class UniformRandom : public PsiRandom
@@ -46,14 +84,24 @@ class UniformRandom : public PsiRandom
 		PsiRandom * clone ( void ) const { return new UniformRandom(*this); }
 };
 
+/** \brief binomial random numbers
+ *
+ * For n*min(p,1-p)<=30, numbers are drawn by inversion of the cumulative distribution function. Otherwise
+ * the BTPE algorithm by Kachitvichyanukul & Schmeiser (1988) is used. Both need a constant expected
+ * number of uniform random numbers per draw, independent of n.
+ *
+ * Kachitvichyanukul, V & Schmeiser, BW (1988): Binomial random variate generation. Communications of the ACM, 31(2), 216-222.
+ */
 class BinomialRandom : public PsiRandom
 {
 	private:
 		int n;
 		double p;
+		int inversion ( int n, double p );   ///< draw by inversion (for small n*p)
+		int btpe ( int n, double p );        ///< draw by triangle-parallelogram-exponential rejection (for p<=0.5)
 	public:
 		BinomialRandom ( int number, double probability ) : n(number), p(probability) {}
-		double draw ( void );
+		double draw ( void );              ///< draw a random number
 		void setprm ( int number, double probability ) { n = number; p = probability; }
 		PsiRandom * clone ( void ) const { return new BinomialRandom(*this); }
 };
@@ -68,6 +116,7 @@ class GammaRandom : public PsiRandom
 		GammaRandom ( double shape, double scale ) : k (shape), theta(scale), grng() {}
 		double draw ( void );              ///< draw a random number
 		PsiRandom * clone ( void ) const { return new GammaRandom(*this); }
+		void setEngine ( PsiRandomEngine * rngengine ) { PsiRandom::setEngine ( rngengine ); grng.setEngine ( rngengine ); }
 };
 
 class BetaRandom : public PsiRandom
@@ -81,9 +130,19 @@ class BetaRandom : public PsiRandom
 		BetaRandom ( double alpha, double beta ) : alpha(alpha), beta(beta), grnga (alpha, 1), grngb (beta, 1) {}
 		double draw ( void );              ///< draw a random number
 		PsiRandom * clone ( void ) const { return new BetaRandom(*this); }
+		void setEngine ( PsiRandomEngine * rngengine ) { PsiRandom::setEngine ( rngengine ); grnga.setEngine ( rngengine ); grngb.setEngine ( rngengine ); }
 };
 
 
-void setSeed(long int seedval);
+/** \brief ways to seed the global generator */
+enum PsiSeedMode {
+	SEED_SKIP,         ///< initialize from a fixed key and skip seedval numbers (reproduces the sequences of earlier versions, takes time linear in seedval)
+	SEED_HASH          ///< make seedval part of the initialization key (takes constant time)
+};
+
+void setSeed (
+		long int seedval,               ///< seed
+		PsiSeedMode mode=SEED_SKIP      ///< how the seed is turned into a state of the generator
+		); ///< seed the global generator
 
 #endif
@@ -27,6 +27,13 @@ double PsiLogistic::f ( double x ) const
 	return 1./(1.+exp(-x));
 }
 
+void PsiLogistic::f_batch ( const double * x, unsigned int n, double * out ) const
+{
+	unsigned int i;
+	for ( i=0; i<n; i++ )
+		out[i] = 1./(1.+exp(-x[i]));
+}
+
 double PsiLogistic::df ( double x ) const
 {
 	return f(x)*(1-f(x));
@@ -53,6 +60,13 @@ double PsiGauss::f ( double x ) const
 	return Phi(x);
 }
 
+void PsiGauss::f_batch ( const double * x, unsigned int n, double * out ) const
+{
+	unsigned int i;
+	for ( i=0; i<n; i++ )
+		out[i] = Phi(x[i]);
+}
+
 double PsiGauss::df ( double x ) const
 {
 	/*
@@ -109,6 +123,13 @@ double PsiGumbelL::f ( double x ) const
 	return 1-exp(-exp(x));
 }
 
+void PsiGumbelL::f_batch ( const double * x, unsigned int n, double * out ) const
+{
+	unsigned int i;
+	for ( i=0; i<n; i++ )
+		out[i] = 1-exp(-exp(x[i]));
+}
+
 double PsiGumbelL::df ( double x ) const
 {
 	/*
@@ -159,6 +180,13 @@ double PsiGumbelR::f ( double x ) const
 	return exp(-exp(-x));
 }
 
+void PsiGumbelR::f_batch ( const double * x, unsigned int n, double * out ) const
+{
+	unsigned int i;
+	for ( i=0; i<n; i++ )
+		out[i] = exp(-exp(-x[i]));
+}
+
 double PsiGumbelR::df ( double x ) const
 {
 	/*
@@ -202,6 +230,13 @@ double PsiCauchy::f ( double x ) const
 	return atan ( x )/M_PI + 0.5;
 }
 
+void PsiCauchy::f_batch ( const double * x, unsigned int n, double * out ) const
+{
+	unsigned int i;
+	for ( i=0; i<n; i++ )
+		out[i] = atan ( x[i] )/M_PI + 0.5;
+}
+
 double PsiCauchy::df ( double x ) const
 {
 	return 1./(M_PI*(1+x*x));
@@ -227,6 +262,13 @@ double PsiExponential::f ( double x ) const
 		return 1-exp ( -x );
 }
 
+void PsiExponential::f_batch ( const double * x, unsigned int n, double * out ) const
+{
+	unsigned int i;
+	for ( i=0; i<n; i++ )
+		out[i] = ( x[i]<0 ? 0 : 1-exp ( -x[i] ) );
+}
+
 double PsiExponential::df ( double x ) const
 {
 	if (x<0)
@@ -17,6 +17,7 @@ class PsiSigmoid
 		virtual double f   ( double x ) const { throw NotImplementedError(); }            ///< This should return the value of the sigmoid itself (between 0 and 1)
 		virtual double df  ( double x ) const { throw NotImplementedError(); }            ///< This should give the first derivative of the sigmoid
 		virtual double ddf ( double x ) const { throw NotImplementedError(); }            ///< This should give the second derivative of the sigmoid
+		virtual void   f_batch ( const double * x, unsigned int n, double * out ) const { for ( unsigned int i=0; i<n; i++ ) out[i] = f ( x[i] ); } ///< evaluate the sigmoid at n positions x (out may be the same as x)
 		virtual double inv ( double p ) const { throw NotImplementedError(); }            ///< This should give the inverse of the sigmoid (taking values between 0 and 1)
 		virtual int    getcode ( void ) const { throw NotImplementedError(); }            ///< return the sigmoid identifier
 		virtual PsiSigmoid * clone ( void ) const { throw NotImplementedError(); }				  ///< clone object by value
@@ -34,6 +35,7 @@ class PsiId : public PsiSigmoid
 {
 	public:
 		double f   ( double x ) const { return x; }
+		void   f_batch ( const double * x, unsigned int n, double * out ) const { for ( unsigned int i=0; i<n; i++ ) out[i] = x[i]; }
 		double df  ( double x ) const { return 1; }
 		double ddf ( double x ) const { return 0; }
 		double inv ( double x ) const { return x; }
@@ -56,6 +58,7 @@ class PsiLogistic : public PsiSigmoid
 		PsiLogistic ( void ) {}  ///< constructor
 		PsiLogistic ( const PsiLogistic& original) {}  ///< copy constructor
 		double f ( double x ) const;                 ///< value of the sigmoid at position x
+		void   f_batch ( const double * x, unsigned int n, double * out ) const; ///< value of the sigmoid at n positions x
 		double df ( double x ) const;                ///< derivative of the sigmoid at position x
 		double ddf ( double x ) const;               ///< second derivative of the sigmoid
 		double inv ( double p ) const { return log(p/(1-p)); }  ///< inverse of the sigmoid
@@ -78,6 +81,7 @@ class PsiGauss : public PsiSigmoid
 		PsiGauss ( void ) {} ///< constructor
 		PsiGauss ( const PsiGauss& original) {} ///< copy constructor
 		double f   ( double x ) const;                 ///< value of the sigmoid at x
+		void   f_batch ( const double * x, unsigned int n, double * out ) const; ///< value of the sigmoid at n positions x
 		double df  ( double x ) const;                 ///< derivative of the sigmoid at x
 		double ddf ( double x ) const;                 ///< second derivative of the sigmoid at x
 		double inv ( double p ) const;                 ///< inverse of the sigmoid
@@ -100,6 +104,7 @@ class PsiGumbelL : public PsiSigmoid
 		PsiGumbelL ( void ) {} ///< contructor
 		PsiGumbelL ( const PsiGumbelL& original ) {} ///< copy constructor
 		double f   ( double x ) const;              ///< returns the value of the gumbel cdf at position x
+		void   f_batch ( const double * x, unsigned int n, double * out ) const; ///< value of the sigmoid at n positions x
 		double df  ( double x ) const;              ///< returns the derivative of the gumbel cdf at position x
 		double ddf ( double x ) const;              ///< returns the 2nd derivative of the gumbel cdf at position x
 		double inv ( double p ) const;              ///< returns the inverse of the gumbel cdf at position p
@@ -122,6 +127,7 @@ class PsiGumbelR : public PsiSigmoid
 		PsiGumbelR ( void ) {} ///< constructor
 		PsiGumbelR ( const PsiGumbelR& original ) {} ///< copy constructor
 		double f   ( double x ) const;             ///< returns the value of the right skewed gumbel cdf at position x
+		void   f_batch ( const double * x, unsigned int n, double * out ) const; ///< value of the sigmoid at n positions x
 		double df  ( double x ) const;             ///< returns the derivative of the right skewed gumbel cdf at position x
 		double ddf ( double x ) const;             ///< returns the 2nd derivative of the right skewed gumbel cdf at position x
 		double inv ( double p ) const;             ///< returns the inverse of the right skewed gumbel cdf at position p
@@ -144,6 +150,7 @@ class PsiCauchy : public PsiSigmoid
 		PsiCauchy( void ) {}                 ///< constructor
 		PsiCauchy( const PsiCauchy& oiginal) {} ///< copy constructor
 		double f   ( double x ) const;             ///< returns the value of the cauchy cdf at position x
+		void   f_batch ( const double * x, unsigned int n, double * out ) const; ///< value of the sigmoid at n positions x
 		double df  ( double x ) const;             ///< returns the derivative of the cauchy cdf at position x
 		double ddf ( double x ) const;             ///< returns the 2nd derivative of the cauchy cdf at position x
 		double inv ( double p ) const;             ///< returns the inverse of the cauchy cdf at position x
@@ -167,6 +174,7 @@ class PsiExponential : public PsiSigmoid
 		PsiExponential( void ) {}                 ///< constructor
 		PsiExponential( const PsiExponential& oiginal) {} ///< copy constructor
 		double f   (double x ) const;              ///< returns the value of the exponential cdf at position x
+		void   f_batch ( const double * x, unsigned int n, double * out ) const; ///< value of the sigmoid at n positions x
 		double df  (double x ) const;              ///< returns the derivative of the exponential cdf at position x
 		double ddf (double x ) const;              ///< returns the 2nd derivative of the exponential cdf at position x
 		double inv (double p ) const throw(BadArgumentError);              ///< returns the return the inverse of the exponential cdf at position x
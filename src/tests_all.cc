@@ -4,6 +4,7 @@
  */
 #include <iostream>
 #include <cstdlib>
+#include <stdexcept>
 #include "psychometric.h"
 #include "mclist.h"
 #include "bootstrap.h"
@@ -11,8 +12,11 @@
 #include "mcmc.h"
 #include "getstart.h"
 #include "integrate.h"
+#include "mcfile.h"
+#include "parallel.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -21,6 +25,7 @@
 
 int PsychometricValues ( TestSuite* T ) {
 	int failures(0),i,j;
+	unsigned int z;
 	char message[40];
 	std::vector <double> x ( 6 );
 	std::vector <int>    n ( 6, 50 );
@@ -99,6 +104,54 @@ int PsychometricValues ( TestSuite* T ) {
 		prm1[i] -= 1e-5;
 		failures += T->isequal ( dl1[i], d, "PsychometricValues likelihood-1afc derivative", .05 );
 	}
+
+	// Test fused likelihood, gradient and hessian
+	H = new Matrix ( 4, 4 );
+	l = pmf->negllikeli_derivatives ( prm1, data, &dl1, H );
+	failures += T->isequal ( l, pmf->negllikeli ( prm1, data ), "PsychometricValues fused likelihood-1afc" );
+	dl = pmf->dlposterior ( prm1, data );
+	for ( i=0; i<4; i++ ) {
+		failures += T->isequal ( dl[i], pmf->dlposteri ( prm1, data, i ), "PsychometricValues posterior gradient-1afc" );
+		prm1[i] += 1e-9;
+		dl = pmf->dnegllikeli ( prm1, data );
+		prm1[i] -= 1e-9;
+		for ( j=0; j<4; j++ ) {
+			d = dl[j] - dl1[j];
+			d /= 1e-9;
+			failures += T->isequal ( (*H)(i,j), -d, "PsychometricValues fused likelihood-1afc Hessian", .1 );
+		}
+		dl = pmf->dlposterior ( prm1, data );
+	}
+	delete H;
+
+	// Leave-one-out posterior ratios from the block contributions
+	pmf->leaveoneout_logratios ( prm1, data, &dl );
+	PsiData reuseddata ( *data );
+	for ( z=0; z<data->getNblocks(); z++ ) {
+		PsiData reduceddata ( *data, z );
+		failures += T->isequal ( reduceddata.getNblocks(), data->getNblocks()-1, "PsychometricValues leave-one-out data" );
+		reuseddata.setLeaveOneOut ( *data, z );
+		failures += T->isequal ( pmf->negllikeli(prm1,&reuseddata), pmf->negllikeli(prm1,&reduceddata), "PsychometricValues leave-one-out data in place", 1e-12 );
+		failures += T->isequal ( dl[z], pmf->neglpost(prm1,data)-pmf->neglpost(prm1,&reduceddata), "PsychometricValues leave-one-out logratio-1afc", 1e-9 );
+	}
+
+	// Posterior and its gradient in one pass
+	PsiPrior * gaussprior = new GaussPrior ( 3, 2 );
+	PsiPrior * betaprior  = new BetaPrior ( 2, 20 );
+	pmf->setPrior ( 0, gaussprior );
+	pmf->setPrior ( 2, betaprior );
+	delete gaussprior;
+	delete betaprior;
+	l = pmf->neglpost_derivatives ( prm1, data, &dl1 );
+	failures += T->isequal ( l, pmf->neglpost ( prm1, data ), "PsychometricValues fused posterior-1afc", 1e-10 );
+	for ( i=0; i<4; i++ ) {
+		prm1[i] += 1e-6;
+		d = pmf->neglpost ( prm1, data );
+		prm1[i] -= 2e-6;
+		d -= pmf->neglpost ( prm1, data );
+		prm1[i] += 1e-6;
+		failures += T->isequal ( dl1[i], d/2e-6, "PsychometricValues fused posterior-1afc gradient", 1e-4 );
+	}
 	delete pmf;
 
 	pmf = new BetaPsychometric ( 2, core, sigmoid );
@@ -108,6 +161,11 @@ int PsychometricValues ( TestSuite* T ) {
 
 	// Observe, that beta likelihood can also be > 1 implying that both signs for log likelihood are possible
 	failures += T->isequal ( pmf->negllikeli(bprm,data), -11.3918, "PsychometricValues beta likelihood", 1e-4);
+	pmf->leaveoneout_logratios ( bprm, data, &dl );
+	for ( z=0; z<data->getNblocks(); z++ ) {
+		PsiData reduceddata ( *data, z );
+		failures += T->isequal ( dl[z], pmf->neglpost(bprm,data)-pmf->neglpost(bprm,&reduceddata), "PsychometricValues beta leave-one-out logratio", 1e-9 );
+	}
 
 	// Test likelihood gradient
 	dl = pmf->dnegllikeli ( bprm, data );
@@ -139,6 +197,38 @@ int PsychometricValues ( TestSuite* T ) {
 	failures += T->ismore ( pmf->deviance ( bprm, data ), 0, "Psychometric Values beta deviance" );
 	delete pmf;
 
+	// The outlier model has its own derivative for the outlier probability
+	pmf = new OutlierModel ( 2, core, sigmoid, 2 );
+	bprm[3] = .7;
+	H = new Matrix ( 4, 4 );
+	l = pmf->negllikeli_derivatives ( bprm, data, &dl1, H );
+	failures += T->isequal ( l, pmf->negllikeli ( bprm, data ), "PsychometricValues outlier fused likelihood", 1e-10 );
+	for ( i=0; i<4; i++ ) {
+		bprm[i] += 1e-6;
+		d = pmf->negllikeli ( bprm, data );
+		pmf->negllikeli_derivatives ( bprm, data, &dl, NULL );
+		bprm[i] -= 2e-6;
+		d -= pmf->negllikeli ( bprm, data );
+		pmf->negllikeli_derivatives ( bprm, data, &prm1, NULL );
+		bprm[i] += 1e-6;
+		failures += T->isequal ( dl1[i], d/2e-6, "PsychometricValues outlier likelihood derivative", 1e-4 );
+		for ( j=0; j<4; j++ )
+			failures += T->isequal ( (*H)(i,j), -(dl[j]-prm1[j])/2e-6, "PsychometricValues outlier likelihood Hessian", 1e-3 );
+	}
+	delete H;
+
+	// Close to the upper bound of the outlier probability, the numerical gradient must not leave the support (the one
+	// sided difference is coarse this close to the bound, but it must not pick up the penalty outside the support)
+	bprm[3] = .9995;
+	pmf->neglpost_derivatives ( bprm, data, &dl );
+	bprm[3] += 1e-7;
+	d = pmf->neglpost ( bprm, data );
+	bprm[3] -= 2e-7;
+	d -= pmf->neglpost ( bprm, data );
+	bprm[3] += 1e-7;
+	failures += T->isequal_rel ( dl[3], d/2e-7, "PsychometricValues outlier posterior gradient at the bound of the support", .5 );
+	delete pmf;
+
 	delete core;
 	delete sigmoid;
 	delete data;
@@ -382,6 +472,41 @@ int OptimizerSolution ( TestSuite * T ) {
 	failures += T->isequal(pmf->getRpd(devianceresiduals,solution,data),0.155395,"OptimizerSolution 2AFC Rpd",1e-2);
 	failures += T->isequal(pmf->getRkd(devianceresiduals,data),-0.320889,"OptimizerSolution 2AFC Rkd",1e-2);
 
+	// Newton method should reach the same optimum with fewer evaluations
+	PsiOptimizer *newtonopt = new PsiOptimizer ( pmf, data, OPTIMIZER_NEWTON );
+	std::vector<double> newtonsolution ( newtonopt->optimize(pmf,data) );
+	failures += T->isequal(newtonsolution[0],solution[0],"OptimizerSolution 2AFC Newton alpha",1e-2);
+	failures += T->isequal(newtonsolution[1],solution[1],"OptimizerSolution 2AFC Newton beta",1e-2);
+	failures += T->isequal(newtonsolution[2],solution[2],"OptimizerSolution 2AFC Newton lambda",1e-3);
+	failures += T->isless(pmf->neglpost(newtonsolution,data),pmf->neglpost(solution,data)+1e-6,"OptimizerSolution 2AFC Newton posterior");
+	failures += T->isless(newtonopt->getNevaluations(),opt->getNevaluations(),"OptimizerSolution 2AFC Newton evaluations");
+	delete newtonopt;
+
+	// nu of the beta model is not a rate and must not be kept in (0,1) like one
+	PsiPsychometric * xpmf = new BetaPsychometric ( 2, core, sigmoid );
+	xpmf->setPrior ( 2, prior );
+	PsiOptimizer xopt ( xpmf, data );
+	PsiOptimizer xnewtonopt ( xpmf, data, OPTIMIZER_NEWTON );
+	solution = xopt.optimize ( xpmf, data );
+	newtonsolution = xnewtonopt.optimize ( xpmf, data );
+	failures += T->isless ( xpmf->neglpost(newtonsolution,data), xpmf->neglpost(solution,data)+1e-3, "OptimizerSolution 2AFC beta model Newton posterior" );
+	delete xpmf;
+
+	// With a narrow prior, the optimum of lambda sits at the bound of the prior. Newton has to converge there by itself,
+	// falling back to the simplex would cost more evaluations than the simplex alone
+	PsiPsychometric * bpmf = new PsiPsychometric ( 2, core, sigmoid );
+	PsiPrior * narrowprior = new UniformPrior ( 0., 0.01 );
+	bpmf->setPrior ( 2, narrowprior );
+	PsiOptimizer bopt ( bpmf, data );
+	PsiOptimizer bnewtonopt ( bpmf, data, OPTIMIZER_NEWTON );
+	solution = bopt.optimize ( bpmf, data );
+	newtonsolution = bnewtonopt.optimize ( bpmf, data );
+	failures += T->isequal ( newtonsolution[2], 0.01, "OptimizerSolution 2AFC Newton lambda at the prior bound", 1e-6 );
+	failures += T->isless ( bpmf->neglpost(newtonsolution,data), bpmf->neglpost(solution,data)+1e-6, "OptimizerSolution 2AFC Newton posterior at the prior bound" );
+	failures += T->isless ( bnewtonopt.getNevaluations(), bopt.getNevaluations(), "OptimizerSolution 2AFC Newton evaluations at the prior bound" );
+	delete narrowprior;
+	delete bpmf;
+
 	delete pmf;
 	delete data;
 	delete opt;
@@ -426,6 +551,16 @@ int OptimizerSolution ( TestSuite * T ) {
 	failures += T->isequal(pmf->getRpd(devianceresiduals,solution,data),0.217146,"OptimizerSolution Y/N Rpd",1e-2);
 	failures += T->isequal(pmf->getRkd(devianceresiduals,data),-0.477967,"OptimizerSolution Y/N Rkd",2e-2);
 
+	newtonopt = new PsiOptimizer ( pmf, data, OPTIMIZER_NEWTON );
+	newtonsolution = newtonopt->optimize(pmf,data);
+	failures += T->isequal(newtonsolution[0],solution[0],"OptimizerSolution Y/N Newton alpha",1e-2);
+	failures += T->isequal(newtonsolution[1],solution[1],"OptimizerSolution Y/N Newton beta",5*1e-3);
+	failures += T->isequal(newtonsolution[2],solution[2],"OptimizerSolution Y/N Newton lambda",5*1e-3);
+	failures += T->isequal(newtonsolution[3],solution[3],"OptimizerSolution Y/N Newton gamma",5*1e-3);
+	failures += T->isless(pmf->neglpost(newtonsolution,data),pmf->neglpost(solution,data)+1e-6,"OptimizerSolution Y/N Newton posterior");
+	failures += T->isless(newtonopt->getNevaluations(),opt->getNevaluations(),"OptimizerSolution Y/N Newton evaluations");
+	delete newtonopt;
+
 	delete pmf;
 	delete opt;
 
@@ -517,24 +652,44 @@ int BootstrapTest ( TestSuite * T ) {
 	std::vector<double> cuts (1, 0.5);
 	// BootstrapList boots = bootstrap ( 9999, data, pmf, cuts );
 	BootstrapList boots = bootstrap ( 999, data, pmf, cuts );
+	std::vector<double> firstsample ( boots.getEst ( 0 ) );
+	double firstthres ( boots.getThres_byPos ( 0, 0 ) ), firstslope ( boots.getSlope_byPos ( 0, 0 ) );
+	double firstdeviance ( boots.getdeviance ( 0 ) ), firstRpd ( boots.getRpd ( 0 ) );
 
-	// Check against psignifit results
+	// Check against the realisation for seed 0 (the values depend on the stream of the binomial sampler)
 	// These values are subject to statistical variation. "equality" is defined relatively coarse
 	failures += T->isless(boots.getAcc_t(0),     0.018662,"Acceleration constant (threshold)");
-	failures += T->isequal(boots.getBias_t(0), -0.0928786,"Bias (threshold)",            .05);
-	failures += T->isequal(boots.getThres(.1,0), 2.65266,"th(.1)",                        .05);
-	failures += T->isequal(boots.getThres(.9,0), 3.89757,"th(.9)",                        .05);
-
-	failures += T->isequal(boots.getAcc_s(0),    -0.000155314, "Acceleration constant (slope)", .01);
-	failures += T->isequal(boots.getBias_s(0),    -0.0351,   "Bias (slope)",                  .01);
-	failures += T->isequal(boots.getSlope(0.1,0), 0.181289,    "sl(.1)",                        .01);
-	failures += T->isequal(boots.getSlope(0.9,0), 0.497512,    "sl(.9)",                        .01);
+	failures += T->isequal(boots.getBias_t(0),  0.0250689,"Bias (threshold)",            .05);
+	failures += T->isequal(boots.getThres(.1,0), 2.74953,"th(.1)",                        .05);
+	failures += T->isequal(boots.getThres(.9,0), 3.93231,"th(.9)",                        .05);
+
+	failures += T->isequal(boots.getAcc_s(0),     0.00561302, "Acceleration constant (slope)", .01);
+	failures += T->isequal(boots.getBias_s(0),    -0.161119, "Bias (slope)",                  .01);
+	failures += T->isequal(boots.getSlope(0.1,0), 0.162453,    "sl(.1)",                        .01);
+	failures += T->isequal(boots.getSlope(0.9,0), 0.390016,    "sl(.9)",                        .01);
+
+	failures += T->isequal(boots.getDeviancePercentile(0.975),10.7995,"Deviance limits",.5);
+	failures += T->isequal(boots.percRpd(.025), -0.52495, "Rpd( 2.5%)", .1); // Testing mean and standard error
+	failures += T->isequal(boots.percRpd(.975), 0.637794, "Rpd(97.5%)",  .1);
+	failures += T->isequal(boots.percRkd(.025), -0.920136, "Rkd( 2.5%)", .1);
+	failures += T->isequal(boots.percRkd(.975), 0.599145, "Rkd(97.5%)",  .1);
+
+	// Independent of the particular realisation: the bootstrap distributions of threshold and deviance have to agree with
+	// those of the earlier one-uniform-per-trial binomial sampler (seed 2) within 4 Monte Carlo standard errors
+	double mean_t(0), sd_t(0), mean_D(0), sd_D(0);
+	for ( i=0; i<999; i++ ) {
+		mean_t += boots.getThres_byPos ( i, 0 ); sd_t += boots.getThres_byPos ( i, 0 )*boots.getThres_byPos ( i, 0 );
+		mean_D += boots.getdeviance ( i );       sd_D += boots.getdeviance ( i )*boots.getdeviance ( i );
+	}
+	mean_t /= 999; sd_t = sqrt ( sd_t/999 - mean_t*mean_t );
+	mean_D /= 999; sd_D = sqrt ( sd_D/999 - mean_D*mean_D );
+	failures += T->isequal ( mean_t, 3.31374,  "Bootstrap threshold mean agrees with the old sampler",      4*sd_t/sqrt(999.) );
+	failures += T->isequal ( sd_t,   0.453358, "Bootstrap threshold sd agrees with the old sampler",        4*sd_t/sqrt(2*999.) );
+	failures += T->isequal ( mean_D, 3.46486,  "Bootstrap deviance mean agrees with the old sampler",       4*sd_D/sqrt(999.) );
 
-	failures += T->isequal(boots.getDeviancePercentile(0.975),9.67016,"Deviance limits",.5);
-	failures += T->isequal(boots.percRpd(.025), -0.451653, "Rpd( 2.5%)", .1); // Testing mean and standard error
-	failures += T->isequal(boots.percRpd(.975), 0.632072, "Rpd(97.5%)",  .1);
-	failures += T->isequal(boots.percRkd(.025), -0.932597, "Rkd( 2.5%)", .1);
-	failures += T->isequal(boots.percRkd(.975), 0.601175, "Rkd(97.5%)",  .1);
+	// Percentiles leave the samples in order
+	failures += T->conditional ( boots.getEst(0)==firstsample && boots.getThres_byPos(0,0)==firstthres && boots.getSlope_byPos(0,0)==firstslope
+			&& boots.getdeviance(0)==firstdeviance && boots.getRpd(0)==firstRpd, "Percentiles keep sample order" );
 
 	// Check for influential observations and outliers
 	JackKnifeList jackknife = jackknifedata (data, pmf);
@@ -552,6 +707,99 @@ int BootstrapTest ( TestSuite * T ) {
 		failures += T->conditional(!jackknife.outlier(i),testname);
 	}
 
+	// Refits from the reference solution should agree with cold fits of the reduced data
+	PsiRefitContext refitter ( pmf, data );
+	std::vector<double> xr ( 5 ), refit, coldfit;
+	std::vector<int>    nr ( 5, 50 ), kr ( 5 );
+	for ( i=0; i<5; i++ ) { xr[i] = x[i+1]; kr[i] = k[i+1]; }
+	PsiData reduceddata ( xr, nr, kr, 2 );
+	PsiOptimizer coldopt ( pmf, &reduceddata );
+	coldfit = coldopt.optimize ( pmf, &reduceddata );
+	refit = refitter.refit ( 0 );
+	failures += T->isequal ( refitter.getData()->getNblocks(), 5, "Refit excluded block" );
+	failures += T->isequal ( pmf->neglpost(refit,&reduceddata), pmf->neglpost(coldfit,&reduceddata), "Refit excluded block posterior", 1e-3 );
+	failures += T->isless ( refitter.getOptimizer().getNevaluations(), coldopt.getNevaluations(), "Refit excluded block evaluations" );
+	for ( i=0; i<6; i++ ) {
+		refit = refitter.refit ( i );
+		failures += T->isequal ( refit[0], jackknife.getEst(i,0), "Refit equals jackknife", 1e-10 );
+	}
+
+	// A reference solution without step sizes gets them from the curvature, a short one is rejected
+	std::vector<double> reference ( refitter.getReference() );
+	PsiRefitContext plainrefitter ( pmf, data, &reference );
+	failures += T->isequal ( plainrefitter.getStart().size(), 2*pmf->getNparams(), "Refit plain reference step sizes" );
+	for ( i=0; i<pmf->getNparams(); i++ )
+		failures += T->isequal ( plainrefitter.getStart()[i+pmf->getNparams()], refitter.getStart()[i+pmf->getNparams()], "Refit plain reference step size", 1e-6 );
+	reference.resize ( 2 );
+	try {
+		PsiRefitContext shortrefitter ( pmf, data, &reference );
+		failures += T->conditional ( false, "Refit short reference rejected" );
+	} catch ( BadArgumentError& ) {
+		failures += T->conditional ( true, "Refit short reference rejected" );
+	}
+
+	delete core;
+	delete sigmoid;
+	delete prior;
+	delete pmf;
+	delete data;
+
+	return failures;
+}
+
+int ParallelBootstrapTest ( TestSuite * T ) {
+	int failures(0);
+	unsigned int i,j;
+	bool equal;
+	std::vector<double> x ( 6 );
+	std::vector<int>    n ( 6, 50 );
+	std::vector<int>    k ( 6 );
+
+	// Set up data
+	x[0] =  0.; x[1] =  2.; x[2] =  4.; x[3] =  6.; x[4] =  8.; x[5] = 10.;
+	k[0] = 24;  k[1] = 32;  k[2] = 40;  k[3] = 48;  k[4] = 50;  k[5] = 48;
+	PsiData * data = new PsiData (x,n,k,2);
+
+	// Set up psychometric function
+	abCore * core = new abCore();
+	PsiLogistic * sigmoid = new PsiLogistic();
+	PsiPrior * prior = new UniformPrior ( 0, .1 );
+	PsiPsychometric * pmf = new PsiPsychometric ( 2, core, sigmoid );
+	pmf->setPrior( 2, prior );
+	std::vector<double> cuts (1, 0.5);
+
+	// The same seed has to give the same bootstrap list for any number of threads
+	setSeed ( 0 );
+	BootstrapList serial   = bootstrap ( 200, data, pmf, cuts, NULL, true, true, 1 );
+	setSeed ( 0 );
+	BootstrapList parallel = bootstrap ( 200, data, pmf, cuts, NULL, true, true, 4 );
+
+	equal = true;
+	for ( i=0; i<200; i++ ) {
+		for ( j=0; j<pmf->getNparams(); j++ )
+			equal = equal && serial.getEst ( i, j )==parallel.getEst ( i, j );
+		equal = equal && serial.getdeviance ( i )==parallel.getdeviance ( i );
+		equal = equal && ( serial.getRpd ( i )==parallel.getRpd ( i ) || serial.getRpd ( i )!=serial.getRpd ( i ) ); // Rpd can be nan
+		equal = equal && serial.getThres_byPos ( i, 0 )==parallel.getThres_byPos ( i, 0 );
+		equal = equal && serial.getData ( i )==parallel.getData ( i );
+	}
+	failures += T->conditional ( equal, "samples independent of number of threads" );
+	failures += T->conditional ( serial.getBias_t(0)==parallel.getBias_t(0), "bias independent of number of threads" );
+	failures += T->conditional ( serial.getAcc_t(0)==parallel.getAcc_t(0),   "acceleration independent of number of threads" );
+
+	// With an engine of its own, the bootstrap does not touch the global generator
+	PsiRandomEngine engine1 ( 5 ), engine2 ( 5 );
+	setSeed ( 0 );
+	BootstrapList own1 = bootstrap ( 50, data, pmf, cuts, NULL, true, true, 1, OPTIMIZER_SIMPLEX, &engine1 );
+	double next ( PsiRandom().rngcall() );
+	setSeed ( 0 );
+	BootstrapList own2 = bootstrap ( 50, data, pmf, cuts, NULL, true, true, 2, OPTIMIZER_SIMPLEX, &engine2 );
+	equal = next==PsiRandom().rngcall();
+	for ( i=0; i<50; i++ )
+		equal = equal && own1.getData ( i )==own2.getData ( i ) && own1.getEst ( i, 0 )==own2.getEst ( i, 0 );
+	failures += T->conditional ( equal, "samples from own engine" );
+	failures += T->conditional ( own1.getData ( 0 )!=serial.getData ( 0 ) || own1.getData ( 1 )!=serial.getData ( 1 ), "own engine differs from global generator" );
+
 	delete core;
 	delete sigmoid;
 	delete prior;
@@ -591,6 +839,8 @@ int MCMCTest ( TestSuite * T ) {
 	GenericMetropolis * gmS = new GenericMetropolis ( pmf, data, new GaussRandom() );
 	gmS->setTheta ( prm );
 
+	setSeed ( 0, SEED_HASH );      // do not depend on the random numbers used by previous tests
+
 	/* // We don't use HybridMCMC anywhere
 	HybridMCMC * S = new HybridMCMC ( pmf, data, 20 );
 	S->setTheta ( prm );
@@ -643,6 +893,667 @@ int MCMCTest ( TestSuite * T ) {
 	return failures;
 }
 
+int MultiChainTest ( TestSuite * T ) {
+	int failures ( 0 );
+	unsigned int i,j,k;
+	bool equal;
+	std::vector<double> x ( 6 );
+	std::vector<int>    n ( 6, 50 );
+	std::vector<int>    kc ( 6 );
+
+	// Set up data
+	x[0] =  0.; x[1] =  2.; x[2] =  4.; x[3] =  6.; x[4] =  8.; x[5] = 10.;
+	kc[0] = 24; kc[1] = 32; kc[2] = 40; kc[3] = 48; kc[4] = 50; kc[5] = 48;
+	PsiData * data = new PsiData (x,n,kc,2);
+
+	// Set up psychometric function
+	PsiCore * core = new abCore ();
+	PsiSigmoid * sigmoid = new PsiLogistic();
+	PsiPsychometric * pmf = new PsiPsychometric ( 2, core, sigmoid );
+	PsiPrior * prior = new GaussPrior ( 4, 2 );
+	pmf->setPrior ( 0, prior );
+	delete prior;
+	prior = new GammaPrior ( 2, 1 );
+	pmf->setPrior ( 1, prior );
+	delete prior;
+	prior = new UniformPrior ( 0, .1 );
+	pmf->setPrior ( 2, prior );
+	delete prior;
+
+	MetropolisHastings * S = new MetropolisHastings ( pmf, data, new GaussRandom() );
+	S->setStepSize ( 0.3, 0 );
+	S->setStepSize ( 0.3, 1 );
+	S->setStepSize ( 0.01, 2 );
+
+	MultiChainMCMC serial   ( S, 4, 3 );
+	MultiChainMCMC parallel ( S, 4, 3 );
+	MCMCList serialpost   ( serial.sample ( 1000, 1 ) );
+	MCMCList parallelpost ( parallel.sample ( 1000, 4 ) );
+
+	failures += T->conditional ( serialpost.getNsamples()==4000, "combined list contains all chains" );
+
+	// Chains do not depend on the number of threads and the combined list contains the chains in order
+	equal = true;
+	for ( k=0; k<4; k++ ) {
+		for ( i=0; i<1000; i++ ) {
+			for ( j=0; j<3; j++ ) {
+				equal = equal && serialpost.getEst ( k*1000+i, j )==parallelpost.getEst ( k*1000+i, j );
+				equal = equal && serial.getChain ( k ).getEst ( i, j )==serialpost.getEst ( k*1000+i, j );
+			}
+			equal = equal && serialpost.getppData ( k*1000+i )==parallelpost.getppData ( k*1000+i );
+		}
+	}
+	failures += T->conditional ( equal, "chains independent of number of threads" );
+	failures += T->conditional ( serial.getChain(0).getEst(0,0)!=serial.getChain(1).getEst(0,0), "chains start at different points" );
+
+	// Views into the sample store agree with the element accessors
+	std::vector<double> est ( 3 );
+	serialpost.copyEst ( 1234, &est );
+	equal = true;
+	for ( j=0; j<3; j++ ) {
+		equal = equal && est[j]==serialpost.getEst ( 1234, j ) && serialpost.getColumn ( j )[1234]==est[j];
+	}
+	for ( j=0; j<6; j++ ) {
+		equal = equal && serialpost.getppDataRow ( 1234 )[j]==serialpost.getppData ( 1234, j );
+		equal = equal && serialpost.getlogratioRow ( 1234 )[j]==serialpost.getlogratio ( 1234, j );
+	}
+	failures += T->conditional ( equal, "sample store views" );
+
+	for ( j=0; j<3; j++ ) {
+		failures += T->conditional ( serial.getRhat ( j )>0.99 && serial.getRhat ( j )<1.1, "split-Rhat close to 1" );
+		failures += T->conditional ( serial.getNeff ( j )>40 && serial.getNeff ( j )<=4000, "effective sample size" );
+	}
+	failures += T->isequal ( serialpost.getMean(0), 3.22372, "multiple chains alpha", .2 );
+	failures += T->isequal ( serialpost.getMean(1), 1.12734, "multiple chains beta", .2 );
+
+	// Diagnostics can be skipped while sampling and computed afterwards on several threads
+	MetropolisHastings * Snodiag = new MetropolisHastings ( *S );
+	PsiRandomEngine diagengine ( 5 ), diagengine1 ( 11 ), diagengine4 ( 11 );
+	Snodiag->setEngine ( &diagengine );
+	Snodiag->setDiagnostics ( false );
+	MCMCList nodiag ( Snodiag->sample ( 200 ) );
+	MCMCList withdiag ( nodiag );
+	equal = true;
+	for ( i=0; i<200; i++ )
+		equal = equal && nodiag.getppDeviance ( i )==0 && nodiag.getRpd ( i )==0 && nodiag.getlogratio ( i, 0 )==0;
+	failures += T->conditional ( equal, "diagnostics are skipped" );
+	sample_diagnostics ( pmf, data, &nodiag, 1, &diagengine1 );
+	sample_diagnostics ( pmf, data, &withdiag, 4, &diagengine4 );
+	equal = true;
+	for ( i=0; i<200; i++ ) {
+		equal = equal && nodiag.getppData ( i )==withdiag.getppData ( i ) && nodiag.getppDeviance ( i )==withdiag.getppDeviance ( i );
+		equal = equal && nodiag.getRkd ( i )==withdiag.getRkd ( i ) && nodiag.getlogratio ( i, 3 )==withdiag.getlogratio ( i, 3 );
+	}
+	failures += T->conditional ( equal, "diagnostics independent of number of threads" );
+	failures += T->conditional ( nodiag.getppDeviance ( 0 )>0, "diagnostics are computed afterwards" );
+	delete Snodiag;
+
+	// Adaptive metropolis learns the correlation of a and b without a pilot sample
+	PsiRandomEngine adaptengine ( 7 );
+	AdaptiveMetropolis * A = new AdaptiveMetropolis ( pmf, data, new GaussRandom(), 2000 );
+	A->setEngine ( &adaptengine );
+	A->setTheta ( S->getTheta() );
+	A->setDiagnostics ( false );
+	MCMCList adaptive ( A->sample ( 2000 ) );
+	failures += T->conditional ( !A->adapting(), "adaptation phase is finished" );
+	failures += T->conditional ( adaptive.get_accept_rate()>0.15 && adaptive.get_accept_rate()<0.35, "adaptive metropolis reaches target acceptance rate" );
+	failures += T->conditional ( A->getCovariance ( 0, 1 )!=0 && A->getCovariance ( 0, 1 )==A->getCovariance ( 1, 0 ), "adaptive metropolis learns covariance" );
+	failures += T->isequal ( adaptive.getMean(0), 3.22372, "adaptive metropolis alpha", .2 );
+	failures += T->isequal ( adaptive.getMean(1), 1.12734, "adaptive metropolis beta", .2 );
+
+	// No-U-Turn sampler adapts its stepsize and gets more effective samples per posterior evaluation
+	PsiRandomEngine nutsengine ( 7 );
+	NoUTurnSampler * U = new NoUTurnSampler ( pmf, data, 500 );
+	U->setEngine ( &nutsengine );
+	U->setDiagnostics ( false );
+	MCMCList nuts ( U->sample ( 1000 ) );
+	failures += T->conditional ( !U->adapting() && U->getLeapfrogStepSize()>0, "No-U-Turn adaptation phase is finished" );
+	failures += T->conditional ( nuts.get_accept_rate()>0.6 && nuts.get_accept_rate()<0.95, "No-U-Turn reaches target acceptance statistic" );
+	failures += T->isequal ( nuts.getMean(0), 3.22372, "No-U-Turn alpha", .2 );
+	failures += T->isequal ( nuts.getMean(1), 1.12734, "No-U-Turn beta", .2 );
+	std::vector< std::vector<double> > nutsdraws ( 1, std::vector<double> ( nuts.getColumn ( 0 ), nuts.getColumn ( 0 )+1000 ) );
+	std::vector< std::vector<double> > adaptivedraws ( 1, std::vector<double> ( adaptive.getColumn ( 0 ), adaptive.getColumn ( 0 )+2000 ) );
+	failures += T->conditional ( effectiveSampleSize ( nutsdraws )/U->getNgradients() > effectiveSampleSize ( adaptivedraws )/4000,
+			"No-U-Turn effective samples per posterior evaluation" );
+	delete U;
+	delete A;
+
+	// Split-Rhat detects chains that sample different distributions
+	std::vector< std::vector<double> > draws ( 2, std::vector<double> ( 100 ) );
+	for ( i=0; i<100; i++ ) {
+		draws[0][i] = sin ( double(i) );
+		draws[1][i] = sin ( double(i) ) + 3;
+	}
+	failures += T->conditional ( splitRhat ( draws )>2, "split-Rhat of separated chains" );
+	for ( i=0; i<100; i++ )
+		draws[1][i] = cos ( double(i) );
+	failures += T->conditional ( splitRhat ( draws )<1.05, "split-Rhat of mixed chains" );
+
+	delete S;
+	delete pmf;
+	delete core;
+	delete sigmoid;
+	delete data;
+
+	return failures;
+}
+
+int ConvergenceTest ( TestSuite * T ) {
+	int failures ( 0 );
+	unsigned int i, t, N ( 8000 );
+	double d;
+	bool equal;
+	PsiRandomEngine engine ( 13 );
+	GaussRandom noise;
+	noise.setEngine ( &engine );
+
+	// Autocovariances from the fourier transform agree with the direct sums
+	std::vector<double> x ( 50 ), acov;
+	for ( i=0; i<50; i++ )
+		x[i] = sin ( 0.3*i ) + noise.draw();
+	autocovariance ( &(x[0]), 50, &acov );
+	double m ( 0 );
+	for ( i=0; i<50; i++ )
+		m += x[i]/50;
+	equal = true;
+	for ( t=0; t<50; t++ ) {
+		d = 0;
+		for ( i=0; i+t<50; i++ )
+			d += (x[i]-m)*(x[i+t]-m);
+		equal = equal && fabs ( d/50-acov[t] )<1e-10;
+	}
+	failures += T->conditional ( equal, "FFT autocovariance" );
+
+	// Two chains of an autoregressive process with known autocorrelation 0.5^lag
+	MCMCList samples ( N, 3, 6 );
+	std::vector<double> est ( 3 );
+	double ar ( 0 ), ar2 ( 0 );
+	for ( i=0; i<N; i++ ) {
+		if ( i==N/2 )
+			ar = ar2 = 0;
+		ar  = 0.5*ar  + noise.draw();
+		ar2 = 0.9*ar2 + noise.draw();
+		est[0] = 3 + ar;
+		est[1] = 1 + 0.1*ar2;
+		est[2] = 0.02;
+		samples.setEst ( i, est, 0. );
+	}
+
+	PsiPsychometric * pmf = new PsiPsychometric ( 2, new abCore(), new PsiLogistic() );
+	std::vector<double> cuts ( 1, 0.5 );
+	PsiChainDiagnostics diag ( samples, 2, 20, pmf, cuts );
+
+	failures += T->isequal ( diag.getNvariables(), 4, "Convergence diagnostics number of variables" );
+	failures += T->isequal ( diag.getAutocorrelation ( 0, 0 ), 1, "Convergence diagnostics autocorrelation at lag 0", 1e-10 );
+	failures += T->isequal ( diag.getAutocorrelation ( 0, 1 ), 0.5, "Convergence diagnostics autocorrelation at lag 1", .05 );
+	failures += T->isequal ( diag.getAutocorrelation ( 1, 1 ), 0.9, "Convergence diagnostics autocorrelation at lag 1 (slow chain)", .05 );
+	failures += T->isequal ( diag.getESS ( 0 )/N, 1./3, "Convergence diagnostics effective sample size", .05 );
+	failures += T->isequal ( diag.getESS ( 1 )/N, 0.1/1.9, "Convergence diagnostics effective sample size (slow chain)", .02 );
+	failures += T->conditional ( diag.getBulkESS ( 0 )>0.8*diag.getESS ( 0 ) && diag.getBulkESS ( 0 )<1.2*diag.getESS ( 0 ), "Convergence diagnostics bulk effective sample size" );
+	failures += T->conditional ( diag.getTailESS ( 0 )>0 && diag.getTailESS ( 1 )<diag.getTailESS ( 0 ), "Convergence diagnostics tail effective sample size" );
+	failures += T->isequal ( diag.getMCSE ( 0 ), diag.getStd ( 0 )/sqrt ( diag.getESS ( 0 ) ), "Convergence diagnostics monte carlo standard error", 1e-10 );
+	failures += T->conditional ( fabs ( diag.getGeweke ( 0, 0 ) )<3 && fabs ( diag.getGeweke ( 0, 1 ) )<3, "Convergence diagnostics Geweke z-score of a stationary chain" );
+	failures += T->isequal ( diag.getESS ( 3 ), diag.getESS ( 0 ), "Convergence diagnostics of thresholds", 1e-6 );
+	failures += T->isequal ( diag.getESS ( 2 ), N, "Convergence diagnostics of a constant" );
+
+	// A drifting chain is detected
+	std::vector<double> drift ( 1000 );
+	for ( i=0; i<1000; i++ )
+		drift[i] = 0.005*i + noise.draw();
+	i = diag.addVariable ( drift );
+	failures += T->isequal ( i, 4, "Convergence diagnostics added variable" );
+	failures += T->conditional ( fabs ( diag.getGeweke ( 4, 0 ) )>3 && fabs ( diag.getGeweke ( 4, 1 ) )>3, "Convergence diagnostics Geweke z-score of a drifting chain" );
+
+	delete pmf;
+
+	return failures;
+}
+
+int PrecisionTargetTest ( TestSuite * T ) {
+	int failures ( 0 );
+	std::vector<double> x ( 6 );
+	std::vector<int>    n ( 6, 50 );
+	std::vector<int>    kc ( 6 );
+	std::vector<double> cuts ( 1, 0.5 );
+	std::vector<double> start ( 3 );
+
+	x[0] =  0.; x[1] =  2.; x[2] =  4.; x[3] =  6.; x[4] =  8.; x[5] = 10.;
+	kc[0] = 24; kc[1] = 32; kc[2] = 40; kc[3] = 48; kc[4] = 50; kc[5] = 48;
+	PsiData * data = new PsiData (x,n,kc,2);
+	PsiPsychometric * pmf = new PsiPsychometric ( 2, new abCore(), new PsiLogistic() );
+	PsiPrior * prior = new UniformPrior ( 0, .1 );
+	pmf->setPrior ( 2, prior );
+	delete prior;
+
+	PsiRandomEngine engine ( 7 );
+	GaussRandom proposal;
+	MetropolisHastings S ( pmf, data, &proposal );
+	S.setEngine ( &engine );
+	S.setStepSize ( 0.3, 0 );
+	S.setStepSize ( 0.3, 1 );
+	S.setStepSize ( 0.01, 2 );
+	start[0] = 3; start[1] = 1.5; start[2] = 0.02;
+	S.setTheta ( start );
+
+	// An easy target stops after a few chunks
+	PsiChainDiagnostics diag;
+	MCMCList post ( S.sampleToPrecision ( 100, 0, cuts, 500, 20000, &diag ) );
+	failures += T->conditional ( post.getNsamples()<20000 && post.getNsamples()%500==0, "Precision target stops early" );
+	failures += T->isequal ( diag.getNvariables(), 4, "Precision target diagnostics of parameters and thresholds" );
+	failures += T->conditional ( diag.getESS(0)>=100 && diag.getESS(1)>=100 && diag.getESS(2)>=100, "Precision target effective sample size reached" );
+	failures += T->isequal ( post.getppDeviance ( post.getNsamples()-1 )>0, 1, "Precision target computes sample diagnostics" );
+
+	// A threshold precision target
+	S.setTheta ( start );
+	post = S.sampleToPrecision ( 0, 0.05, cuts, 500, 20000, &diag );
+	failures += T->conditional ( diag.getMCSE(3)<=0.05 && post.getNsamples()<20000, "Precision target monte carlo standard error of thresholds reached" );
+
+	// The budget limits impossible targets
+	S.setDiagnostics ( false );
+	post = S.sampleToPrecision ( 1e6, 0, cuts, 300, 1000 );
+	failures += T->isequal ( post.getNsamples(), 1000, "Precision target budget" );
+	failures += T->conditional ( !S.getDiagnostics(), "Precision target keeps the diagnostics setting" );
+
+	delete pmf;
+	delete data;
+
+	return failures;
+}
+
+/* two well separated gaussian modes at -3 and 3 */
+class BimodalPrior : public PsiPrior
+{
+	public:
+		double pdf ( double x ) const { return ( exp ( -(x+3)*(x+3)/0.5 ) + exp ( -(x-3)*(x-3)/0.5 ) )/(2*sqrt(M_PI*0.5)); }
+		PsiPrior * clone ( void ) const { return new BimodalPrior ( *this ); }
+};
+
+int ParallelTemperingTest ( TestSuite * T ) {
+	int failures ( 0 );
+	unsigned int i, k, N ( 20000 ), above;
+	bool equal;
+	std::vector<double> x ( 2 ), start ( 4 ), steps ( 4 );
+	std::vector<int>    n ( 2, 4 );
+	std::vector<int>    kc ( 2 );
+
+	// The posterior is symmetric under a -> -a with gamma and lambda exchanged, thus half of the mass is at a>0
+	x[0] = -3; x[1] = 3;
+	kc[0] = 1; kc[1] = 3;
+	PsiData * data = new PsiData ( x, n, kc, 1 );
+	PsiPsychometric * pmf = new PsiPsychometric ( 1, new abCore(), new PsiLogistic() );
+	PsiPrior * prior = new BimodalPrior ();
+	pmf->setPrior ( 0, prior );
+	delete prior;
+	prior = new GammaPrior ( 2, 1 );
+	pmf->setPrior ( 1, prior );
+	delete prior;
+	prior = new UniformPrior ( 0, .1 );
+	pmf->setPrior ( 2, prior );
+	pmf->setPrior ( 3, prior );
+	delete prior;
+
+	start[0] = 3; start[1] = 2; start[2] = .05; start[3] = .05;
+	steps[0] = .5; steps[1] = .5; steps[2] = .02; steps[3] = .02;
+
+	// A single chain stays in the mode it starts in
+	PsiRandomEngine mhengine ( 5 );
+	GaussRandom proposal;
+	MetropolisHastings mh ( pmf, data, &proposal );
+	mh.setEngine ( &mhengine );
+	mh.setStepSize ( steps );
+	mh.setTheta ( start );
+	mh.setDiagnostics ( false );
+	MCMCList single ( mh.sample ( N ) );
+	for ( i=0, above=0; i<N; i++ )
+		above += single.getEst ( i, 0 )>0;
+	failures += T->isequal ( above, N, "Metropolis Hastings does not leave its mode" );
+
+	// Tempered replicas carry the cold chain between the modes
+	PsiRandomEngine serialengine ( 5 ), parallelengine ( 5 );
+	ParallelTempering serial ( pmf, data, 5, 20, 10, 2000, 1 );
+	ParallelTempering parallel ( pmf, data, 5, 20, 10, 2000, 3 );
+	serial.setEngine ( &serialengine );
+	parallel.setEngine ( &parallelengine );
+	serial.setStepSize ( steps );
+	parallel.setStepSize ( steps );
+	serial.setTheta ( start );
+	parallel.setTheta ( start );
+	serial.setDiagnostics ( false );
+	parallel.setDiagnostics ( false );
+	MCMCList serialpost ( serial.sample ( N ) );
+	MCMCList parallelpost ( parallel.sample ( N ) );
+
+	for ( i=0, above=0; i<N; i++ )
+		above += serialpost.getEst ( i, 0 )>0;
+	failures += T->isequal ( double(above)/N, 0.5, "Parallel tempering visits both modes", .15 );
+
+	equal = true;
+	for ( i=0; i<N; i++ )
+		for ( k=0; k<4; k++ )
+			equal = equal && serialpost.getEst ( i, k )==parallelpost.getEst ( i, k );
+	failures += T->conditional ( equal, "Parallel tempering does not depend on the number of threads" );
+
+	equal = serial.getTemperature ( 0 )==1 && fabs ( serial.getTemperature ( 4 )-20 )<1e-10;
+	for ( k=0; k<4; k++ )
+		equal = equal && serial.getTemperature ( k )<serial.getTemperature ( k+1 ) && serial.getSwapRate ( k )>0.1;
+	failures += T->conditional ( equal, "Parallel tempering ladder is ordered and all neighbours exchange" );
+	failures += T->conditional ( !serial.adapting() && serialpost.get_accept_rate()>0.1 && serialpost.get_accept_rate()<0.5, "Parallel tempering acceptance rate of the cold replica" );
+
+	delete pmf;
+	delete data;
+
+	return failures;
+}
+
+int StreamingStatisticsTest ( TestSuite * T ) {
+	int failures ( 0 );
+	unsigned int i, j, N ( 20000 );
+	std::vector<double> probs ( 3 );
+	probs[0] = 0.025; probs[1] = 0.5; probs[2] = 0.975;
+	PsiRunningStatistics stats ( 2, probs );
+	PsiMClist list ( N, 2 );
+	std::vector<double> x ( 2 );
+	double cov(0);
+
+	for ( i=0; i<N; i++ ) {
+		x[0] = sin ( 0.37*i );
+		x[1] = x[0] + 0.5*cos ( 1.3*i );
+		stats.add ( x );
+		list.setEst ( i, x, 0 );
+	}
+	for ( j=0; j<2; j++ ) {
+		failures += T->isequal ( stats.getMean(j), list.getMean(j), "Running mean", 1e-10 );
+		failures += T->isequal ( stats.getStd(j), list.getStd(j), "Running standard deviation", 1e-10 );
+		for ( i=0; i<3; i++ )
+			failures += T->isequal ( stats.getQuantile(j,i), list.getPercentile(probs[i],j), "P2 quantile", 1e-2 );
+	}
+	for ( i=0; i<N; i++ )
+		cov += (list.getEst(i,0)-list.getMean(0))*(list.getEst(i,1)-list.getMean(1));
+	failures += T->isequal ( stats.getCov(0,1), cov/(N-1), "Running covariance", 1e-10 );
+	failures += T->isequal ( stats.getCov(0,1), stats.getCov(1,0), "Running covariance symmetric", 1e-12 );
+
+	// Summaries of a sampler
+	x = std::vector<double> ( 6 );
+	std::vector<int> n ( 6, 50 ), k ( 6 );
+	x[0] =  0.; x[1] =  2.; x[2] =  4.; x[3] =  6.; x[4] =  8.; x[5] = 10.;
+	k[0] = 24;  k[1] = 32;  k[2] = 40;  k[3] = 48;  k[4] = 50;  k[5] = 48;
+	PsiData * data = new PsiData ( x, n, k, 2 );
+	PsiPsychometric * pmf = new PsiPsychometric ( 2, new abCore(), new PsiLogistic() );
+	PsiPrior * prior = new UniformPrior ( 0, .1 );
+	pmf->setPrior ( 2, prior );
+	delete prior;
+	std::vector<double> cuts ( 1, 0.5 ), theta ( 3 );
+	theta[0] = 3.3; theta[1] = 1.; theta[2] = 0.02;
+
+	setSeed ( 4 );
+	MetropolisHastings S ( pmf, data, new GaussRandom() );
+	S.setStepSize ( 0.3, 0 );
+	S.setStepSize ( 0.3, 1 );
+	S.setStepSize ( 0.01, 2 );
+	S.setTheta ( theta );
+	PsiMCSummary summary ( 3, cuts );
+	S.summarize ( 5000, &summary );
+	MCMCList post ( S.sample ( 5000 ) );
+	failures += T->conditional ( summary.getN()==5000, "Summary sample count" );
+	for ( j=0; j<2; j++ ) {
+		failures += T->isequal ( summary.getEstimates().getMean(j), post.getMean(j), "Summary mean", .1 );
+		failures += T->isequal ( summary.getEstimates().getStd(j), post.getStd(j), "Summary standard deviation", .1 );
+	}
+	failures += T->isequal ( summary.getThresholds().getQuantile(0,1), pmf->getThres(post.getEst(2500),.5), "Summary threshold median", .5 );
+	failures += T->conditional ( summary.getDeviance().getQuantile(0,0)<summary.getDeviance().getQuantile(0,2), "Summary deviance interval" );
+
+	delete pmf;
+	delete data;
+
+	return failures;
+}
+
+int SampleFileTest ( TestSuite * T ) {
+	int failures ( 0 );
+	unsigned int i, j;
+	bool equal;
+	double value;
+	std::vector<double> x ( 6 );
+	std::vector<int> n ( 6, 50 ), k ( 6 );
+	x[0] =  0.; x[1] =  2.; x[2] =  4.; x[3] =  6.; x[4] =  8.; x[5] = 10.;
+	k[0] = 24;  k[1] = 32;  k[2] = 40;  k[3] = 48;  k[4] = 50;  k[5] = 48;
+	PsiData * data = new PsiData ( x, n, k, 2 );
+	PsiPsychometric * pmf = new PsiPsychometric ( 2, new abCore(), new PsiLogistic() );
+	std::vector<double> cuts ( 2 ), theta ( 3 );
+	cuts[0] = 0.25; cuts[1] = 0.75;
+	theta[0] = 3.3; theta[1] = 1.; theta[2] = 0.02;
+	PsiMCFileHeader header;
+	header.model = "ab logistic nafc=2";
+	header.priors.push_back ( "None" );
+	header.priors.push_back ( "None" );
+	header.priors.push_back ( "Uniform(0,.1)" );
+	header.seed = 4;
+	const char * fname ( "tests_all_samples.bin" );
+
+	// MCMC samples
+	setSeed ( 4 );
+	MetropolisHastings S ( pmf, data, new GaussRandom() );
+	S.setStepSize ( 0.3, 0 );
+	S.setStepSize ( 0.3, 1 );
+	S.setStepSize ( 0.01, 2 );
+	S.setTheta ( theta );
+	MCMCList post ( S.sample ( 200 ) );
+	writeMCFile ( fname, post, header, pmf, cuts );
+	{
+		PsiMCFile file ( fname );
+		failures += T->conditional ( file.getVersion()==PSI_MCFILE_VERSION && file.getKind()==MCFILE_MCMC, "mcmc file kind" );
+		failures += T->conditional ( file.getNsamples()==200 && file.getNparams()==3 && file.getNblocks()==6 && file.getNcuts()==2, "mcmc file sizes" );
+		failures += T->conditional ( file.getHeader().model==header.model && file.getHeader().priors==header.priors && file.getHeader().seed==4, "mcmc file header" );
+		equal = true;
+		for ( i=0; i<200; i++ ) {
+			for ( j=0; j<3; j++ )
+				equal = equal && file.getColumn(j)[i]==post.getEst(i,j);
+			for ( j=0; j<6; j++ )
+				equal = equal && file.getDataRow(i)[j]==post.getppData(i,j) && file.getlogratioRow(i)[j]==post.getlogratio(i,j);
+			for ( j=0; j<2; j++ )
+				equal = equal && file.getThresColumn(j)[i]==pmf->getThres(post.getEst(i),cuts[j]);
+			equal = equal && file.getDeviances()[i]==post.getdeviance(i) && file.getppDeviances()[i]==post.getppDeviance(i);
+			// Correlations are undefined (nan) for constant posterior predictive data
+			value = post.getRpd(i);
+			equal = equal && memcmp ( file.getRpd()+i, &value, sizeof(double) )==0;
+			value = post.getppRkd(i);
+			equal = equal && memcmp ( file.getppRkd()+i, &value, sizeof(double) )==0;
+		}
+		failures += T->conditional ( equal, "mcmc file samples" );
+	}
+
+	// Bootstrap samples
+	BootstrapList boots ( bootstrap ( 50, data, pmf, cuts ) );
+	writeMCFile ( fname, boots, header );
+	{
+		PsiMCFile file ( fname );
+		failures += T->conditional ( file.getKind()==MCFILE_BOOTSTRAP && file.getNsamples()==50 && file.getNcuts()==2, "bootstrap file sizes" );
+		failures += T->conditional ( !file.hasSection ( MCFILE_LOGRATIOS ), "bootstrap file has no log ratios" );
+		equal = file.getCuts()[1]==0.75;
+		for ( i=0; i<50; i++ ) {
+			for ( j=0; j<6; j++ )
+				equal = equal && file.getDataRow(i)[j]==boots.getData(i)[j];
+			for ( j=0; j<2; j++ )
+				equal = equal && file.getThresColumn(j)[i]==boots.getThres_byPos(i,j) && file.getSlopeColumn(j)[i]==boots.getSlope_byPos(i,j);
+			equal = equal && file.getColumn(1)[i]==boots.getEst(i,1) && file.getRkd()[i]==boots.getRkd(i);
+		}
+		failures += T->conditional ( equal, "bootstrap file samples" );
+	}
+
+	// Headers that do not match the sections are rejected (here: more samples than stored)
+	FILE * f ( fopen ( fname, "r+b" ) );
+	uint32_t nsamples ( 51 );
+	fseek ( f, 20, SEEK_SET );
+	fwrite ( &nsamples, sizeof(uint32_t), 1, f );
+	fclose ( f );
+	equal = false;
+	try {
+		PsiMCFile file ( fname );
+	} catch ( PsiError& ) {
+		equal = true;
+	}
+	failures += T->conditional ( equal, "sample file with wrong sizes is rejected" );
+
+	// Empty lists
+	writeMCFile ( fname, BootstrapList ( 0, 3, 0, std::vector<double>() ), header );
+	{
+		PsiMCFile file ( fname );
+		failures += T->conditional ( file.getNsamples()==0 && file.getNblocks()==0 && file.getNcuts()==0 && file.hasSection ( MCFILE_CUTS ), "empty bootstrap file" );
+	}
+	unlink ( fname );
+
+	delete pmf;
+	delete data;
+
+	return failures;
+}
+
+int RandomEngineTest ( TestSuite * T ) {
+	int failures ( 0 );
+	unsigned int i;
+	bool equal;
+	double x, m(0), v(0);
+	PsiRandomEngine e1 ( 3 ), e2 ( 3 );
+
+	// Same seed, same sequence
+	equal = true;
+	for ( i=0; i<100; i++ )
+		equal = equal && e1.draw()==e2.draw();
+	failures += T->conditional ( equal, "same seed gives same sequence" );
+	failures += T->conditional ( PsiRandomEngine ( 0 ).int32()==2582404918u, "first number of seed 0" );
+
+	// Streams are obtained by jumping
+	PsiRandomEngine s0 ( 3 ), s1 ( 3, 1 ), jumped ( 3 );
+	jumped.jump();
+	failures += T->conditional ( s0.int32()!=s1.int32(), "different streams differ" );
+	s1 = PsiRandomEngine ( 3, 1 );
+	equal = true;
+	for ( i=0; i<100; i++ )
+		equal = equal && s1.draw()==jumped.draw();
+	failures += T->conditional ( equal, "stream 1 is the jumped stream 0" );
+
+	e1 = PsiRandomEngine ( 3 );
+	e2 = e1.split();
+	s0 = PsiRandomEngine ( 3 );
+	s1 = PsiRandomEngine ( 3, 1 );
+	equal = true;
+	for ( i=0; i<100; i++ )
+		equal = equal && e2.draw()==s0.draw() && e1.draw()==s1.draw();
+	failures += T->conditional ( equal, "split continues the current stream and jumps to the next" );
+
+	// Moments of the uniform distribution
+	for ( i=0; i<100000; i++ ) {
+		x = e1.draw();
+		m += x;
+		v += x*x;
+	}
+	m /= 100000;
+	v = v/100000 - m*m;
+	failures += T->isequal ( m, 0.5, "mean of engine draws", .01 );
+	failures += T->isequal ( v, 1./12, "variance of engine draws", .01 );
+
+	// Generators with an engine do not depend on the global generator
+	PsiRandomEngine g1 ( 7 ), g2 ( 7 );
+	GaussRandom gauss1, gauss2;
+	gauss1.setEngine ( &g1 );
+	gauss2.setEngine ( &g2 );
+	equal = true;
+	for ( i=0; i<10; i++ ) {
+		setSeed ( i );
+		equal = equal && gauss1.draw()==gauss2.draw();
+	}
+	failures += T->conditional ( equal, "GaussRandom with engine is independent of setSeed" );
+
+	// Seeding the global generator
+	PsiRandom global;
+	setSeed ( 0 );
+	for ( i=0; i<25; i++ ) global.rngcall();
+	x = global.rngcall();
+	setSeed ( 25 );
+	failures += T->conditional ( x==global.rngcall(), "compatible seeding skips seedval numbers" );
+	setSeed ( 25, SEED_HASH );
+	x = global.rngcall();
+	setSeed ( 26, SEED_HASH );
+	failures += T->conditional ( x!=global.rngcall(), "hashed seeds give different sequences" );
+	setSeed ( 25, SEED_HASH );
+	failures += T->conditional ( x==global.rngcall(), "hashed seeds are reproducible" );
+	setSeed ( 2000000000L, SEED_HASH );   // would take seconds with skipping
+
+	// Priors forward the engine to their generator
+	g1 = PsiRandomEngine ( 11 );
+	g2 = PsiRandomEngine ( 11 );
+	GammaPrior prior1 ( 2., 3. ), prior2 ( 2., 3. );
+	prior1.setEngine ( &g1 );
+	prior2.setEngine ( &g2 );
+	prior1.shrink ( 1, 2 );
+	prior2.shrink ( 1, 2 );         // shrinking must keep the engine
+	equal = true;
+	for ( i=0; i<10; i++ )
+		equal = equal && prior1.rand()==prior2.rand();
+	failures += T->conditional ( equal, "GammaPrior with engine is reproducible" );
+
+	return failures;
+}
+
+int BinomialTest ( TestSuite * T ) {
+	int failures ( 0 );
+	const unsigned int nsamples ( 20000 );
+	unsigned int i, j, l, df;
+	int k;
+	double m, v, chi2, expected, observed, logpk;
+	char testname[60];
+	int    ntrials[5] = { 10,  50,   500, 2000,  100000 };
+	double probs[5]   = { 0.3, 0.9,  0.6, 0.02,  0.5 };
+	PsiRandomEngine engine ( 1 );
+	BinomialRandom binomial ( 10, 0.5 );
+	binomial.setEngine ( &engine );
+	std::vector<int> counts;
+
+	// Inversion (first two) and BTPE (the others) have to reproduce the binomial distribution
+	for ( j=0; j<5; j++ ) {
+		binomial.setprm ( ntrials[j], probs[j] );
+		counts = std::vector<int> ( ntrials[j]+1, 0 );
+		m = v = 0;
+		for ( i=0; i<nsamples; i++ ) {
+			k = int ( binomial.draw() );
+			counts[k]++;
+			m += k;
+			v += double(k)*k;
+		}
+		m /= nsamples;
+		v = v/nsamples - m*m;
+		sprintf ( testname, "binomial mean n=%d p=%g", ntrials[j], probs[j] );
+		failures += T->isequal_rel ( m, ntrials[j]*probs[j], testname, .01 );
+		sprintf ( testname, "binomial variance n=%d p=%g", ntrials[j], probs[j] );
+		failures += T->isequal_rel ( v, ntrials[j]*probs[j]*(1-probs[j]), testname, .03 );
+
+		// Pearson chi^2 test with cells pooled to an expected count of at least 5
+		chi2 = 0; df = 0;
+		expected = observed = 0;
+		for ( l=0; l<=unsigned(ntrials[j]); l++ ) {
+			logpk = gammaln ( ntrials[j]+1 ) - gammaln ( l+1 ) - gammaln ( ntrials[j]-l+1 )
+				+ l*log(probs[j]) + (ntrials[j]-l)*log(1-probs[j]);
+			expected += nsamples*exp(logpk);
+			observed += counts[l];
+			if ( expected>=5 ) {
+				chi2 += (observed-expected)*(observed-expected)/expected;
+				df++;
+				expected = observed = 0;
+			}
+		}
+		sprintf ( testname, "binomial chi^2 n=%d p=%g", ntrials[j], probs[j] );
+		failures += T->isless ( chi2, df + 4*sqrt(2.*df), testname );
+	}
+
+	// Degenerate cases
+	binomial.setprm ( 20, 0 );
+	failures += T->isequal ( binomial.draw(), 0, "binomial p=0" );
+	binomial.setprm ( 20, 1 );
+	failures += T->isequal ( binomial.draw(), 20, "binomial p=1" );
+
+	return failures;
+}
+
 int PriorTest ( TestSuite * T ) {
 	int failures ( 0 );
 	PsiPrior * prior;
@@ -676,8 +1587,8 @@ int PriorTest ( TestSuite * T ) {
 	failures += T->isequal ( prior->pdf ( .5 ), 1.16009706, "BetaPrior at 0.5" );
 	failures += T->isequal ( prior->pdf ( 1.1 ), 0, "BetaPrior at 1.1" );
 	failures += T->isequal ( prior->dpdf ( -.1 ), 0, "BetaPrior derivative at 0" );
-	failures += T->isequal ( prior->dpdf ( .1 ), 12.14018158, "BetaPrior derivative at 0.1" );
-	failures += T->isequal ( prior->dpdf ( .5 ), 5.80048531, "BetaPrior derivative at 0.5" );
+	failures += T->isequal ( prior->dpdf ( .1 ), 4.66930061, "BetaPrior derivative at 0.1" );
+	failures += T->isequal ( prior->dpdf ( .5 ), -3.48029118, "BetaPrior derivative at 0.5" );
 	failures += T->isequal ( prior->dpdf ( 1.1 ), 0, "BetaPrior derivative at 1.1" );
 	delete prior;
 
@@ -999,6 +1910,51 @@ int CoreTests ( TestSuite * T ) {
 	return failures;
 }
 
+int BatchEvaluationTest ( TestSuite * T ) {
+	int failures(0);
+	unsigned int i,c,s,nafc;
+	bool equal;
+	char message[80];
+	std::vector<double> x ( 6 ), pred;
+	std::vector<int>    n ( 6, 50 );
+	std::vector<int>    k ( 6 );
+	std::vector<double> prm ( 4 );
+
+	x[0] = 0.5; x[1] = 2.; x[2] = 4.; x[3] = 6.; x[4] = 8.; x[5] = 10.;
+	k[0] = 29;  k[1] = 31; k[2] = 36; k[3] = 42; k[4] = 46; k[5] = 49;
+	PsiData * data = new PsiData ( x, n, k, 2 );
+	prm[0] = 4; prm[1] = 1.5; prm[2] = 0.02; prm[3] = 0.1;
+
+	PsiCore * cores[7] = { new abCore, new mwCore ( data, 1, 0.1 ), new linearCore, new logCore ( data ),
+		new weibullCore ( data ), new polyCore ( data ), new NakaRushton ( data ) };
+	PsiSigmoid * sigmoids[7] = { new PsiLogistic, new PsiGauss, new PsiGumbelL, new PsiGumbelR,
+		new PsiCauchy, new PsiExponential, new PsiId };
+
+	// The batch evaluation should give exactly the same values as evaluating block by block
+	for ( c=0; c<7; c++ ) {
+		for ( s=0; s<7; s++ ) {
+			for ( nafc=1; nafc<3; nafc++ ) {
+				PsiPsychometric * pmf = new PsiPsychometric ( nafc, cores[c], sigmoids[s] );
+				pmf->evaluate_batch ( prm, data, &pred );
+				equal = pred.size()==data->getNblocks();
+				for ( i=0; i<data->getNblocks() && equal; i++ )
+					equal = pred[i]==pmf->evaluate ( data->getIntensity(i), prm );
+				sprintf ( message, "batch evaluation core %d, sigmoid %d, nAFC %d", c, s, nafc );
+				failures += T->conditional ( equal, message );
+				delete pmf;
+			}
+		}
+	}
+
+	for ( c=0; c<7; c++ ) {
+		delete cores[c];
+		delete sigmoids[c];
+	}
+	delete data;
+
+	return failures;
+}
+
 int LinalgTests ( TestSuite * T ) {
 	// These tests compare the results with the respective numpy/scipy routines
 	int failures (0);
@@ -1164,6 +2120,9 @@ int GetstartTest ( TestSuite * T ) {
 	failures += T->isequal ( start[2], 0.00185185, "yes-no: Starting value for lambda", 1e-5 );
 	failures += T->isequal ( start[3], 0.0166667, "yes-no: Starting value for gamma", 1e-5 );
 
+	std::vector<double> threadedstart ( getstart ( pmf, data, 7, 3, 3, NULL, 4 ) );
+	failures += T->conditional ( threadedstart==start, "yes-no: Starting value does not depend on number of threads" );
+
 	a_range ( data, &xmin, &xmax );
 	parameter_range ( data, pmf, 0, &ymin, &ymax );
 	failures += T->isequal ( xmin,  0, "yes-no: minimum of alpha range", 1e-5 );
@@ -1322,12 +2281,101 @@ int GetstartTest ( TestSuite * T ) {
 		failures += T->isequal ( (*i_gp)[2], (i%2 == 0 ? .025 : 0.075), txt );
 	}
 
+	// Contiguous grid points
+	std::vector<double> flatpoints;
+	makegridpoints ( grid, &flatpoints );
+	failures += T->isequal ( flatpoints.size(), 24, "Number of values in contiguous gridpoints from 2x2x2 grid" );
+	gridpoints = std::list< std::vector<double> > (0);
+	makegridpoints ( grid, u, 0, &gridpoints );
+	for ( i=0, i_gp=gridpoints.begin(); i_gp!=gridpoints.end(); i_gp++, i++ ) {
+		sprintf ( txt, "contiguous gridpoint %d", i );
+		failures += T->conditional ( std::equal ( i_gp->begin(), i_gp->end(), flatpoints.begin()+3*i ), txt );
+	}
+
+	PsiGridBest best ( 2, 3 );
+	evalgridpoints ( flatpoints, &best, data, pmf, 3 );
+	failures += T->isequal ( best.size(), 2, "Number of best points on contiguous grid" );
+	failures += T->isequal ( best.getL(0), 35.4381, "Best fit on contiguous grid", 1e-4 );
+	failures += T->isequal ( best.getPoint(0)[0], .5,  "Best fitting alpha on contiguous grid" );
+	failures += T->isequal ( best.getPoint(0)[1], .5,  "Best fitting beta on contiguous grid" );
+	failures += T->isequal ( best.getPoint(0)[2], .05, "Best fitting lambda on contiguous grid" );
+	failures += T->conditional ( best.getL(1)>=best.getL(0), "Best points are ordered" );
+	failures += T->conditional ( !best.add ( best.getPoint(0), best.getL(0) ), "Stored point is not stored again" );
+	failures += T->conditional ( !best.add ( &(flatpoints[0]), 1e10 ), "Bad point is not stored" );
+	failures += T->conditional ( best.add ( &(flatpoints[0]), 1. ), "Better point is stored" );
+	failures += T->isequal ( best.getL(0), 1., "Better point is ranked first" );
+	failures += T->isequal ( best.getL(1), 35.4381, "Previously best point is ranked second", 1e-4 );
+
 	delete data;
 	delete pmf;
 
 	return failures;
 }
 
+class SquareJob : public PsiParallelJob
+{
+	public:
+		std::vector<unsigned int> out;
+		std::vector<unsigned int> counts;       // items per thread
+		unsigned int failat;
+		bool stdfailure;
+		SquareJob ( unsigned int n, unsigned int nthreads ) : out ( n, 0 ), counts ( nthreads, 0 ), failat ( n ), stdfailure ( false ) {}
+		void process ( unsigned int item, unsigned int thread ) {
+			if ( item==failat ) {
+				if ( stdfailure )
+					throw std::runtime_error ( "failed item" );
+				throw BadArgumentError ( "failed item" );
+			}
+			out[item] = item*item;
+			counts[thread]++;
+		}
+};
+
+int ParallelJobTest ( TestSuite * T ) {
+	int failures ( 0 );
+	unsigned int i, nthreads, total;
+	bool correct;
+	const char * message;
+
+	for ( nthreads=1; nthreads<=4; nthreads+=3 ) {
+		SquareJob job ( 1000, nthreads );
+		run_parallel ( &job, 1000, nthreads );
+		correct = true;
+		for ( i=0; i<1000; i++ )
+			correct = correct && job.out[i]==i*i;
+		for ( i=0, total=0; i<nthreads; i++ )
+			total += job.counts[i];
+		failures += T->conditional ( correct && total==1000, "every item is processed once" );
+	}
+
+	// Errors keep their type and stop the handout of further items
+	for ( nthreads=1; nthreads<=4; nthreads+=3 ) {
+		SquareJob job ( 1000, nthreads );
+		job.failat = 10;
+		message = NULL;
+		try {
+			run_parallel ( &job, 1000, nthreads );
+		} catch ( BadArgumentError& e ) {
+			message = e.message;
+		}
+		failures += T->conditional ( message!=NULL && strcmp ( message, "failed item" )==0, "worker error is rethrown with its type" );
+		for ( i=0, total=0; i<nthreads; i++ )
+			total += job.counts[i];
+		failures += T->conditional ( total<1000, "no further items after an error" );
+
+		job.stdfailure = true;
+		message = NULL;
+		try {
+			run_parallel ( &job, 1000, nthreads );
+		} catch ( std::runtime_error& ) {
+			message = "caught";
+		}
+		failures += T->conditional ( message!=NULL, "standard exceptions cross the thread boundary" );
+	}
+
+	return failures;
+}
+
 int IntegrateTest ( TestSuite * T ) {
 	int failures (0);
 	unsigned int i;
@@ -1450,6 +2498,45 @@ int IntegrateTest ( TestSuite * T ) {
 	//failures += T->isequal ( samples.getdeviance ( 0 )!= 0, true, "Deviance is set" );
 	//failures += T->isequal ( samples.getppDeviance ( 0 )!= 0, true, "ppDeviance is set" );
 
+	// Parallel evaluation of the posterior
+	std::vector<double> prm ( 6 ), L;
+	prm[0] = 4; prm[1] = 3; prm[2] = 0.02;
+	prm[3] = 3; prm[4] = 5; prm[5] = 0.05;
+	neglpost_parallel ( pmf, data, prm, &L, 2 );
+	failures += T->isequal ( L.size(), 2, "neglpost_parallel number of results" );
+	failures += T->isequal ( L[1], pmf->neglpost ( std::vector<double> ( prm.begin()+3, prm.end() ), data ), "neglpost_parallel value", 1e-10 );
+
+	// Fixed and adaptive grids for the marginals
+	PsiIndependentPosterior fixedposterior ( independent_marginals ( pmf, data, OPTIMIZER_SIMPLEX, 50, 0 ) );
+	PsiIndependentPosterior adaptiveposterior ( independent_marginals ( pmf, data, OPTIMIZER_SIMPLEX, 50, 0.01 ) );
+	PsiIndependentPosterior threadedposterior ( independent_marginals ( pmf, data, OPTIMIZER_SIMPLEX, 50, 0.01, 3 ) );
+	bool increasing ( true );
+	for ( i=0; i<3; i++ ) {
+		std::vector<double> grid ( adaptiveposterior.get_grid ( i ) );
+		failures += T->isequal ( fixedposterior.get_grid ( i ).size(), 50, "Fixed grid size" );
+		failures += T->conditional ( grid.size()>50 && grid.size()<=500, "Adaptive grid is refined" );
+		for ( unsigned int j=1; j<grid.size(); j++ )
+			increasing = increasing && grid[j]>grid[j-1];
+		failures += T->conditional ( grid==threadedposterior.get_grid ( i ) && adaptiveposterior.get_margin ( i )==threadedposterior.get_margin ( i ),
+				"Adaptive grid does not depend on number of threads" );
+	}
+	failures += T->conditional ( increasing, "Adaptive grid points are increasing" );
+	failures += T->isequal ( adaptiveposterior.get_posterior ( 0 )->getprm ( 0 ), fixedposterior.get_posterior ( 0 )->getprm ( 0 ),
+			"Fixed and adaptive grids agree on the posterior for m", .1 );
+
+	// Sampling importance resampling
+	PsiRandomEngine sirengine1 ( 42 ), sirengine4 ( 42 );
+	MCMCList sirsamples ( sample_posterior ( pmf, data, adaptiveposterior, 600, 25, 1, &sirengine1 ) );
+	MCMCList threadedsirsamples ( sample_posterior ( pmf, data, adaptiveposterior, 600, 25, 4, &sirengine4 ) );
+	bool sameestimates ( true );
+	for ( i=0; i<600; i++ )
+		for ( unsigned int j=0; j<3; j++ )
+			sameestimates = sameestimates && sirsamples.getEst ( i, j )==threadedsirsamples.getEst ( i, j );
+	failures += T->conditional ( sameestimates, "SIR samples do not depend on number of threads" );
+	failures += T->conditional ( sirsamples.get_ess()>1 && sirsamples.get_ess()<=600*25, "SIR effective sample size is in range" );
+	failures += T->conditional ( sirsamples.get_entropy()>0 && sirsamples.get_entropy()<=1, "SIR entropy is in range" );
+	failures += T->isequal ( sirsamples.getMean ( 0 ), adaptiveposterior.get_posterior ( 0 )->getprm ( 0 ), "Sampled and fitted posterior mean for m", .2 );
+
 	/*  This is if you want to get the fits to plot them with gnuplot
 	double x;
 	unsigned int myprm ( 0 );
@@ -1487,14 +2574,25 @@ int main ( int argc, char ** argv ) {
 	Tests.addTest(&DerivativeCheck,       "Derivaties of elements" );
 	Tests.addTest(&OptimizerSolution,     "Solutions of optimizer");
 	Tests.addTest(&BootstrapTest,         "Bootstrap properties");
+	Tests.addTest(&ParallelBootstrapTest, "Multithreaded bootstrap");
 	Tests.addTest(&SigmoidTests,          "Properties of sigmoids");
 	Tests.addTest(&CoreTests,             "Tests of core objects");
+	Tests.addTest(&BatchEvaluationTest,   "Batch evaluation of the psychometric function");
 	Tests.addTest(&MCMCTest,              "MCMC");
+	Tests.addTest(&MultiChainTest,        "Multiple MCMC chains");
+	Tests.addTest(&ConvergenceTest,       "Convergence diagnostics");
+	Tests.addTest(&PrecisionTargetTest,   "Sampling to a precision target");
+	Tests.addTest(&ParallelTemperingTest, "Parallel tempering");
+	Tests.addTest(&StreamingStatisticsTest, "Streaming summary statistics");
+	Tests.addTest(&SampleFileTest,        "Binary sample files");
 	Tests.addTest(&PriorTest,             "Priors");
+	Tests.addTest(&RandomEngineTest,      "Random number engines");
+	Tests.addTest(&BinomialTest,          "Binomial random numbers");
 	Tests.addTest(&LinalgTests,           "Linear algebra routines");
 	Tests.addTest(&ReturnTest,            "Testing return bug in jackknifedata");
 	Tests.addTest(&InitialParametersTest, "Initial parameter heuristics" );
 	Tests.addTest(&GetstartTest,          "Finding good starting values" );
+	Tests.addTest(&ParallelJobTest,       "Parallel processing of independent items" );
 	Tests.addTest ( &IntegrateTest,        "Approximate numerical integration" );
 
 	int failed = Tests.runTests();
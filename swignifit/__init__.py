@@ -10,5 +10,14 @@
 
 from interface_methods import bootstrap, mcmc, mapestimate, diagnostics, asir
 
-def set_seed(value):
-    swignifit_raw.setSeed(value)
+def set_seed(value, hashed=False):
+    """ seed the global random number generator
+
+    With hashed=True, the seed is part of the initialization key and seeding
+    takes constant time. Otherwise the sequences of earlier versions are
+    reproduced, which takes time linear in the seed.
+    """
+    if hashed:
+        swignifit_raw.setSeed(value, swignifit_raw.SEED_HASH)
+    else:
+        swignifit_raw.setSeed(value, swignifit_raw.SEED_SKIP)
@@ -691,13 +691,15 @@ def diagnostics(data, params, nafc=2, sigmoid='logistic', core='ab', cuts=None,
         return predicted, deviance_residuals, deviance, thres, slope, rpd, rkd
 
 def asir ( data, nsamples=2000, nafc=2, sigmoid="logistic",
-        core="mw0.1", priors=None, gammaislambda=False, propose=25 ):
+        core="mw0.1", priors=None, gammaislambda=False, propose=25,
+        gridsize=100, tolerance=0, nthreads=1 ):
     dataset, pmf, nparams = sfu.make_dataset_and_pmf ( data, nafc, sigmoid, core, priors, gammaislambda=gammaislambda )
 
-    posterior = sfr.independent_marginals ( pmf, dataset )
+    # gridsize points per parameter, with tolerance>0 intervals with more than tolerance of the mass are refined
+    posterior = sfr.independent_marginals ( pmf, dataset, sfr.OPTIMIZER_SIMPLEX, gridsize, tolerance, nthreads )
     if nsamples > 0:
-        samples   = sfr.sample_posterior ( pmf, dataset, posterior, nsamples, propose )
-        sfr.sample_diagnostics ( pmf, dataset, samples )
+        samples   = sfr.sample_posterior ( pmf, dataset, posterior, nsamples, propose, nthreads )
+        sfr.sample_diagnostics ( pmf, dataset, samples, nthreads )
 
         out = {'mcestimates': np.array( [ [samples.getEst ( i, par ) for par in xrange ( nparams ) ] for i in xrange ( nsamples )]),
             'mcdeviance': np.array( [ samples.getdeviance ( i ) for i in xrange ( nsamples ) ] ),
@@ -715,7 +717,8 @@ def asir ( data, nsamples=2000, nafc=2, sigmoid="logistic",
                 r"$\mathrm{Beta}(%.2f,%.2f)$" % (posterior.get_posterior(2).getprm(0),posterior.get_posterior(2).getprm(1))],
             'posterior_grids':          [ posterior.get_grid ( i ) for i in xrange ( nparams ) ],
             'posterior_margin':         [ posterior.get_margin ( i ) for i in xrange ( nparams ) ],
-            'resampling-entropy':       samples.get_entropy ()
+            'resampling-entropy':       samples.get_entropy (),
+            'resampling-ess':           samples.get_ess ()
             }
 
     else:
@@ -731,3 +734,27 @@ def asir ( data, nsamples=2000, nafc=2, sigmoid="logistic",
         out['posterior_approximations_str'].append ( r"$\mathrm{Beta}(%.2f,%.2f)$" % (posterior.get_posterior(3).getprm(0),posterior.get_posterior(3).getprm(1)) )
 
     return out
+
+def chain_diagnostics ( samples, nchains=1, maxlag=100 ):
+    """Convergence diagnostics for every column of an array of mcmc samples
+
+    samples are stored chain after chain, nchains chains of equal length. The
+    result contains the effective sample sizes (of the mean, of the bulk and of
+    the tails), the monte carlo standard errors, Geweke z-scores (one per chain)
+    and autocorrelations up to maxlag for every column.
+    """
+    samples = np.asarray ( samples, dtype=float )
+    if samples.ndim == 1:
+        samples = samples.reshape ( (-1,1) )
+    nvariables = samples.shape[1]
+    diag = sfr.PsiChainDiagnostics ( nchains, maxlag )
+    for j in xrange ( nvariables ):
+        diag.addVariable ( sfr.vector_double ( samples[:,j] ) )
+    nlags = min ( maxlag+1, samples.shape[0]/nchains )
+
+    return {'ess':             np.array ( [ diag.getESS ( j ) for j in xrange ( nvariables ) ] ),
+            'bulk-ess':        np.array ( [ diag.getBulkESS ( j ) for j in xrange ( nvariables ) ] ),
+            'tail-ess':        np.array ( [ diag.getTailESS ( j ) for j in xrange ( nvariables ) ] ),
+            'mcse':            np.array ( [ diag.getMCSE ( j ) for j in xrange ( nvariables ) ] ),
+            'geweke':          np.array ( [ [ diag.getGeweke ( j, m ) for m in xrange ( nchains ) ] for j in xrange ( nvariables ) ] ),
+            'autocorrelation': np.array ( [ [ diag.getAutocorrelation ( j, t ) for t in xrange ( nlags ) ] for j in xrange ( nvariables ) ] ) }
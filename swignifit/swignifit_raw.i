@@ -52,6 +52,9 @@ namespace std {
 
 %include "std_string.i"
 
+// fixed width integers are used by PsiRandomEngine
+%include "stdint.i"
+
 // we need to ignore the second constructor for PsiData since swig can't handle
 // this type of overloading TODO write a factory method in python that
 // implements this functionality
@@ -60,6 +63,9 @@ namespace std {
                           std::vector<double> p,
                           int nAFC);
 
+// the vector version of addVariable is sufficient
+%ignore PsiChainDiagnostics::addVariable ( const double * draws, unsigned int n );
+
 // We wrap the following headers
 %include "data.h"
 %include "sigmoid.h"
@@ -74,3 +80,4 @@ namespace std {
 %include "linalg.h"
 %include "getstart.h"
 %include "integrate.h"
+%include "convergence.h"
@@ -34,7 +34,10 @@ psipp_sources = [
     "src/linalg.cc",
     "src/getstart.cc",
     "src/prior.cc",
-    "src/integrate.cc"]
+    "src/integrate.cc",
+    "src/mcfile.cc",
+    "src/convergence.cc",
+    "src/parallel.cc"]
 
 # swignifit interface, override the definition in `setup.py`
 swignifit = Extension('swignifit._swignifit_raw',